@@ -0,0 +1,296 @@
+#include <engine/ao.hpp>
+#include <engine/bvh.hpp>
+#include <engine/normals.hpp>
+#include <engine/obj.hpp>
+#include <engine/mapped_file.hpp>
+#include <engine/thread_pool.hpp>
+#include <engine/vertex_format.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <charconv>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/vec3.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/ext/vector_int3_sized.hpp>
+
+// Bakes per-vertex ambient occlusion into meshes that have none:
+//     ao-baker [RAYS [THREADS]]
+// practice8/bunny.obj becomes bunny.raw in the layout of
+// practice7/dragon.raw: the vertex and index counts, vertices of a float
+// position, a normalized byte normal and a normalized byte occlusion, then
+// 32-bit indices. practice10/human.bin becomes human_ao.bin, the same file
+// with a normalized byte occlusion and three bytes of padding after every
+// skinned vertex; practice10 draws it instead of human.bin once it is
+// copied next to it. Both are written to the build directory. A synthetic
+// mesh of a million
+// vertices, copies of the bunny, is baked to measure the throughput only.
+// If practice7/dragon.raw is present, it is baked again and compared with
+// its own ao channel.
+
+struct raw_vertex
+{
+	glm::vec3 position;
+	glm::i8vec3 normal;
+	std::uint8_t ao;
+};
+
+static_assert(sizeof(raw_vertex) == 16);
+
+// The vertex of practice10/human.bin
+struct human_vertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	std::uint8_t bone_ids[2];
+	std::uint8_t bone_weights[2];
+};
+
+// The vertex of human_ao.bin
+struct human_ao_vertex
+{
+	human_vertex vertex;
+	std::uint8_t ao;
+	std::uint8_t padding[3];
+};
+
+static_assert(sizeof(human_ao_vertex) == 32);
+
+struct mesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<std::uint32_t> indices;
+};
+
+mesh load_bunny()
+{
+	auto bunny = engine::load_obj(PRACTICE_SOURCE_DIRECTORY "/../practice8/bunny.obj");
+
+	mesh result;
+	result.normals = engine::compute_normals(bunny.indices, bunny.positions);
+	result.positions = std::move(bunny.positions);
+	result.indices = std::move(bunny.indices);
+	return result;
+}
+
+// The skinning data is kept to be written back with the occlusion
+struct human_mesh
+{
+	mesh geometry;
+	std::vector<human_vertex> vertices;
+};
+
+human_mesh load_human()
+{
+	engine::mapped_reader file(PRACTICE_SOURCE_DIRECTORY "/../practice10/human.bin");
+	auto vertex_count = file.read<std::uint32_t>();
+	auto index_count = file.read<std::uint32_t>();
+	auto vertices = file.read_array<human_vertex>(vertex_count);
+	auto indices = file.read_array<std::uint32_t>(index_count);
+	file.expect_end();
+
+	human_mesh result;
+	for (auto const & v : vertices)
+	{
+		result.geometry.positions.push_back(v.position);
+		result.geometry.normals.push_back(v.normal);
+	}
+	result.geometry.indices.assign(indices.begin(), indices.end());
+	result.vertices.assign(vertices.begin(), vertices.end());
+	return result;
+}
+
+mesh make_copies(mesh const & source, std::size_t min_vertices)
+{
+	std::size_t copies = (min_vertices + source.positions.size() - 1) / source.positions.size();
+	std::size_t grid = 1;
+	while (grid * grid < copies)
+		++grid;
+
+	mesh result;
+	for (std::size_t copy = 0; copy < copies; ++copy)
+	{
+		glm::vec3 offset(0.2f * (copy % grid), 0.f, 0.2f * (copy / grid));
+		auto base = static_cast<std::uint32_t>(result.positions.size());
+		for (auto const & p : source.positions)
+			result.positions.push_back(p + offset);
+		result.normals.insert(result.normals.end(), source.normals.begin(), source.normals.end());
+		for (auto index : source.indices)
+			result.indices.push_back(index + base);
+	}
+	return result;
+}
+
+// Length of the diagonal of the bounding box
+float mesh_size(mesh const & m)
+{
+	glm::vec3 min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity());
+	for (auto const & p : m.positions)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	return glm::length(max - min);
+}
+
+// Occluders beyond a quarter of the size of the model hardly darken
+// anything and would make open meshes darker than closed ones
+std::vector<float> bake(std::string const & name, mesh const & m, float model_size, unsigned rays, engine::thread_pool & pool)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	engine::bvh tree(m.indices, m.positions, {.pool = &pool, .wide = true});
+	auto built = std::chrono::high_resolution_clock::now();
+
+	engine::ao_options options;
+	options.rays = rays;
+	options.max_distance = 0.25f * model_size;
+	options.bias = 1e-4f * model_size;
+	options.pool = &pool;
+	auto ao = engine::bake_vertex_ao(tree, m.positions, m.normals, options);
+	auto baked = std::chrono::high_resolution_clock::now();
+
+	std::cout << name << ": BVH built in " << std::fixed << std::setprecision(1)
+		<< std::chrono::duration<double, std::milli>(built - start).count() << " ms, "
+		<< std::defaultfloat << engine::ao_report(ao, rays, std::chrono::duration<double>(baked - built).count()) << std::endl;
+	return ao;
+}
+
+// The vertex and index counts, the vertices, then 32-bit indices
+template <typename Vertex>
+void write_mesh(std::filesystem::path const & path, std::vector<Vertex> const & vertices, std::vector<std::uint32_t> const & indices)
+{
+	std::ofstream output(path, std::ios::binary);
+	auto vertex_count = static_cast<std::uint32_t>(vertices.size());
+	auto index_count = static_cast<std::uint32_t>(indices.size());
+	output.write(reinterpret_cast<char const *>(&vertex_count), sizeof(vertex_count));
+	output.write(reinterpret_cast<char const *>(&index_count), sizeof(index_count));
+	output.write(reinterpret_cast<char const *>(vertices.data()), vertices.size() * sizeof(Vertex));
+	output.write(reinterpret_cast<char const *>(indices.data()), indices.size() * sizeof(std::uint32_t));
+	if (!output)
+		throw std::runtime_error("Failed to write " + path.string());
+
+	std::cout << "    written to " << path.string() << std::endl;
+}
+
+void write_raw(std::filesystem::path const & path, mesh const & m, std::vector<float> const & ao)
+{
+	std::vector<raw_vertex> vertices(m.positions.size());
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		vertices[i].position = m.positions[i];
+		vertices[i].normal = glm::i8vec3(glm::round(glm::clamp(glm::normalize(m.normals[i]), -1.f, 1.f) * 127.f));
+		vertices[i].ao = engine::encode_unorm<std::uint8_t>(ao[i]);
+	}
+	write_mesh(path, vertices, m.indices);
+}
+
+void write_human(std::filesystem::path const & path, human_mesh const & human, std::vector<float> const & ao)
+{
+	std::vector<human_ao_vertex> vertices(human.vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		vertices[i].vertex = human.vertices[i];
+		vertices[i].ao = engine::encode_unorm<std::uint8_t>(ao[i]);
+	}
+	write_mesh(path, vertices, human.geometry.indices);
+}
+
+// Bakes the dragon again and compares the result with the occlusion it
+// was shipped with
+void compare_dragon(std::filesystem::path const & path, unsigned rays, engine::thread_pool & pool)
+{
+	if (!std::filesystem::exists(path))
+	{
+		std::cout << path.string() << " not found, not compared" << std::endl;
+		return;
+	}
+
+	engine::mapped_reader file(path);
+	auto vertex_count = file.read<std::uint32_t>();
+	auto index_count = file.read<std::uint32_t>();
+	auto vertices = file.read_array<raw_vertex>(vertex_count);
+	auto indices = file.read_array<std::uint32_t>(index_count);
+	file.expect_end();
+
+	mesh dragon;
+	for (auto const & v : vertices)
+	{
+		dragon.positions.push_back(v.position);
+		dragon.normals.push_back(glm::vec3(v.normal) / 127.f);
+	}
+	dragon.indices.assign(indices.begin(), indices.end());
+
+	auto ao = bake("dragon", dragon, mesh_size(dragon), rays, pool);
+
+	// Mean difference and correlation with the shipped channel
+	double sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0, difference = 0.0;
+	for (std::size_t i = 0; i < vertex_count; ++i)
+	{
+		double a = engine::decode_unorm(engine::encode_unorm<std::uint8_t>(ao[i]));
+		double b = engine::decode_unorm(vertices[i].ao);
+		sum_a += a;
+		sum_b += b;
+		sum_aa += a * a;
+		sum_bb += b * b;
+		sum_ab += a * b;
+		difference += std::abs(a - b);
+	}
+	double n = std::max<double>(vertex_count, 1);
+	double covariance = sum_ab / n - sum_a / n * sum_b / n;
+	double deviations = std::sqrt((sum_aa / n - sum_a / n * sum_a / n) * (sum_bb / n - sum_b / n * sum_b / n));
+
+	std::cout << std::fixed << std::setprecision(3) << "    shipped mean AO " << sum_b / n << ", baked " << sum_a / n << ", mean difference "
+		<< difference / n << ", correlation " << (deviations > 0.0 ? covariance / deviations : 0.0) << std::endl;
+}
+
+int main(int argc, char ** argv) try
+{
+	auto positive_argument = [&](int index, unsigned & value)
+	{
+		std::string_view arg = argv[index];
+		auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+		if (error != std::errc{} || end != arg.data() + arg.size() || value == 0)
+			throw std::runtime_error("Usage: ao-baker [RAYS [THREADS]]");
+	};
+
+	unsigned rays = 64;
+	if (argc > 1)
+		positive_argument(1, rays);
+
+	unsigned threads = 0;
+	if (argc > 2)
+		positive_argument(2, threads);
+
+	engine::thread_pool pool(threads);
+	std::cout << "Baking with " << rays << " rays per vertex on " << pool.size() << " threads" << std::endl;
+
+	std::filesystem::path output = PRACTICE_BINARY_DIRECTORY;
+
+	auto bunny = load_bunny();
+	write_raw(output / "bunny.raw", bunny, bake("bunny", bunny, mesh_size(bunny), rays, pool));
+
+	auto human = load_human();
+	write_human(output / "human_ao.bin", human, bake("human", human.geometry, mesh_size(human.geometry), rays, pool));
+
+	// Every copy is baked as if alone, apart from its neighbours in the grid
+	bake("bunny copies", make_copies(bunny, 1000000), mesh_size(bunny), rays, pool);
+
+	compare_dragon(PRACTICE_SOURCE_DIRECTORY "/../practice7/dragon.raw", rays, pool);
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
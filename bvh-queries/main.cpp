@@ -0,0 +1,211 @@
+#include <engine/bvh.hpp>
+#include <engine/obj.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <charconv>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+// Builds engine::bvh over bunny.obj and over a synthetic mesh made of
+// many translated copies of it, and traces rays through both:
+//     bvh-queries [COPIES [THREADS]]
+// Every mesh is built as a binary and as a four-wide tree, on one thread
+// and on THREADS threads (by default one per hardware thread), and the
+// build time is reported. Primary rays are then shot through every pixel
+// of a 512x512 view of the mesh for the closest hit, and from every
+// primary hit a short ray in a random direction above the surface is
+// tested for any hit, as an ambient occlusion baker would. The binary
+// and the four-wide trees have to agree on all of them.
+
+std::size_t const image_size = 512;
+
+engine::obj_mesh make_copies(engine::obj_mesh const & source, unsigned copies)
+{
+	unsigned grid = 1;
+	while (grid * grid < copies)
+		++grid;
+
+	engine::obj_mesh result;
+	for (unsigned copy = 0; copy < copies; ++copy)
+	{
+		glm::vec3 offset(0.2f * (copy % grid), 0.f, 0.2f * (copy / grid));
+		auto base = static_cast<std::uint32_t>(result.positions.size());
+		for (auto const & p : source.positions)
+			result.positions.push_back(p + offset);
+		for (auto index : source.indices)
+			result.indices.push_back(index + base);
+	}
+	return result;
+}
+
+// Best of a few runs
+double time_ms(std::function<void()> const & task, int runs)
+{
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		task();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (run == 0 || ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+struct ray_sets
+{
+	std::vector<engine::ray> primary;
+	std::vector<engine::ray> ambient;
+};
+
+// Primary rays from a camera above the mesh looking at its center, and
+// the ambient rays from their hits, found with the given tree
+ray_sets make_rays(engine::obj_mesh const & mesh, engine::bvh const & tree)
+{
+	glm::vec3 min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity());
+	for (auto const & p : mesh.positions)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	auto center = (min + max) * 0.5f;
+	float size = glm::length(max - min);
+
+	auto view = glm::lookAt(center + glm::vec3(0.4f, 0.5f, 0.6f) * size, center, {0.f, 1.f, 0.f});
+	auto projection = glm::perspective(glm::pi<float>() / 3.f, 1.f, 0.01f * size, 10.f * size);
+
+	ray_sets result;
+	for (std::size_t y = 0; y < image_size; ++y)
+		for (std::size_t x = 0; x < image_size; ++x)
+			result.primary.push_back(engine::screen_ray(projection, view, x, y, image_size, image_size));
+
+	std::vector<engine::ray_hit> hits(result.primary.size());
+	tree.closest_hit(result.primary, hits);
+
+	std::mt19937 random(42);
+	std::normal_distribution<float> normal_distribution;
+	for (std::size_t i = 0; i < hits.size(); ++i)
+	{
+		if (!hits[i])
+			continue;
+
+		auto const & r = result.primary[i];
+		auto const * triangle = &mesh.indices[3 * hits[i].triangle];
+		auto const & p0 = mesh.positions[triangle[0]];
+		auto n = glm::normalize(glm::cross(mesh.positions[triangle[1]] - p0, mesh.positions[triangle[2]] - p0));
+		if (glm::dot(n, r.direction) > 0.f)
+			n = -n;
+
+		glm::vec3 direction(normal_distribution(random), normal_distribution(random), normal_distribution(random));
+		direction = glm::normalize(direction);
+		if (glm::dot(direction, n) < 0.f)
+			direction = -direction;
+
+		// A tenth of a bunny around the hit
+		result.ambient.push_back({r.origin + r.direction * hits[i].t, direction, 1e-4f, 0.02f});
+	}
+
+	return result;
+}
+
+void run(std::string const & name, engine::obj_mesh const & mesh, unsigned max_threads, int runs)
+{
+	engine::thread_pool pool(max_threads);
+
+	std::cout << name << ": " << mesh.positions.size() << " vertices, " << mesh.indices.size() / 3 << " triangles" << std::endl;
+
+	ray_sets rays;
+	std::vector<engine::ray_hit> reference_hits;
+	std::vector<std::uint8_t> reference_occluded;
+
+	std::cout << std::left << std::setw(10) << "layout" << std::right << std::setw(10) << "threads"
+		<< std::setw(12) << "build ms" << std::setw(18) << "primary Mrays/s" << std::setw(18) << "ambient Mrays/s" << std::endl;
+
+	for (bool wide : {false, true})
+		for (engine::thread_pool * threads : {static_cast<engine::thread_pool *>(nullptr), &pool})
+		{
+			engine::bvh tree;
+			double build_ms = time_ms([&]{ tree = engine::bvh(mesh.indices, mesh.positions, {.pool = threads, .wide = wide}); }, runs);
+
+			if (rays.primary.empty())
+			{
+				std::cout << "    " << engine::bvh_report(tree) << std::endl;
+				rays = make_rays(mesh, tree);
+			}
+
+			std::vector<engine::ray_hit> hits(rays.primary.size());
+			std::vector<std::uint8_t> occluded(rays.ambient.size());
+			double primary_ms = time_ms([&]{ tree.closest_hit(rays.primary, hits, threads); }, runs);
+			double ambient_ms = time_ms([&]{ tree.any_hit(rays.ambient, occluded, threads); }, runs);
+
+			if (reference_hits.empty())
+			{
+				reference_hits = hits;
+				reference_occluded = occluded;
+			}
+			for (std::size_t i = 0; i < hits.size(); ++i)
+				if (bool(hits[i]) != bool(reference_hits[i]) || std::abs(hits[i].t - reference_hits[i].t) > 1e-6f * hits[i].t)
+					throw std::runtime_error("Trees disagree on primary ray " + std::to_string(i) + " of " + name);
+			if (occluded != reference_occluded)
+				throw std::runtime_error("Trees disagree on the ambient rays of " + name);
+
+			std::cout << std::left << std::setw(10) << (wide ? "4-wide" : "binary") << std::right
+				<< std::setw(10) << (threads ? threads->size() : 1u)
+				<< std::setw(12) << std::fixed << std::setprecision(2) << build_ms
+				<< std::setw(18) << rays.primary.size() / primary_ms / 1000.0
+				<< std::setw(18) << rays.ambient.size() / ambient_ms / 1000.0 << std::endl;
+		}
+
+	std::size_t occluded_count = std::count(reference_occluded.begin(), reference_occluded.end(), 1);
+	std::cout << "    " << rays.ambient.size() << " of " << rays.primary.size() << " primary rays hit, "
+		<< std::setprecision(1) << 100.0 * occluded_count / std::max<std::size_t>(rays.ambient.size(), 1)
+		<< "% of the ambient rays occluded" << std::endl;
+}
+
+int main(int argc, char ** argv) try
+{
+	auto positive_argument = [&](int index, unsigned & value)
+	{
+		std::string_view arg = argv[index];
+		auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+		if (error != std::errc{} || end != arg.data() + arg.size() || value == 0)
+			throw std::runtime_error("Usage: bvh-queries [COPIES [THREADS]]");
+	};
+
+	unsigned copies = 100;
+	if (argc > 1)
+		positive_argument(1, copies);
+
+	unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (argc > 2)
+		positive_argument(2, max_threads);
+
+	auto bunny = engine::load_obj(PRACTICE_SOURCE_DIRECTORY "/../practice8/bunny.obj");
+
+	run("bunny", bunny, max_threads, 5);
+	std::cout << std::endl;
+	run("bunny x" + std::to_string(copies), make_copies(bunny, copies), max_threads, 3);
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
@@ -1,35 +1,11 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
 R"(#version 330 core
 
@@ -68,103 +44,29 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
+int main(int argc, char ** argv) try
 {
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
-int main() try
-{
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course easing example",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	engine::application app(argc, argv, {
+		.title = "Graphics course easing example",
+		.multisamples = 4,
+	});
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
 	GLuint view_location = glGetUniformLocation(program, "view");
 	GLuint center_location = glGetUniformLocation(program, "center");
 	GLuint size_location = glGetUniformLocation(program, "size");
 	GLuint color_location = glGetUniformLocation(program, "color");
 
-	GLuint vao;
-	glGenVertexArrays(1, &vao);
-
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
+	engine::vertex_array vao;
 
 	float time = 0.f;
 
-	std::map<SDL_Keycode, bool> button_down;
-
 	int mode = 1;
 	bool moving = false;
 
@@ -173,25 +75,11 @@ int main() try
 	float object_x_end = object_x;
 	float object_animation_time = 0.f;
 
-	bool running = true;
-	while (running)
+	app.on_event([&](SDL_Event const & event)
 	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
+		switch (event.type)
 		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
 		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
 			if (event.key.keysym.sym == SDLK_1)
 				mode = 1;
 			if (event.key.keysym.sym == SDLK_2)
@@ -211,17 +99,15 @@ int main() try
 				moving = true;
 			}
 			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
 		}
+	});
 
-		if (!running)
-			break;
+	float previous_object_x = object_x;
+
+	app.run(1.f / 120.f, [&](float dt)
+	{
+		previous_object_x = object_x;
 
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
 		time += dt;
 
 		object_animation_time += dt;
@@ -261,13 +147,17 @@ int main() try
 				object_x = object_x_start + (object_x_end - object_x_start) * std::sqrt(t);
 			}
 		}
+	},
+	[&](float alpha)
+	{
+		float frame_object_x = previous_object_x + (object_x - previous_object_x) * alpha;
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_DEPTH_TEST);
 
 		float view[16] =
 		{
-			(1.f * height) / width, 0.f, 0.f, 0.f,
+			(1.f * app.height()) / app.width(), 0.f, 0.f, 0.f,
 			0.f, 1.f, 0.f, 0.f,
 			0.f, 0.f, 1.f, 0.f,
 			0.f, 0.f, 0.f, 1.f,
@@ -275,19 +165,14 @@ int main() try
 
 		glUseProgram(program);
 		glUniformMatrix4fv(view_location, 1, GL_TRUE, view);
-		glUniform2f(center_location, object_x, 0.f);
+		glUniform2f(center_location, frame_object_x, 0.f);
 		glUniform1f(size_location, 0.25f);
 		glUniform4f(color_location, 0.f, 0.5f, 0.f, 1.f);
 
 		glBindVertexArray(vao);
 
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	});
 }
 catch (std::exception const & e)
 {
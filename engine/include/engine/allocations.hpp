@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace engine
+{
+
+// Number of global operator new calls since startup. Counting replaces
+// the global allocation functions and is only compiled in with the
+// ENGINE_COUNT_ALLOCATIONS CMake option; without it this returns 0 and
+// allocation_counting() is false.
+std::uint64_t allocation_count();
+bool allocation_counting();
+
+}
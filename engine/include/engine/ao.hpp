@@ -0,0 +1,45 @@
+#pragma once
+
+#include <engine/bvh.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+class thread_pool;
+
+struct ao_options
+{
+	std::size_t rays = 64;
+	// Occluders farther from the vertex do not count, in the units of the
+	// mesh; a fraction of its size keeps open meshes from turning dark
+	// because of distant geometry
+	float max_distance = std::numeric_limits<float>::infinity();
+	// Rays start this far above the surface along the normal, in the
+	// units of the mesh, so that they miss the triangles of the vertex
+	float bias = 1e-4f;
+	// Bakes the vertices in parallel if set
+	thread_pool * pool = nullptr;
+};
+
+// Ambient occlusion of every vertex: the fraction of rays that leave the
+// mesh, 1 for a fully open vertex. The rays are cosine-distributed over
+// the hemisphere around the normal, so the fraction is the cosine-weighted
+// visibility that multiplies the ambient light. All vertices use the same
+// stratified (Hammersley) set of directions, rotated by a per-vertex
+// offset, which trades banding for noise at low ray counts.
+std::vector<float> bake_vertex_ao(bvh const & tree, std::span<glm::vec3 const> positions,
+	std::span<glm::vec3 const> normals, ao_options const & options = {});
+
+// One line with the rays traced, their rate and the resulting occlusion
+std::string ao_report(std::span<float const> ao, std::size_t rays_per_vertex, double seconds);
+
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <engine/sdl.hpp>
+#include <engine/program_cache.hpp>
+#include <engine/uniforms.hpp>
+#include <engine/headless.hpp>
+#include <engine/profiler.hpp>
+#include <engine/session.hpp>
+#include <engine/input.hpp>
+#include <engine/state.hpp>
+#include <engine/uniform_ring.hpp>
+#include <engine/assets.hpp>
+#include <engine/meshlet.hpp>
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+struct application_config
+{
+	std::string title = "Graphics course practice";
+	// Initial window size, or the fixed resolution in headless mode
+	int width = 800;
+	int height = 600;
+	// Number of MSAA samples of the default framebuffer, 0 disables multisampling
+	int multisamples = 0;
+	bool vsync = true;
+	// Reuse linked program binaries across launches, see program_cache
+	bool program_cache = true;
+	// Print per-frame statistics every that many seconds, 0 disables
+	float report_interval = 0.f;
+	// Render offscreen without a window, see headless_context
+	bool headless = false;
+	// Number of frames rendered in headless mode before exiting
+	int frames = 100;
+	// Enable the frame profiler; its summary is printed with the other
+	// statistics, every report_interval seconds or at the end of a headless run
+	bool profile = false;
+	// chrome://tracing / Perfetto JSON output of the profiler, implies profile
+	std::string trace;
+	// Bytes of per-frame uniform data streamed through a uniform_ring,
+	// 0 means the demo does not use one
+	std::size_t uniform_buffer_size = 0;
+	// Worker threads of the asset manager (0 picks a default) and the GL
+	// thread time per frame it may spend uploading finished assets
+	unsigned asset_threads = 0;
+	float asset_upload_budget_ms = 2.f;
+	// Upload assets on a second, shared context of their own thread where
+	// the platform allows it, see shared_context; the budget then only
+	// applies to the fallback
+	bool upload_context = true;
+	// Upload every requested asset before the frame that follows the
+	// request, for runs that have to render the same frames every time
+	bool wait_for_assets = false;
+	// Input session files, see session_writer and session_reader
+	std::string record;
+	std::string replay;
+};
+
+// Owns the SDL window with an OpenGL 3.3 core context and runs the frame
+// loop shared by all demos: event polling, viewport updates on resize,
+// frame timing and buffer swaps.
+//
+// In headless mode there is no window and no events: a fixed number of
+// frames with a fixed dt is rendered into an offscreen framebuffer and
+// the frame time statistics are printed on exit.
+//
+// A recorded session replaces the live input and the frame times, in
+// headless mode the whole session is replayed regardless of --frames.
+class application
+{
+public:
+	explicit application(application_config const & config);
+
+	// Applies the command line on top of the config:
+	//     --headless        render offscreen
+	//     --frames N        number of headless frames
+	//     --size WxH        window size or headless resolution
+	//     --profile         enable the frame profiler
+	//     --trace FILE      enable the profiler and write a trace
+	//     --record FILE     record the input session
+	//     --replay FILE     replay a recorded input session
+	//     --wait-assets     finish loading assets before rendering
+	//     --no-upload-context  upload assets on the render thread
+	application(int argc, char ** argv, application_config config);
+
+	~application();
+
+	application(application const &) = delete;
+	application & operator = (application const &) = delete;
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+	// nullptr in headless mode
+	SDL_Window * window() const { return window_; }
+
+	bool headless() const { return static_cast<bool>(headless_); }
+
+	// Keyboard and mouse state of the current frame, updated before the
+	// frame callback; replayed sessions drive it like live input
+	input_state const & input() const { return input_; }
+	input_state & input() { return input_; }
+
+	// GL state cache for the frame loop, see gl_state
+	gl_state & state() { return state_; }
+
+	// Requires a non-zero uniform_buffer_size in the config
+	uniform_ring & uniform_buffer();
+
+	// Background asset loading, see asset_manager; the workers and the
+	// upload context are created on first use. Finished assets are
+	// published (or uploaded, without an upload context) before every frame.
+	asset_manager & assets();
+
+	// Scopes can be profiled regardless of whether profiling is enabled,
+	// they cost nothing when it is not
+	frame_profiler & profiler() { return profiler_; }
+
+	// The framebuffer that is presented, use it instead of 0 when
+	// binding the default framebuffer
+	GLuint framebuffer() const { return headless_ ? headless_->framebuffer() : 0; }
+
+	// Pass to engine::program to load and store program binaries;
+	// nullptr if the cache is disabled
+	engine::program_cache * programs() const { return program_cache_.get(); }
+
+	// Receives every polled event after the loop itself handled it
+	void on_event(std::function<void(SDL_Event const &)> handler);
+
+	// Called after the window was resized and the viewport was updated
+	void on_resize(std::function<void(int width, int height)> handler);
+
+	// Runs the loop until the window is closed or quit() is called;
+	// frame(dt) is called once per frame with the time since the previous one
+	void run(std::function<void(float dt)> const & frame);
+
+	// Same loop with a fixed_clock: update(step) is called as many times
+	// as the frame time allows, then render(alpha) once with the fraction
+	// of a step left over for interpolating between simulated states
+	void run(float step, std::function<void(float step)> const & update, std::function<void(float alpha)> const & render);
+
+	void quit();
+
+private:
+	void dispatch(SDL_Event const & event);
+	bool next_session_frame(float & dt);
+	void run_windowed(std::function<void(float dt)> const & frame);
+	void run_headless(std::function<void(float dt)> const & frame);
+	void render_frame(std::function<void(float dt)> const & frame, float dt);
+
+	// Running totals that report_frames() turns into per-frame numbers
+	struct counters
+	{
+		uniform_statistics uniforms;
+		state_statistics state;
+		std::uint64_t allocations;
+		meshlet_statistics meshlets;
+	};
+
+	static counters current_counters();
+
+	void init(application_config const & config);
+	void report_startup() const;
+	void update_assets();
+	void report_frames(int frames, float seconds, counters const & since);
+
+	SDL_Window * window_ = nullptr;
+	SDL_GLContext gl_context_ = nullptr;
+	int width_ = 0;
+	int height_ = 0;
+	bool running_ = false;
+	float report_interval_ = 0.f;
+	int frames_ = 0;
+
+	std::chrono::high_resolution_clock::time_point start_time_;
+	std::unique_ptr<engine::program_cache> program_cache_;
+	std::unique_ptr<headless_context> headless_;
+	frame_profiler profiler_;
+	input_state input_;
+	gl_state state_;
+	std::unique_ptr<uniform_ring> uniform_ring_;
+
+	unsigned asset_threads_ = 0;
+	float asset_upload_budget_ms_ = 0.f;
+	bool upload_context_ = false;
+	bool wait_for_assets_ = false;
+	std::unique_ptr<asset_manager> assets_;
+	bool first_frame_reported_ = false;
+	bool assets_reported_ = false;
+
+	std::unique_ptr<session_writer> recorder_;
+	std::unique_ptr<session_reader> player_;
+	std::vector<SDL_Event> session_events_;
+
+	std::function<void(SDL_Event const &)> event_handler_;
+	std::function<void(int, int)> resize_handler_;
+};
+
+}
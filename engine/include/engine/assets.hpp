@@ -0,0 +1,170 @@
+#pragma once
+
+#include <engine/shared_context.hpp>
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// Handle to an asset requested from an asset_manager. Until ready() the
+// demo keeps drawing with whatever placeholder it set up. The upload step
+// of the asset fills objects the demo does not draw with yet, ready()
+// tells when it may switch over to them.
+class asset
+{
+public:
+	asset() = default;
+
+	bool ready() const { return slot_ && slot_->ready; }
+	std::string const & name() const { return slot_->name; }
+
+private:
+	friend class asset_manager;
+
+	struct slot
+	{
+		std::string name;
+		// Only touched on the GL thread
+		bool ready = false;
+	};
+
+	std::shared_ptr<slot> slot_;
+};
+
+// Loads assets without blocking the frame loop. Every asset is split in
+// two: the decode step (reading, parsing, decompressing) runs on a worker
+// thread and returns the upload step, which makes the GL calls.
+//
+// With a shared_context the upload steps run on an upload thread of their
+// own, each finished asset is published with a fence, and update() only
+// polls the fences; the render thread never waits for an upload unless
+// wait_all() asks it to. Without one (or if the context cannot be bound
+// on another thread) the upload steps run on the GL thread in update(),
+// in the order they were decoded, until the per-frame budget is spent.
+// An upload step returns false to be called again, which splits a large
+// upload into slices that are spread over several frames; at least one
+// slice runs per frame, so a slice longer than the budget still gets
+// through.
+//
+// An exception thrown by either step is rethrown from update() with the
+// asset name, just like a failed synchronous load would end the demo.
+//
+// Both steps are destroyed on the render thread, at the latest by the
+// destructor, which abandons unfinished uploads between two slices; they
+// may own GL objects but must not refer to anything that dies earlier.
+class asset_manager
+{
+public:
+	// Returns true once the asset is complete
+	using upload_function = std::function<bool()>;
+	using decode_function = std::function<upload_function()>;
+
+	struct statistics
+	{
+		std::uint64_t requested = 0;
+		std::uint64_t uploaded = 0;
+		// Time spent in upload steps, on whichever thread ran them, and
+		// the number and longest of those calls
+		double upload_ms = 0.0;
+		double max_upload_ms = 0.0;
+		std::uint64_t slices = 0;
+		// Render thread time blocked on fences in wait_all()
+		double fence_wait_ms = 0.0;
+		// Frames whose uploads took longer than the budget
+		std::uint64_t over_budget_frames = 0;
+		// Frames that left decoded assets for later to stay in the budget
+		std::uint64_t deferred_frames = 0;
+	};
+
+	// Zero threads means one less than the hardware threads, at least one;
+	// the context is optional and taken over by the upload thread
+	asset_manager(unsigned threads, double upload_budget_ms, std::unique_ptr<shared_context> context = nullptr);
+	~asset_manager();
+
+	asset_manager(asset_manager const &) = delete;
+	asset_manager & operator = (asset_manager const &) = delete;
+
+	asset load(std::string name, decode_function decode);
+
+	// Publishes finished assets; returns the number of upload steps run on
+	// this thread, which may have changed any GL state
+	std::size_t update();
+
+	// Blocks until everything requested so far is uploaded, returns the
+	// same as update()
+	std::size_t wait_all();
+
+	// Whether uploads run on a shared context
+	bool background_uploads() const { return static_cast<bool>(context_); }
+
+	bool idle() const { return stats_.uploaded == stats_.requested; }
+	statistics const & stats() const { return stats_; }
+
+private:
+	struct job
+	{
+		std::shared_ptr<asset::slot> slot;
+		decode_function decode;
+		upload_function upload;
+		std::exception_ptr error;
+		GLsync fence = nullptr;
+		double upload_ms = 0.0;
+		double max_upload_ms = 0.0;
+		std::uint64_t slices = 0;
+		job * next = nullptr;
+	};
+
+	using job_queue = std::deque<std::unique_ptr<job>>;
+
+	std::vector<std::thread> workers_;
+	double upload_budget_ms_;
+
+	// Requests, consumed by the workers
+	std::mutex mutex_;
+	std::condition_variable requests_ready_;
+	std::deque<job *> requests_;
+	bool stopping_ = false;
+
+	// Decoded jobs, pushed by the workers as a lock-free stack that the
+	// uploading thread takes over as a whole, so pops never race with
+	// each other; the count only ever grows and is waited on
+	std::atomic<job *> decoded_{nullptr};
+	std::atomic<std::uint64_t> decoded_count_{0};
+
+	// Decoded jobs in the order their decode finished, which is not the
+	// request order with several workers, waiting for their upload on the
+	// GL thread, or uploaded and waiting for their fence
+	job_queue uploads_;
+
+	// The upload thread and the jobs it finished, handed over the same way
+	std::unique_ptr<shared_context> context_;
+	std::thread uploader_;
+	std::atomic<bool> stopping_uploader_{false};
+	std::atomic<job *> uploaded_{nullptr};
+	std::atomic<std::uint64_t> uploaded_count_{0};
+
+	statistics stats_;
+
+	void worker();
+	void uploader(std::promise<bool> & started);
+	static void push(std::atomic<job *> & stack, job * j);
+	static void collect(std::atomic<job *> & stack, job_queue & queue);
+	static bool upload_slice(job & j);
+	void publish(job & j);
+};
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+class thread_pool;
+
+struct ray
+{
+	glm::vec3 origin;
+	// Need not be normalized; distances are in multiples of it
+	glm::vec3 direction;
+	float t_min = 0.f;
+	float t_max = std::numeric_limits<float>::infinity();
+};
+
+// The ray through a pixel of a window (y down, as in SDL events) for the
+// given camera, starting at the near plane
+ray screen_ray(glm::mat4 const & projection, glm::mat4 const & view, float x, float y, float width, float height);
+
+inline constexpr std::uint32_t no_hit = std::numeric_limits<std::uint32_t>::max();
+
+struct ray_hit
+{
+	// Index of the triangle in the index buffer the BVH was built from,
+	// no_hit if the ray missed
+	std::uint32_t triangle = no_hit;
+	float t = std::numeric_limits<float>::infinity();
+	// Barycentric coordinates of the hit point with respect to the second
+	// and third vertex of the triangle
+	float u = 0.f;
+	float v = 0.f;
+
+	explicit operator bool() const { return triangle != no_hit; }
+};
+
+// Binary node. Inner nodes have count 0 and their children at first and
+// first + 1; leaves hold count triangles starting at first.
+struct bvh_node
+{
+	glm::vec3 bounds_min;
+	std::uint32_t first;
+	glm::vec3 bounds_max;
+	std::uint32_t count;
+};
+
+static_assert(sizeof(bvh_node) == 32);
+
+// Four-wide node with the boxes of its children as arrays of single
+// components, tested at once with SSE. Child k is a wide node if
+// count[k] is 0 and child[k] is not no_hit, a leaf of count[k] triangles
+// otherwise; unused slots have empty boxes.
+struct bvh4_node
+{
+	float min_x[4], min_y[4], min_z[4];
+	float max_x[4], max_y[4], max_z[4];
+	std::uint32_t child[4];
+	std::uint32_t count[4];
+};
+
+static_assert(sizeof(bvh4_node) == 128);
+
+struct bvh_options
+{
+	// Builds the subtrees below the top levels in parallel if set
+	thread_pool * pool = nullptr;
+	// Also collapses the tree into four-wide nodes, which the queries
+	// then traverse
+	bool wide = false;
+	std::size_t max_leaf_size = 8;
+};
+
+// Bounding volume hierarchy over the triangles of an indexed mesh, split
+// by the surface area heuristic evaluated in 16 bins per axis. The
+// triangles are copied in leaf order, so queries do not touch the mesh.
+class bvh
+{
+public:
+	bvh() = default;
+	bvh(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions, bvh_options const & options = {});
+
+	std::span<bvh_node const> nodes() const { return nodes_; }
+	std::span<bvh4_node const> wide_nodes() const { return wide_nodes_; }
+	std::size_t triangle_count() const { return triangle_ids_.size(); }
+
+	// The nearest hit in [t_min, t_max]
+	ray_hit closest_hit(ray const & r) const;
+	// Whether anything is hit in [t_min, t_max]; stops at the first hit
+	bool any_hit(ray const & r) const;
+
+	// Batched queries, split into chunks over the pool if one is given
+	void closest_hit(std::span<ray const> rays, std::span<ray_hit> hits, thread_pool * pool = nullptr) const;
+	void any_hit(std::span<ray const> rays, std::span<std::uint8_t> occluded, thread_pool * pool = nullptr) const;
+
+private:
+	// Vertex and edges, as used by the Moeller-Trumbore test
+	struct triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 e1;
+		glm::vec3 e2;
+	};
+
+	std::vector<bvh_node> nodes_;
+	std::vector<bvh4_node> wide_nodes_;
+	std::vector<triangle> triangles_;
+	std::vector<std::uint32_t> triangle_ids_;
+
+	template <bool Any>
+	bool traverse(ray const & r, ray_hit & hit) const;
+	template <bool Any>
+	bool traverse_wide(ray const & r, ray_hit & hit) const;
+	template <bool Any>
+	bool intersect_leaf(ray const & r, std::uint32_t first, std::uint32_t count, ray_hit & hit) const;
+};
+
+// One line with the nodes, leaves, depth and SAH cost of the tree
+std::string bvh_report(bvh const & tree);
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+
+namespace engine
+{
+
+// Fixed-timestep simulation clock. Frame times are accumulated and
+// consumed in constant steps, so the simulation does not depend on the
+// render rate; the remainder is exposed as an interpolation factor for
+// rendering between the last two simulated states.
+class fixed_clock
+{
+public:
+	// At most max_steps are simulated per frame; if the renderer falls
+	// further behind, the excess time is dropped instead of piling up
+	explicit fixed_clock(float step, int max_steps = 8)
+		: step_(step)
+		, max_steps_(max_steps)
+	{}
+
+	float step() const { return step_; }
+
+	// Simulated time, a whole number of steps
+	double time() const { return steps_ * double(step_); }
+
+	// Adds the frame time and returns the number of steps to simulate
+	int advance(float dt)
+	{
+		accumulator_ += dt;
+
+		int steps = int(accumulator_ / step_);
+		accumulator_ -= steps * step_;
+
+		if (steps > max_steps_)
+		{
+			steps = max_steps_;
+			accumulator_ = 0.f;
+		}
+
+		steps_ += steps;
+		return steps;
+	}
+
+	// Fraction of a step accumulated but not yet simulated, in [0, 1)
+	float alpha() const
+	{
+		return std::clamp(accumulator_ / step_, 0.f, 1.f);
+	}
+
+private:
+	float step_;
+	int max_steps_;
+	float accumulator_ = 0.f;
+	long long steps_ = 0;
+};
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+
+namespace engine
+{
+
+std::string to_string(std::string_view str);
+
+[[noreturn]] void sdl2_fail(std::string_view message);
+
+[[noreturn]] void glew_fail(std::string_view message, GLenum error);
+
+}
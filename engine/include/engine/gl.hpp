@@ -0,0 +1,115 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <utility>
+
+namespace engine
+{
+
+// Owning wrapper around a GL object name. Default construction creates
+// the object, destruction deletes it; the wrapper converts to GLuint so
+// that it can be passed to GL calls directly.
+template <typename Traits>
+class gl_object
+{
+public:
+	gl_object()
+		: id_(Traits::create())
+	{}
+
+	// Takes ownership of an existing object name
+	explicit gl_object(GLuint id) noexcept
+		: id_(id)
+	{}
+
+	gl_object(gl_object const &) = delete;
+	gl_object & operator = (gl_object const &) = delete;
+
+	gl_object(gl_object && other) noexcept
+		: id_(std::exchange(other.id_, 0))
+	{}
+
+	gl_object & operator = (gl_object && other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			id_ = std::exchange(other.id_, 0);
+		}
+		return *this;
+	}
+
+	~gl_object()
+	{
+		reset();
+	}
+
+	GLuint id() const noexcept
+	{
+		return id_;
+	}
+
+	operator GLuint() const noexcept
+	{
+		return id_;
+	}
+
+	GLuint release() noexcept
+	{
+		return std::exchange(id_, 0);
+	}
+
+	void reset() noexcept
+	{
+		if (id_ != 0)
+			Traits::destroy(id_);
+		id_ = 0;
+	}
+
+private:
+	GLuint id_ = 0;
+};
+
+namespace detail
+{
+
+struct buffer_traits
+{
+	static GLuint create() { GLuint id; glGenBuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+
+struct vertex_array_traits
+{
+	static GLuint create() { GLuint id; glGenVertexArrays(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+
+struct texture_traits
+{
+	static GLuint create() { GLuint id; glGenTextures(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+
+struct framebuffer_traits
+{
+	static GLuint create() { GLuint id; glGenFramebuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+
+struct renderbuffer_traits
+{
+	static GLuint create() { GLuint id; glGenRenderbuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteRenderbuffers(1, &id); }
+};
+
+}
+
+using buffer = gl_object<detail::buffer_traits>;
+using vertex_array = gl_object<detail::vertex_array_traits>;
+using texture = gl_object<detail::texture_traits>;
+using framebuffer = gl_object<detail::framebuffer_traits>;
+using renderbuffer = gl_object<detail::renderbuffer_traits>;
+
+}
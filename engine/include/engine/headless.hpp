@@ -0,0 +1,42 @@
+#pragma once
+
+#include <engine/shared_context.hpp>
+
+#include <GL/glew.h>
+
+#include <memory>
+
+namespace engine
+{
+
+// OpenGL 3.3 core context without any window, created with EGL on the
+// surfaceless platform (works with Mesa's llvmpipe on machines without a
+// GPU). Rendering goes to an offscreen framebuffer that stands in for the
+// default one.
+class headless_context
+{
+public:
+	headless_context(int width, int height, int multisamples);
+	~headless_context();
+
+	headless_context(headless_context const &) = delete;
+	headless_context & operator = (headless_context const &) = delete;
+
+	GLuint framebuffer() const { return framebuffer_; }
+
+	// Context for an upload thread, nullptr if it cannot be created
+	std::unique_ptr<shared_context> create_shared() const;
+
+private:
+	void init(int width, int height, int multisamples);
+	void release();
+
+	void * display_ = nullptr;
+	void * context_ = nullptr;
+
+	GLuint framebuffer_ = 0;
+	GLuint color_ = 0;
+	GLuint depth_ = 0;
+};
+
+}
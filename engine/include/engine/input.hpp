@@ -0,0 +1,89 @@
+#pragma once
+
+#include <engine/sdl.hpp>
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine
+{
+
+// Keyboard and mouse state of the current frame, kept in scancode-indexed
+// bitsets with the keys that went down or up since the previous frame.
+// The state is built from the dispatched events rather than read with
+// SDL_GetKeyboardState, so replayed sessions drive it exactly like live
+// input. Everything is fixed-size, nothing is allocated per frame.
+//
+// Keys are scancodes, i.e. physical positions: WASD stays in place on
+// any keyboard layout.
+class input_state
+{
+public:
+	static constexpr std::size_t max_actions = 32;
+	static constexpr std::size_t max_keys_per_action = 4;
+
+	// Called by the application before the events of a frame are dispatched
+	void begin_frame();
+	void handle(SDL_Event const & event);
+
+	bool down(SDL_Scancode key) const { return valid(key) && down_[key]; }
+
+	// The key went down (or up) during this frame; both can be true for a
+	// key tapped faster than the frame rate
+	bool pressed(SDL_Scancode key) const { return valid(key) && pressed_[key]; }
+	bool released(SDL_Scancode key) const { return valid(key) && released_[key]; }
+
+	// Actions are small integers, typically values of a demo's own enum;
+	// an action is down if any of its keys is
+	void bind(std::size_t action, SDL_Scancode key);
+	bool action_down(std::size_t action) const { return any(action, down_); }
+	bool action_pressed(std::size_t action) const { return any(action, pressed_); }
+	bool action_released(std::size_t action) const { return any(action, released_); }
+
+	// Buttons are SDL_BUTTON_LEFT etc.
+	bool mouse_down(int button) const { return mouse_down_ & mask(button); }
+	bool mouse_pressed(int button) const { return mouse_pressed_ & mask(button); }
+	bool mouse_released(int button) const { return mouse_released_ & mask(button); }
+
+	int mouse_x() const { return mouse_x_; }
+	int mouse_y() const { return mouse_y_; }
+
+	// Accumulated over the current frame
+	int mouse_dx() const { return mouse_dx_; }
+	int mouse_dy() const { return mouse_dy_; }
+	int wheel() const { return wheel_; }
+
+private:
+	using key_set = std::bitset<SDL_NUM_SCANCODES>;
+
+	key_set down_;
+	key_set pressed_;
+	key_set released_;
+
+	struct binding
+	{
+		std::array<SDL_Scancode, max_keys_per_action> keys;
+		std::size_t count = 0;
+	};
+
+	std::array<binding, max_actions> actions_;
+
+	std::uint32_t mouse_down_ = 0;
+	std::uint32_t mouse_pressed_ = 0;
+	std::uint32_t mouse_released_ = 0;
+	int mouse_x_ = 0;
+	int mouse_y_ = 0;
+	int mouse_dx_ = 0;
+	int mouse_dy_ = 0;
+	int wheel_ = 0;
+
+	static bool valid(SDL_Scancode key) { return key > 0 && key < SDL_NUM_SCANCODES; }
+	static std::uint32_t mask(int button) { return button > 0 && button <= 32 ? 1u << (button - 1) : 0u; }
+
+	bool any(std::size_t action, key_set const & keys) const;
+	void release_all();
+};
+
+}
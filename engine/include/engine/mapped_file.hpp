@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <type_traits>
+
+namespace engine
+{
+
+// Read-only memory mapping of a whole file. Pages are read in by the OS
+// on first access, so mapping is cheap regardless of the file size and
+// copying out of the mapping costs little more than the page faults.
+class mapped_file
+{
+public:
+	mapped_file() = default;
+
+	// Throws std::runtime_error if the file cannot be opened or mapped.
+	// With prefetch the whole file is read in right away (MAP_POPULATE,
+	// or MADV_WILLNEED where that is missing) instead of page by page on
+	// first access, which suits files that are about to be copied whole.
+	explicit mapped_file(std::filesystem::path const & path, bool prefetch = false);
+	~mapped_file();
+
+	mapped_file(mapped_file && other) noexcept;
+	mapped_file & operator = (mapped_file && other) noexcept;
+
+	std::byte const * data() const { return data_; }
+	std::size_t size() const { return size_; }
+	std::span<std::byte const> bytes() const { return {data_, size_}; }
+
+private:
+	std::byte const * data_ = nullptr;
+	std::size_t size_ = 0;
+
+	void reset();
+};
+
+// Reads a raw binary file front to back out of its mapping. Arrays are
+// handed out as spans pointing straight into the mapping, so they stay
+// valid as long as the reader lives; nothing is copied or zero-filled.
+// Every read is checked against the end of the file and the alignment of
+// the type, errors are thrown as std::runtime_error naming the file.
+class mapped_reader
+{
+public:
+	explicit mapped_reader(std::filesystem::path const & path)
+		: path_(path)
+		, file_(path, true)
+	{}
+
+	template <typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		T result;
+		std::memcpy(&result, take(sizeof(T), 1), sizeof(T));
+		return result;
+	}
+
+	template <typename T>
+	std::span<T const> read_array(std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (count > remaining() / sizeof(T))
+			fail("needs " + std::to_string(count) + " elements of " + std::to_string(sizeof(T)) + " bytes, "
+				+ std::to_string(remaining()) + " bytes left");
+		return {reinterpret_cast<T const *>(take(count * sizeof(T), alignof(T))), count};
+	}
+
+	std::size_t remaining() const { return file_.size() - offset_; }
+
+	// Throws unless everything was read, which catches files whose counts
+	// do not match their contents
+	void expect_end() const;
+
+	[[noreturn]] void fail(std::string const & message) const;
+
+private:
+	std::filesystem::path path_;
+	mapped_file file_;
+	std::size_t offset_ = 0;
+
+	std::byte const * take(std::size_t size, std::size_t alignment);
+};
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <engine/obj.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/ext/vector_int4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// Materials a uniform block can hold: GL guarantees 16 KiB per block
+inline constexpr std::size_t max_materials = 256;
+
+// A material as one element of a std140 array, 64 bytes. Shaders declare
+//     struct material
+//     {
+//         vec4 diffuse;
+//         vec4 specular;
+//         vec4 emission;
+//         ivec4 maps;
+//     };
+//     layout (std140) uniform material_block
+//     {
+//         material materials[256];
+//     };
+struct packed_material
+{
+	// Kd, d in w
+	glm::vec4 diffuse;
+	// Ks, Ns in w
+	glm::vec4 specular;
+	// Ke, Ni in w
+	glm::vec4 emission;
+	// Indices into material_table::textures of map_Kd and of the normal
+	// map, -1 if the material has none; then illum
+	glm::ivec4 maps;
+};
+
+static_assert(sizeof(packed_material) == 64);
+
+// The materials of a model packed for a uniform buffer, with the texture
+// paths they refer to listed once each
+struct material_table
+{
+	std::vector<packed_material> materials;
+	std::vector<std::string> textures;
+
+	// Bytes to upload: the table padded to max_materials, which the
+	// uniform block declares
+	std::size_t buffer_size() const { return max_materials * sizeof(packed_material); }
+};
+
+// Throws std::runtime_error for more than max_materials materials
+material_table pack_materials(std::span<obj_material const> materials);
+
+// obj_vertex with the index of its material, for a single vertex buffer
+// shared by all materials
+struct material_vertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texcoord;
+	std::uint32_t material;
+};
+
+// Contiguous range of material_batches::indices drawn with one call
+struct material_draw
+{
+	std::uint32_t first_index;
+	std::uint32_t index_count;
+	// Translucent (d < 1), drawn after the opaque geometry with blending
+	bool blended;
+};
+
+// A model regrouped for drawing with the material picked per vertex from
+// the material table instead of per draw: all opaque materials share the
+// first draw, every translucent material gets a draw of its own after
+// it, so that they can still be ordered by distance. Vertices that the
+// importer welded across materials are split, one copy per material.
+struct material_batches
+{
+	std::vector<material_vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	std::vector<material_draw> draws;
+};
+
+material_batches batch_by_material(obj_model const & model);
+
+// One line with the draws before and after and the vertices split, e.g.
+// "1627 face groups, 15 submeshes, 4 draws (1 opaque, 3 blended), ..."
+std::string material_report(obj_model const & model, material_batches const & batches);
+
+}
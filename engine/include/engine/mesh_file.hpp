@@ -0,0 +1,191 @@
+#pragma once
+
+#include <engine/mapped_file.hpp>
+#include <engine/simplify.hpp>
+
+#include <GL/glew.h>
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+// One vertex attribute of an interleaved vertex layout, in the terms of
+// glVertexAttribPointer
+struct mesh_attribute
+{
+	std::uint32_t location;
+	std::uint32_t type;
+	std::uint32_t components;
+	std::uint32_t normalized;
+	std::uint32_t offset;
+};
+
+// Header at the start of a .mesh file. The file is a ready-to-upload
+// mesh: the header and its table of levels of detail, then the
+// vertices and the indices, each section starting at a multiple of
+// section_alignment. The vertices are either all attributes interleaved,
+// or the first attribute (the position) tightly packed in a stream of
+// its own followed by the other attributes interleaved, so that depth
+// passes fetch nothing but positions. All fields are little-endian,
+// which is what every platform the course runs on uses.
+struct mesh_header
+{
+	static constexpr std::uint32_t magic_value = 0x4853454d; // "MESH"
+	static constexpr std::uint32_t current_version = 4;
+	static constexpr std::size_t max_attributes = 7;
+	static constexpr std::size_t max_lods = 16;
+	static constexpr std::size_t section_alignment = 64;
+
+	std::uint32_t magic;
+	std::uint32_t version;
+	// Identifies the source file revision and the processing the mesh was
+	// built with, see mesh_source_hash
+	std::uint64_t source_hash;
+
+	// Of the interleaved attributes, without the position if it is split
+	std::uint32_t vertex_stride;
+	std::uint32_t attribute_count;
+	// The offset of a split position is within the position stream
+	std::array<mesh_attribute, max_attributes> attributes;
+
+	// GL_UNSIGNED_SHORT when every vertex can be addressed with it,
+	// GL_UNSIGNED_INT otherwise
+	std::uint32_t index_type;
+	// Entries of the mesh_lod table right after the header; a mesh
+	// without levels of detail has none
+	std::uint32_t lod_count;
+	// Of the position stream, zero if the position is interleaved
+	std::uint32_t position_stride;
+
+	std::uint64_t vertex_count;
+	std::uint64_t index_count;
+
+	// Of the first attribute if it is three floats, as given by
+	// mesh_data otherwise
+	glm::vec3 bounds_min;
+	glm::vec3 bounds_max;
+
+	// Both equal unless the position is split
+	std::uint64_t position_offset;
+	std::uint64_t vertex_offset;
+	std::uint64_t index_offset;
+	std::uint64_t file_size;
+	std::uint64_t reserved;
+};
+
+static_assert(sizeof(mesh_header) == 256 && std::is_trivially_copyable_v<mesh_header>);
+
+// A mesh about to be written to a .mesh file
+struct mesh_data
+{
+	std::vector<mesh_attribute> attributes;
+	std::uint32_t vertex_stride = 0;
+	std::uint64_t vertex_count = 0;
+	std::vector<std::byte> vertices;
+	std::vector<std::uint32_t> indices;
+	// Ranges of indices, see lod_chain
+	std::vector<mesh_lod> lods;
+
+	// Only used when the first attribute is not three floats, e.g. the
+	// bounds that packed positions were quantized in
+	glm::vec3 bounds_min{0.f};
+	glm::vec3 bounds_max{0.f};
+
+	// Moves the first attribute into a position stream of its own when
+	// the file is laid out; the vertices above stay interleaved
+	bool split_positions = false;
+
+	mesh_data() = default;
+
+	template <typename Vertex>
+	mesh_data(std::vector<Vertex> const & vertices, std::vector<std::uint32_t> indices, std::vector<mesh_attribute> attributes)
+		: attributes(std::move(attributes))
+		, vertex_stride(sizeof(Vertex))
+		, vertex_count(vertices.size())
+		, vertices(vertices.size() * sizeof(Vertex))
+		, indices(std::move(indices))
+	{
+		static_assert(std::is_trivially_copyable_v<Vertex>);
+		std::memcpy(this->vertices.data(), vertices.data(), this->vertices.size());
+	}
+};
+
+// A validated .mesh image, memory-mapped from a file or, right after it
+// was built, held in memory
+class mesh_file
+{
+public:
+	// Maps the file and checks the header and the section bounds against
+	// the file size; the indices themselves are not checked. Throws
+	// std::runtime_error for missing, truncated or foreign files.
+	explicit mesh_file(std::filesystem::path const & path);
+
+	// Lays out the mesh as it would be written, with the indices in the
+	// smallest type that addresses all vertices
+	explicit mesh_file(mesh_data const & data, std::uint64_t source_hash = 0);
+
+	mesh_file(mesh_file &&) = default;
+	mesh_file & operator = (mesh_file &&) = default;
+
+	mesh_header const & header() const { return header_; }
+	// Everything to upload into one GL_ARRAY_BUFFER: the position stream
+	// if there is one, then the interleaved attributes
+	std::span<std::byte const> vertices() const;
+	// The first attribute of every vertex, position_stride() bytes apart
+	std::span<std::byte const> positions() const;
+	std::uint32_t position_stride() const;
+	bool split_positions() const { return header_.position_stride != 0; }
+	std::span<mesh_lod const> lods() const;
+	// In header().index_type, ready for glBufferData
+	std::span<std::byte const> index_bytes() const;
+	// Widened to 32 bits
+	std::vector<std::uint32_t> indices() const;
+	std::span<std::byte const> bytes() const { return bytes_; }
+
+	// Writes the image through a temporary file renamed into place, so a
+	// reader never sees a partially written mesh
+	void write(std::filesystem::path const & path) const;
+
+	// Sets the attributes of the bound vertex array up to read from the
+	// buffer bound to GL_ARRAY_BUFFER, which holds vertices()
+	void setup_attributes() const;
+	// The same for the position alone, for depth-only passes; with split
+	// positions the vertex array then reads nothing but the position stream
+	void setup_position_attribute() const;
+
+private:
+	mapped_file mapping_;
+	std::vector<std::byte> image_;
+	std::span<std::byte const> bytes_;
+	mesh_header header_;
+
+	void validate(std::filesystem::path const & path);
+};
+
+// Hash of the source file's size and modification time and of a key
+// naming the processing the mesh is built with; change the key whenever
+// that processing changes. The contents are not read, so checking a
+// cache costs nothing even for huge sources.
+std::uint64_t mesh_source_hash(std::filesystem::path const & source, std::string_view build_key);
+
+// Opens the cache file if it was built from the current source with the
+// same key. Otherwise builds the mesh, writes the cache for the next run
+// (a cache that cannot be written is not an error) and returns the
+// in-memory image.
+mesh_file load_cached_mesh(std::filesystem::path const & cache, std::filesystem::path const & source,
+	std::string_view build_key, std::function<mesh_data()> const & build);
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// Post-transform vertex cache size the triangle order is tuned for; real
+// hardware caches are between 16 and 32 entries or not a plain cache at
+// all, and an order tuned for 32 holds up well on all of them
+inline constexpr std::size_t default_vertex_cache_size = 32;
+
+// Reorders the triangles of an indexed triangle list for the
+// post-transform vertex cache with Tom Forsyth's linear-speed algorithm:
+// every step emits the triangle whose vertices score highest, where a
+// vertex scores by its position in a simulated LRU cache and by how few
+// triangles still need it, so that vertices are used up while cached.
+// Indices must be below vertex_count.
+void optimize_vertex_cache(std::span<std::uint32_t> indices, std::size_t vertex_count,
+	std::size_t cache_size = default_vertex_cache_size);
+
+inline constexpr std::uint32_t no_vertex = ~std::uint32_t(0);
+
+// Renumbers the vertices in the order the indices first use them, which
+// makes the vertex fetch of an index buffer in vertex cache order walk
+// the vertex buffer front to back. Rewrites the indices and returns the
+// new index of every old vertex; unused vertices get no_vertex.
+std::vector<std::uint32_t> optimize_vertex_fetch_remap(std::span<std::uint32_t> indices, std::size_t vertex_count);
+
+// Applies optimize_vertex_fetch_remap to the vertices, dropping unused ones
+template <typename Vertex>
+void optimize_vertex_fetch(std::vector<Vertex> & vertices, std::span<std::uint32_t> indices)
+{
+	auto remap = optimize_vertex_fetch_remap(indices, vertices.size());
+
+	std::size_t used = 0;
+	for (auto index : remap)
+		used += (index != no_vertex);
+
+	std::vector<Vertex> reordered(used);
+	for (std::size_t i = 0; i < remap.size(); ++i)
+		if (remap[i] != no_vertex)
+			reordered[remap[i]] = vertices[i];
+	vertices = std::move(reordered);
+}
+
+enum class vertex_cache_policy
+{
+	fifo,
+	lru,
+};
+
+// Vertex shader invocations of an index buffer, as simulated on the CPU
+struct vertex_cache_statistics
+{
+	std::size_t triangles = 0;
+	// Distinct vertices referenced by the indices
+	std::size_t vertices = 0;
+	// Cache misses, i.e. vertex shader invocations
+	std::size_t transformed = 0;
+
+	// Average cache miss ratio: invocations per triangle, 0.5 at best for
+	// large regular meshes, 3 at worst
+	double acmr() const { return triangles ? double(transformed) / triangles : 0.0; }
+	// Average transform to vertex ratio: invocations per vertex, 1 at best
+	double atvr() const { return vertices ? double(transformed) / vertices : 0.0; }
+};
+
+vertex_cache_statistics analyze_vertex_cache(std::span<std::uint32_t const> indices, std::size_t vertex_count,
+	std::size_t cache_size, vertex_cache_policy policy);
+
+// One line comparing an index buffer before and after optimization under
+// the FIFO and LRU models, e.g. for a demo to print at startup
+std::string vertex_cache_report(std::span<std::uint32_t const> before, std::span<std::uint32_t const> after,
+	std::size_t vertex_count);
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+inline constexpr std::size_t max_meshlet_vertices = 64;
+inline constexpr std::size_t max_meshlet_triangles = 124;
+
+// A cluster of triangles that is culled as a whole: a contiguous range of
+// the index buffer with its bounding sphere and the cone that contains
+// the normals of all its triangles
+struct meshlet
+{
+	std::uint32_t first_index;
+	std::uint32_t index_count;
+	std::uint32_t vertex_count;
+
+	glm::vec3 center;
+	float radius;
+
+	// Every triangle faces away from any point from which the apex is
+	// seen within the cone: dot(normalize(apex - camera), axis) >= cutoff
+	glm::vec3 cone_apex;
+	glm::vec3 cone_axis;
+	// Above 1 if the normals spread too far for the cone to cull anything
+	float cone_cutoff;
+};
+
+// Splits a range of an index buffer into meshlets of at most
+// max_meshlet_vertices distinct vertices and max_meshlet_triangles
+// triangles, in the order of the triangles, which therefore should be
+// local already (optimize_vertex_cache). first_index is the position of
+// the range in the whole index buffer, the meshlets' ranges include it.
+std::vector<meshlet> build_meshlets(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::uint32_t first_index = 0);
+
+// Meshlets and triangles tested and culled; the culler also accumulates
+// them over the whole run in meshlet_counters()
+struct meshlet_statistics
+{
+	std::uint64_t meshlets = 0;
+	std::uint64_t frustum_culled = 0;
+	std::uint64_t backface_culled = 0;
+	std::uint64_t triangles = 0;
+	std::uint64_t triangles_drawn = 0;
+	// Ranges left after merging neighbouring visible meshlets
+	std::uint64_t draws = 0;
+
+	meshlet_statistics & operator += (meshlet_statistics const & other);
+};
+
+meshlet_statistics & meshlet_counters();
+
+// One line with the culled fractions, e.g. "1234 meshlets, 40% frustum
+// culled, ..."
+std::string meshlet_report(meshlet_statistics const & statistics);
+
+// Arguments of glMultiDrawElements
+struct multi_draw
+{
+	std::vector<GLsizei> counts;
+	std::vector<void const *> offsets;
+
+	void draw(GLenum index_type) const;
+};
+
+// Culls meshlets against the view frustum and by their normal cones, four
+// at a time with SSE where available. The bounds are kept as arrays of
+// single components padded to a multiple of four, so that the tests run
+// on whole registers without shuffling.
+class meshlet_culler
+{
+public:
+	meshlet_culler() = default;
+	explicit meshlet_culler(std::vector<meshlet> meshlets);
+
+	std::span<meshlet const> meshlets() const { return meshlets_; }
+
+	// Fills draws with the index ranges of the visible meshlets, for an
+	// index buffer of index_size bytes per index. The camera is taken from
+	// the matrices; orthographic projections are recognized and culled by
+	// their view direction.
+	meshlet_statistics cull(glm::mat4 const & projection, glm::mat4 const & view, glm::mat4 const & model,
+		std::size_t index_size, multi_draw & draws);
+
+private:
+	std::vector<meshlet> meshlets_;
+
+	// Structure of arrays of the bounds
+	std::vector<float> center_x_, center_y_, center_z_, radius_;
+	std::vector<float> apex_x_, apex_y_, apex_z_;
+	std::vector<float> axis_x_, axis_y_, axis_z_, cutoff_;
+
+	std::vector<std::uint8_t> visible_;
+};
+
+}
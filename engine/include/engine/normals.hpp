@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+class thread_pool;
+
+enum class normal_weighting
+{
+	// Every triangle counts with its area, i.e. the plain sum of the cross
+	// products of its edges
+	area,
+	// Every triangle counts with its angle at the vertex, which does not
+	// depend on how the surface around the vertex is triangulated
+	angle,
+};
+
+// Smooth vertex normals of an indexed triangle list whose topology stays
+// fixed while the positions change, e.g. a deforming mesh. The incident
+// triangles of every vertex are gathered once into a compressed adjacency
+// list, so that each compute() writes every face and every vertex normal
+// from exactly one thread: the face normals in one parallel pass (cross
+// products four at a time with SSE where available), then the vertex
+// normals in a second one, without atomics or per-thread buffers.
+class normal_generator
+{
+public:
+	normal_generator(std::span<std::uint32_t const> indices, std::size_t vertex_count);
+
+	std::size_t vertex_count() const { return offsets_.size() - 1; }
+
+	// Writes a unit normal for every vertex; vertices not used by any
+	// triangle with a nonzero area get (0, 0, 1). Runs on the calling
+	// thread if pool is null. Nothing is allocated after the first call.
+	void compute(std::span<glm::vec3 const> positions, std::span<glm::vec3> normals,
+		normal_weighting weighting = normal_weighting::area, thread_pool * pool = nullptr);
+
+private:
+	std::vector<std::uint32_t> indices_;
+	// The corners (positions in indices_) of vertex v are
+	// corners_[offsets_[v]] to corners_[offsets_[v + 1] - 1]
+	std::vector<std::uint32_t> offsets_;
+	std::vector<std::uint32_t> corners_;
+
+	// Scratch of compute(): the cross product of every triangle and, for
+	// angle weighting, the weight of every corner relative to it
+	std::vector<glm::vec3> face_normals_;
+	std::vector<float> corner_weights_;
+};
+
+// One-off smooth normals, see normal_generator
+std::vector<glm::vec3> compute_normals(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	normal_weighting weighting = normal_weighting::area, thread_pool * pool = nullptr);
+
+// Gives a vertex one copy per group of its triangles that are joined by
+// edges whose faces meet at less than max_angle_degrees, so that smooth
+// normals computed afterwards keep the creases sharp. The indices are
+// rewritten to the copies; the result holds for every vertex, old and new,
+// the vertex it was copied from, to duplicate the other attributes:
+//     for (auto source : split_hard_edges(indices, positions, 60.f))
+//         new_vertices.push_back(vertices[source]);
+std::vector<std::uint32_t> split_hard_edges(std::span<std::uint32_t> indices, std::span<glm::vec3 const> positions,
+	float max_angle_degrees);
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine
+{
+
+// Positions and triangle indices of a Wavefront OBJ file, everything but
+// the v and f rows is skipped. Faces with more than three vertices are
+// split into triangle fans, texture coordinate and normal references in
+// faces (v/vt/vn) are ignored.
+struct obj_mesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<std::uint32_t> indices;
+};
+
+// The text is scanned in place with std::from_chars, after a first pass
+// that counts the rows to reserve the output; nothing is allocated per
+// row. Errors are reported as std::runtime_error with the line number.
+obj_mesh parse_obj(std::string_view text);
+
+// Reads the whole file with a single read and parses it
+obj_mesh load_obj(std::filesystem::path const & path);
+
+class thread_pool;
+
+// Same result as parse_obj, for multi-gigabyte files. The text is split
+// at line boundaries into chunks that are parsed in parallel into their
+// own vertex and index arrays; these are then copied, again in parallel,
+// into the result at prefix-summed offsets, resolving the relative
+// indices against the number of vertices of the preceding chunks. Files
+// below a few megabytes are parsed on the calling thread. If any chunk
+// fails the text is parsed again by parse_obj for its exact error.
+obj_mesh parse_obj(std::string_view text, thread_pool & pool);
+
+obj_mesh load_obj(std::filesystem::path const & path, thread_pool & pool);
+
+// Material from an MTL file; values not given in the file keep the
+// defaults below
+struct obj_material
+{
+	std::string name;
+	glm::vec3 ambient{1.f};
+	glm::vec3 diffuse{0.8f};
+	glm::vec3 specular{0.f};
+	glm::vec3 emission{0.f};
+	float shininess = 0.f;
+	float refraction_index = 1.f;
+	float opacity = 1.f;
+	int illumination = 2;
+	// Paths as written in the file, relative to it
+	std::string diffuse_map;
+	std::string normal_map;
+};
+
+std::vector<obj_material> parse_mtl(std::string_view text);
+
+struct obj_vertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texcoord;
+};
+
+// Contiguous range of obj_model::indices drawn with one material
+struct obj_submesh
+{
+	std::uint32_t material;
+	std::uint32_t first_index;
+	std::uint32_t index_count;
+};
+
+// A whole OBJ file ready for one vertex buffer, one index buffer and one
+// draw per material. Face corners with the same position, texture
+// coordinate and normal are welded into a single vertex; the triangles of
+// every material are gathered into one submesh regardless of the o and g
+// groups they were declared in. Normals and texture coordinates missing
+// from the file are zero.
+struct obj_model
+{
+	std::vector<obj_vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	std::vector<obj_material> materials;
+	std::vector<obj_submesh> submeshes;
+
+	// Runs of faces between o, g and usemtl rows: the draws of a renderer
+	// that submits the file object by object, as it was written
+	std::size_t face_groups = 0;
+
+	bool has_normals = false;
+	bool has_texcoords = false;
+};
+
+// Materials come from the mtllib files, looked up relative to the
+// directory; usemtl names without a definition get a default material
+obj_model parse_obj_model(std::string_view text, std::filesystem::path const & directory);
+
+obj_model import_obj(std::filesystem::path const & path);
+
+}
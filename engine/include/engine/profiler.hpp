@@ -0,0 +1,126 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// Hierarchical CPU + GPU profiler. Every scope records the CPU time
+// between begin() and end() and the GPU time between two GL_TIMESTAMP
+// queries issued at the same points. Query results are read back a few
+// frames later, so reading them never stalls the pipeline; frames whose
+// results are still not available by then are dropped.
+//
+// Resolved scopes are appended to a chrome://tracing / Perfetto JSON
+// file (if one was given) and accumulated into a per-scope summary.
+//
+// Scope names must outlive the profiler, string literals are expected.
+class frame_profiler
+{
+public:
+	frame_profiler() = default;
+
+	frame_profiler(frame_profiler const &) = delete;
+	frame_profiler & operator = (frame_profiler const &) = delete;
+
+	// Requires a current GL context; an empty path disables the trace file
+	void enable(std::string const & trace_path);
+
+	bool enabled() const { return enabled_; }
+
+	void begin(char const * name);
+	void end();
+
+	// Called by the application around every frame
+	void begin_frame();
+	void end_frame();
+
+	// Waits for the outstanding queries, completes the trace file and
+	// releases the GL objects; has to be called while the context exists
+	void finish();
+
+	// Prints average per-frame CPU and GPU times of every scope since the
+	// previous summary and starts a new averaging window
+	void print_summary(std::ostream & out);
+
+private:
+	static constexpr std::size_t frames_in_flight = 3;
+
+	struct event
+	{
+		char const * name;
+		int parent;
+		std::int64_t cpu_begin;
+		std::int64_t cpu_end;
+		std::uint32_t query;
+	};
+
+	struct frame
+	{
+		std::vector<event> events;
+		std::vector<GLuint> queries;
+		bool pending = false;
+	};
+
+	struct scope_summary
+	{
+		char const * name;
+		int parent;
+		int depth;
+		double cpu_ms = 0.0;
+		double gpu_ms = 0.0;
+	};
+
+	bool enabled_ = false;
+	std::chrono::steady_clock::time_point start_;
+	std::int64_t gpu_offset_ = 0;
+
+	std::array<frame, frames_in_flight> frames_;
+	std::size_t current_ = 0;
+	std::vector<int> stack_;
+
+	std::ofstream trace_;
+	bool first_trace_event_ = true;
+
+	std::vector<scope_summary> summary_;
+	int summary_frames_ = 0;
+	int dropped_frames_ = 0;
+
+	std::int64_t now() const;
+	GLuint query(frame & f, std::uint32_t index);
+	void resolve(frame & f, bool wait);
+	int summary_entry(int parent, char const * name);
+	void write_event(char const * name, int thread, std::int64_t begin, std::int64_t end);
+};
+
+// Profiles the enclosing C++ scope
+class profile_scope
+{
+public:
+	profile_scope(frame_profiler & profiler, char const * name)
+		: profiler_(profiler)
+	{
+		profiler_.begin(name);
+	}
+
+	~profile_scope()
+	{
+		profiler_.end();
+	}
+
+	profile_scope(profile_scope const &) = delete;
+	profile_scope & operator = (profile_scope const &) = delete;
+
+private:
+	frame_profiler & profiler_;
+};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <engine/uniforms.hpp>
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+namespace engine
+{
+
+struct shader_source
+{
+	GLenum type;
+	std::string_view source;
+};
+
+class program_cache;
+
+// Owning wrapper around a linked program object. Compilation and
+// linkage errors are reported as std::runtime_error with the info log.
+class program
+{
+public:
+	program() = default;
+
+	// Compiles and links all stages, e.g.
+	//     program({{GL_VERTEX_SHADER, vs}, {GL_FRAGMENT_SHADER, fs}})
+	// With a cache the linked binary is reused across launches. Defines
+	// are inserted after the #version line of every stage.
+	explicit program(std::initializer_list<shader_source> sources,
+		program_cache * cache = nullptr, std::string_view defines = {});
+
+	program(program const &) = delete;
+	program & operator = (program const &) = delete;
+
+	program(program && other) noexcept;
+	program & operator = (program && other) noexcept;
+
+	~program();
+
+	GLuint id() const noexcept
+	{
+		return id_;
+	}
+
+	operator GLuint() const noexcept
+	{
+		return id_;
+	}
+
+	GLint uniform_location(char const * name) const;
+
+	engine::uniform find(std::string_view name) const
+	{
+		return uniforms_.find(name);
+	}
+
+	// Assigns a uniform block to a binding point. A non-zero size is
+	// checked against the size GL reports for the block, which catches
+	// C++ mirrors that do not follow the std140 layout. Blocks removed by
+	// the compiler are ignored.
+	void bind_block(std::string_view name, GLuint binding, std::size_t size = 0) const;
+
+	// Uploads a uniform value unless it is already set, e.g.
+	//     program.set(model, model_matrix);
+	//     program.set(bone_rotation, i, rotation);
+	// The program has to be in use.
+	template <typename ... Args>
+	void set(engine::uniform u, Args const & ... args)
+	{
+		uniforms_.set(u, args...);
+	}
+
+	uniform_table & uniforms() noexcept
+	{
+		return uniforms_;
+	}
+
+	uniform_table const & uniforms() const noexcept
+	{
+		return uniforms_;
+	}
+
+private:
+	GLuint id_ = 0;
+	uniform_table uniforms_;
+};
+
+}
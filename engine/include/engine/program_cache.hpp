@@ -0,0 +1,64 @@
+#pragma once
+
+#include <engine/program.hpp>
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string_view>
+
+namespace engine
+{
+
+// Stores linked program binaries on disk so that later launches can skip
+// shader compilation. Blobs are keyed by a hash of the stage sources, the
+// defines and the driver strings, so a driver update invalidates them.
+class program_cache
+{
+public:
+	struct statistics
+	{
+		int loaded = 0;
+		int compiled = 0;
+		// Blobs that existed but were refused by the driver
+		int rejected = 0;
+		// Total time spent creating programs through the cache
+		double seconds = 0.0;
+	};
+
+	// Creates the directory if needed; the cache disables itself when the
+	// driver exposes no binary formats
+	explicit program_cache(std::filesystem::path directory);
+
+	bool enabled() const { return enabled_; }
+
+	std::uint64_t key(std::initializer_list<shader_source> sources, std::string_view defines) const;
+
+	// Returns a linked program created from the stored binary, or 0 if
+	// there is no usable blob for the key
+	GLuint load(std::uint64_t key);
+
+	// Writes the binary of a linked program, which must have been linked
+	// with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	void store(std::uint64_t key, GLuint program);
+
+	void add_time(double seconds) { stats_.seconds += seconds; }
+
+	statistics const & stats() const { return stats_; }
+
+private:
+	std::filesystem::path directory_;
+	std::uint64_t driver_hash_ = 0;
+	bool enabled_ = false;
+	statistics stats_;
+
+	std::filesystem::path path(std::uint64_t key) const;
+};
+
+// $GRAPHICS_COURSE_CACHE/programs if set, otherwise a directory in the
+// system temporary directory
+std::filesystem::path default_program_cache_directory();
+
+}
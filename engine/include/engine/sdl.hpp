@@ -0,0 +1,8 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#undef main
+#else
+#include <SDL2/SDL.h>
+#endif
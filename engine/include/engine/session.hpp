@@ -0,0 +1,52 @@
+#pragma once
+
+#include <engine/sdl.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// Recorded input session: for every frame the dt and the keyboard and
+// mouse events polled during it. Replaying a session feeds the
+// demo exactly the same sequence, so with a fixed_clock the simulation is
+// bit-exact across runs and builds. Window events are not recorded, the
+// window geometry belongs to the machine that replays the session.
+//
+// Events are stored as raw SDL_Event structures, so a session can only be
+// replayed by builds with the same SDL_Event layout, which is checked.
+
+// Whether the event is part of the recorded input stream
+bool is_session_event(SDL_Event const & event);
+
+class session_writer
+{
+public:
+	explicit session_writer(std::string const & path);
+
+	void write_frame(float dt, std::vector<SDL_Event> const & events);
+
+private:
+	std::ofstream file_;
+};
+
+class session_reader
+{
+public:
+	explicit session_reader(std::string const & path);
+
+	// Returns false when the session is over
+	bool read_frame(float & dt, std::vector<SDL_Event> & events);
+
+	std::size_t frame_count() const { return frame_count_; }
+
+private:
+	std::vector<char> data_;
+	std::size_t offset_ = 0;
+	std::size_t frame_count_ = 0;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <engine/sdl.hpp>
+
+#include <memory>
+
+namespace engine
+{
+
+// Second OpenGL context that shares textures, buffers and sync objects
+// with the application's context, for one other thread to upload
+// resources on. Container objects (vertex arrays, framebuffers) are not
+// shared and have to be set up on the render thread.
+//
+// Created on the render thread, destroyed there once the other thread
+// has released it.
+class shared_context
+{
+public:
+	// Both return nullptr if the platform cannot create a shared context;
+	// the SDL one leaves the window's context current
+	static std::unique_ptr<shared_context> create(SDL_Window * window, SDL_GLContext context);
+	static std::unique_ptr<shared_context> create_egl(void * display, void * context);
+
+	~shared_context();
+
+	shared_context(shared_context const &) = delete;
+	shared_context & operator = (shared_context const &) = delete;
+
+	// Called on the upload thread; false if the context cannot be bound
+	// there, in which case the caller has to do without it
+	bool make_current();
+	void release();
+
+private:
+	shared_context() = default;
+
+	SDL_Window * window_ = nullptr;
+	SDL_GLContext sdl_context_ = nullptr;
+
+	void * display_ = nullptr;
+	void * egl_context_ = nullptr;
+};
+
+}
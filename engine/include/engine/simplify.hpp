@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+struct simplify_result
+{
+	std::vector<std::uint32_t> indices;
+	// Largest error of a collapse that was made, roughly how far the
+	// simplified surface is from the original, in the units of the mesh
+	float error = 0.f;
+};
+
+// Simplifies an indexed triangle list by quadric edge collapse
+// (Garland-Heckbert) until at most target_index_count indices are left
+// or the next collapse would exceed max_error. A vertex is only ever
+// collapsed onto one of its neighbours, so the result indexes the same
+// vertex buffer and every vertex keeps its attributes, e.g. its bone
+// weights. Border vertices only slide along the border; vertices with
+// the same position but different attributes (seams) are kept.
+//
+// attributes holds attribute_weights.size() floats per vertex, e.g. the
+// normal and the bone weights. Collapsing a vertex onto one whose
+// attributes differ by d is ordered as if it moved the surface by
+// weight * d times the size of the mesh, so a weight of 0.01 makes a
+// flipped normal cost about 2% of the mesh size. Only the geometric part
+// counts towards the error.
+simplify_result simplify(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::size_t target_index_count, float max_error = std::numeric_limits<float>::infinity(),
+	std::span<float const> attributes = {}, std::span<float const> attribute_weights = {});
+
+// Range of an index buffer holding one level of detail of a mesh
+struct mesh_lod
+{
+	std::uint32_t first_index;
+	std::uint32_t index_count;
+	// Simplification error in the units of the mesh, 0 for the original
+	float error;
+	std::uint32_t reserved = 0;
+};
+
+static_assert(sizeof(mesh_lod) == 16);
+
+// Levels of detail of one mesh, all indexing the same vertex buffer and
+// stored one after another in one index buffer, so switching levels only
+// changes the range drawn
+struct lod_chain
+{
+	std::vector<std::uint32_t> indices;
+	std::vector<mesh_lod> lods;
+};
+
+// The original mesh followed by simplifications to the given fractions
+// of its triangles, each built from the previous level. Levels that
+// could not be reduced further than the previous one are left out.
+// Every level is reordered for the vertex cache.
+lod_chain build_lod_chain(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::span<float const> triangle_ratios, std::span<float const> attributes = {},
+	std::span<float const> attribute_weights = {});
+
+// One line with the triangles and the error of every level
+std::string lod_report(std::span<mesh_lod const> lods);
+
+// Screen size in pixels of one unit of the mesh at the given distance
+// from the camera, for a perspective projection with the given vertical
+// field of view, or for an orthographic one showing view_height units
+float perspective_pixels_per_unit(float fovy, float viewport_height, float distance);
+float orthographic_pixels_per_unit(float view_height, float viewport_height);
+
+// The coarsest level whose error covers at most max_pixels on screen;
+// lods must be ordered from fine to coarse
+std::size_t select_lod(std::span<mesh_lod const> lods, float pixels_per_unit, float max_pixels = 1.f);
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine
+{
+
+// Numbers of state-changing GL calls issued and filtered out because the
+// state already had the requested value, accumulated over the whole run
+struct state_statistics
+{
+	std::uint64_t issued = 0;
+	std::uint64_t filtered = 0;
+};
+
+state_statistics & state_counters();
+
+// Shadow copy of the GL state that the demos change every frame: the
+// program, vertex array, textures per unit, framebuffers, viewport and
+// the depth, cull and blend state. Calls that would not change the state
+// are not issued.
+//
+// Everything starts out unknown, so the first call of every kind is
+// always issued. Raw GL calls that change the tracked state behind the
+// cache's back (including deleting a bound object whose name may be
+// reused) have to be followed by invalidate(); the application does it
+// once before the first frame, so setup code does not need to care.
+class gl_state
+{
+public:
+	static constexpr std::size_t max_texture_units = 32;
+
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint vertex_array);
+
+	// Switches the active texture unit only if the binding changes, the
+	// active unit is left unspecified afterwards
+	void bind_texture(GLuint unit, GLenum target, GLuint texture);
+	void active_texture(GLuint unit);
+
+	// GL_FRAMEBUFFER binds both the draw and the read framebuffer
+	void bind_framebuffer(GLenum target, GLuint framebuffer);
+
+	void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	void enable(GLenum capability) { set(capability, true); }
+	void disable(GLenum capability) { set(capability, false); }
+	void set(GLenum capability, bool enabled);
+
+	void depth_func(GLenum func);
+	void depth_mask(bool write);
+	void cull_face(GLenum face);
+	void front_face(GLenum mode);
+	void blend_func(GLenum source, GLenum destination);
+	void blend_equation(GLenum mode);
+
+	void invalidate();
+
+private:
+	template <typename T>
+	struct tracked
+	{
+		T value{};
+		bool known = false;
+	};
+
+	template <typename T>
+	static bool change(tracked<T> & state, T const & value);
+
+	// Texture targets with a binding point of their own on every unit
+	static constexpr std::size_t texture_targets = 10;
+
+	// Capabilities with a known index, others are never filtered
+	static constexpr std::size_t capabilities = 16;
+
+	tracked<GLuint> program_;
+	tracked<GLuint> vertex_array_;
+	tracked<GLuint> active_texture_;
+	std::array<std::array<tracked<GLuint>, texture_targets>, max_texture_units> textures_;
+	tracked<GLuint> draw_framebuffer_;
+	tracked<GLuint> read_framebuffer_;
+	tracked<std::array<GLint, 4>> viewport_;
+	std::array<tracked<bool>, capabilities> capabilities_;
+	tracked<GLenum> depth_func_;
+	tracked<bool> depth_mask_;
+	tracked<GLenum> cull_face_;
+	tracked<GLenum> front_face_;
+	tracked<std::array<GLenum, 2>> blend_func_;
+	tracked<GLenum> blend_equation_;
+};
+
+}
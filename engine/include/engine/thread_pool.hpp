@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// Fixed set of worker threads for data-parallel loops. parallel_for()
+// hands out the indices of a loop one at a time to the workers and to the
+// calling thread, and returns once all of them are done; a pool of size
+// one runs everything on the calling thread. Loops are not reentrant:
+// a task must not call parallel_for() on the same pool.
+class thread_pool
+{
+public:
+	// Zero threads means one per hardware thread; the calling thread
+	// counts as one of them
+	explicit thread_pool(unsigned threads = 0);
+	~thread_pool();
+
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator = (thread_pool const &) = delete;
+
+	unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+	// Calls task(i) for every i in [0, count). The first exception thrown
+	// by a task is rethrown here after the remaining indices were skipped.
+	template <typename Task>
+	void parallel_for(std::size_t count, Task const & task)
+	{
+		run(count, &task, [](void const * task, std::size_t index){ (*static_cast<Task const *>(task))(index); });
+	}
+
+private:
+	using call_type = void (*)(void const *, std::size_t);
+
+	std::vector<std::thread> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable work_ready_;
+	std::condition_variable work_done_;
+	bool stopping_ = false;
+
+	// The current loop, published under the mutex
+	std::uint64_t generation_ = 0;
+	void const * task_ = nullptr;
+	call_type call_ = nullptr;
+	std::size_t count_ = 0;
+	std::atomic<std::size_t> next_{0};
+	unsigned busy_ = 0;
+	std::exception_ptr error_;
+
+	void run(std::size_t count, void const * task, call_type call);
+	void work();
+	void worker();
+};
+
+// Calls task(begin, end) for consecutive ranges of at most chunk_size of
+// the indices in [0, count), over the pool if one is given and on the
+// calling thread otherwise
+template <typename Task>
+void parallel_for_chunks(thread_pool * pool, std::size_t count, std::size_t chunk_size, Task const & task)
+{
+	std::size_t chunks = (count + chunk_size - 1) / chunk_size;
+	auto run = [&](std::size_t chunk){ task(chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size)); };
+	if (pool)
+		pool->parallel_for(chunks, run);
+	else
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+			run(chunk);
+}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace engine
+{
+
+// Streams per-frame uniform data through one large uniform buffer. The
+// buffer is split into a region per frame in flight; a frame writes its
+// blocks one after another into its region and binds them by range.
+// Before a region is reused the CPU waits on the fence placed after the
+// frame that last used it, so data the GPU may still read is never
+// overwritten.
+//
+// With GL 4.4 / ARB_buffer_storage the buffer is mapped once, persistently
+// and coherently, and blocks are written straight into it. Otherwise they
+// are staged in CPU memory and uploaded with one glBufferSubData per
+// flush().
+//
+// Blocks must follow the std140 layout: vec3 and vec4 members are 16 byte
+// aligned, array elements are padded to 16 bytes, and so on. Mirror the
+// GLSL block with glm::vec4 / glm::mat4 members (or alignas(16)) and check
+// the size against the block reflected by the program.
+class uniform_ring
+{
+public:
+	static constexpr std::size_t frames_in_flight = 3;
+
+	struct range
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+		void * data;
+	};
+
+	struct statistics
+	{
+		std::uint64_t bytes = 0;
+		std::uint64_t blocks = 0;
+		// Frames that had to wait for the GPU before reusing their region
+		std::uint64_t stalls = 0;
+	};
+
+	// The capacity is the number of bytes available to a single frame
+	explicit uniform_ring(std::size_t frame_capacity);
+	~uniform_ring();
+
+	uniform_ring(uniform_ring const &) = delete;
+	uniform_ring & operator = (uniform_ring const &) = delete;
+
+	bool persistent() const { return mapping_ != nullptr; }
+	std::size_t frame_capacity() const { return frame_capacity_; }
+	statistics const & stats() const { return stats_; }
+
+	// Called by the application around every frame
+	void begin_frame();
+	void end_frame();
+
+	// Reserves an aligned block in the current frame's region; throws if
+	// the region is full
+	range allocate(std::size_t size);
+
+	template <typename T>
+	range push(T const & value)
+	{
+		auto result = allocate(sizeof(T));
+		std::memcpy(result.data, &value, sizeof(T));
+		return result;
+	}
+
+	// Makes the blocks written so far visible to GL, has to be called
+	// before the draws that read them; a no-op for persistent mappings
+	void flush();
+
+	static void bind(GLuint binding, range const & r)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, r.buffer, r.offset, r.size);
+	}
+
+private:
+	std::size_t frame_capacity_;
+	std::size_t alignment_ = 256;
+
+	GLuint buffer_ = 0;
+	unsigned char * mapping_ = nullptr;
+	std::vector<unsigned char> staging_;
+
+	std::array<GLsync, frames_in_flight> fences_{};
+	std::size_t region_ = 0;
+	std::size_t used_ = 0;
+	std::size_t flushed_ = 0;
+
+	statistics stats_;
+};
+
+}
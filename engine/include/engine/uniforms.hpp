@@ -0,0 +1,142 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat2x2.hpp>
+#include <glm/mat2x3.hpp>
+#include <glm/mat2x4.hpp>
+#include <glm/mat3x2.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat3x4.hpp>
+#include <glm/mat4x2.hpp>
+#include <glm/mat4x3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine
+{
+
+// Handle of an active uniform in a uniform_table. Uniforms removed by the
+// compiler give an invalid handle, setting them is a no-op just like
+// setting location -1.
+struct uniform
+{
+	static constexpr std::uint32_t invalid = ~std::uint32_t(0);
+
+	std::uint32_t index = invalid;
+
+	explicit operator bool() const { return index != invalid; }
+};
+
+struct uniform_block
+{
+	std::string name;
+	GLuint index;
+	GLint data_size;
+};
+
+// Numbers of glUniform* calls issued to GL and skipped because the
+// value did not change, accumulated over the whole run
+struct uniform_statistics
+{
+	std::uint64_t issued = 0;
+	std::uint64_t skipped = 0;
+};
+
+uniform_statistics & uniform_counters();
+
+namespace detail
+{
+
+// What the components of a uniform are read as by glUniform*
+enum class uniform_kind
+{
+	floating,
+	integer,
+	unsigned_integer,
+};
+
+}
+
+// Reflection of the active uniforms and uniform blocks of a linked
+// program, gathered once with glGetActiveUniform. Lookups go through an
+// open-addressing hash table; setters keep a copy of the last uploaded
+// value of every array element and skip uploads that would not change it.
+// The program has to be in use when calling set().
+class uniform_table
+{
+public:
+	uniform_table() = default;
+	explicit uniform_table(GLuint program);
+
+	// Array uniforms are found both by "name" and "name[0]"
+	uniform find(std::string_view name) const;
+
+	// Returns GL_INVALID_INDEX if there is no such block
+	GLuint block_index(std::string_view name) const;
+
+	GLint location(uniform u, std::size_t element = 0) const;
+
+	std::vector<uniform_block> const & blocks() const { return blocks_; }
+
+	void set(uniform u, std::size_t element, float value)           { upload(u, element, detail::uniform_kind::floating, 0, &value, sizeof(value)); }
+	void set(uniform u, std::size_t element, int value)             { upload(u, element, detail::uniform_kind::integer, 0, &value, sizeof(value)); }
+	void set(uniform u, std::size_t element, glm::vec2 const & v)   { upload(u, element, detail::uniform_kind::floating, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::vec3 const & v)   { upload(u, element, detail::uniform_kind::floating, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::vec4 const & v)   { upload(u, element, detail::uniform_kind::floating, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::ivec2 const & v)  { upload(u, element, detail::uniform_kind::integer, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::ivec3 const & v)  { upload(u, element, detail::uniform_kind::integer, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::ivec4 const & v)  { upload(u, element, detail::uniform_kind::integer, 0, &v, sizeof(v)); }
+	void set(uniform u, std::size_t element, glm::mat2 const & m)   { upload(u, element, detail::uniform_kind::floating, 2, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat2x3 const & m) { upload(u, element, detail::uniform_kind::floating, 2, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat2x4 const & m) { upload(u, element, detail::uniform_kind::floating, 2, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat3x2 const & m) { upload(u, element, detail::uniform_kind::floating, 3, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat3 const & m)   { upload(u, element, detail::uniform_kind::floating, 3, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat3x4 const & m) { upload(u, element, detail::uniform_kind::floating, 3, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat4x2 const & m) { upload(u, element, detail::uniform_kind::floating, 4, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat4x3 const & m) { upload(u, element, detail::uniform_kind::floating, 4, &m, sizeof(m)); }
+	void set(uniform u, std::size_t element, glm::mat4 const & m)   { upload(u, element, detail::uniform_kind::floating, 4, &m, sizeof(m)); }
+
+	template <typename T>
+	void set(uniform u, T const & value)
+	{
+		set(u, 0, value);
+	}
+
+	// Forgets the shadowed values, e.g. after the program was changed
+	// behind the table's back with raw glUniform calls
+	void invalidate();
+
+private:
+	struct entry
+	{
+		std::string name;
+		GLenum type;
+		GLint size;
+		bool array;
+		std::uint32_t first_location;
+		std::uint32_t value_offset;
+		std::uint32_t value_size;
+	};
+
+	std::vector<entry> entries_;
+	std::vector<GLint> locations_;
+	std::vector<unsigned char> values_;
+	std::vector<unsigned char> known_;
+	std::vector<std::uint32_t> slots_;
+	std::vector<uniform_block> blocks_;
+
+	void insert(std::string_view name, std::uint32_t index);
+	// Throws unless the value has the size, the kind and, for matrices,
+	// the number of columns of the uniform; columns is zero for vectors
+	void upload(uniform u, std::size_t element, detail::uniform_kind kind, int columns, void const * data, std::size_t size);
+};
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/common.hpp>
+#include <glm/ext/vector_int2_sized.hpp>
+#include <glm/ext/vector_uint4_sized.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace engine
+{
+
+// Box that positions are quantized into, stored as 16-bit normalized
+// integers (read as vec3 in [0, 1] by GL_UNSIGNED_SHORT, normalized).
+// The scale is the same on all axes, so a model matrix multiplied by
+// dequantize() scales normals uniformly too and normalizing them in the
+// shader is all it takes to keep lighting intact.
+struct position_quantization
+{
+	glm::vec3 origin{0.f};
+	float extent = 1.f;
+
+	position_quantization() = default;
+
+	// Fits the box around the given bounds; the same bounds always give
+	// the same box, so it can be rebuilt from bounds stored with a mesh
+	position_quantization(glm::vec3 const & bounds_min, glm::vec3 const & bounds_max);
+
+	// The fourth component is zero and only pads the vertex
+	glm::u16vec4 encode(glm::vec3 const & position) const;
+	glm::vec3 decode(glm::u16vec4 const & quantized) const;
+
+	// Maps the normalized attribute back to the original positions, e.g.
+	//     model = model * quantization.dequantize();
+	glm::mat4 dequantize() const;
+
+	// Largest distance between a position in the box and its decoding
+	float max_error() const;
+};
+
+// Octahedral normal encoding: the unit sphere is projected onto an
+// octahedron that is unfolded into a square, stored as two signed
+// normalized integers. The two neighbouring grid points of every axis
+// are tried and the one decoding closest to the normal is kept. Normals
+// of zero, infinite or NaN length are encoded as +Z.
+// Component must be std::int8_t or std::int16_t. In GLSL:
+//     vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//     float t = max(-n.z, 0.0);
+//     n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+//     n = normalize(n);
+template <typename Component>
+glm::vec<2, Component> encode_octahedral(glm::vec3 const & normal);
+
+glm::vec3 decode_octahedral(glm::vec2 const & encoded);
+
+template <typename Component>
+glm::vec3 decode_octahedral(glm::vec<2, Component> const & encoded)
+{
+	static_assert(std::is_same_v<Component, std::int8_t> || std::is_same_v<Component, std::int16_t>);
+	float const scale = float((1 << (8 * sizeof(Component) - 1)) - 1);
+	return decode_octahedral(glm::max(glm::vec2(encoded) / scale, glm::vec2(-1.f)));
+}
+
+// Unsigned normalized integer, as read by GL with normalized set to
+// GL_TRUE; values outside [0, 1] are clamped. Unsigned must be
+// std::uint8_t or std::uint16_t.
+template <typename Unsigned>
+Unsigned encode_unorm(float value)
+{
+	static_assert(std::is_same_v<Unsigned, std::uint8_t> || std::is_same_v<Unsigned, std::uint16_t>);
+	return static_cast<Unsigned>(std::lround(std::clamp(value, 0.f, 1.f) * std::numeric_limits<Unsigned>::max()));
+}
+
+template <typename Unsigned>
+float decode_unorm(Unsigned value)
+{
+	static_assert(std::is_same_v<Unsigned, std::uint8_t> || std::is_same_v<Unsigned, std::uint16_t>);
+	return value / float(std::numeric_limits<Unsigned>::max());
+}
+
+// Smallest GL index type that can address vertex_count vertices:
+// GL_UNSIGNED_SHORT up to 65535 vertices, GL_UNSIGNED_INT above
+std::uint32_t index_type(std::size_t vertex_count);
+
+std::size_t index_size(std::uint32_t index_type);
+
+// Index buffer contents in the given type; throws std::runtime_error if
+// an index does not fit
+std::vector<std::byte> pack_indices(std::span<std::uint32_t const> indices, std::uint32_t index_type);
+
+// What a vertex format conversion saved and what it cost, see
+// vertex_format_report
+struct vertex_format_statistics
+{
+	std::size_t vertices = 0;
+	std::size_t indices = 0;
+	std::size_t vertex_size_before = 0;
+	std::size_t vertex_size_after = 0;
+	std::size_t index_size_before = 4;
+	std::size_t index_size_after = 4;
+
+	// Largest distance between a position and its decoding, in the units
+	// of the mesh
+	float max_position_error = 0.f;
+	// Largest angle between a normal and its decoding
+	float max_normal_error_degrees = 0.f;
+
+	void add_position(glm::vec3 const & original, glm::vec3 const & decoded);
+	void add_normal(glm::vec3 const & original, glm::vec3 const & decoded);
+};
+
+// One line with the bytes per vertex and index before and after and the
+// measured error, e.g. for a demo to print at startup
+std::string vertex_format_report(vertex_format_statistics const & statistics);
+
+}
@@ -0,0 +1,68 @@
+#include <engine/allocations.hpp>
+
+#ifdef ENGINE_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<std::uint64_t> allocations{0};
+
+}
+
+// The nothrow and array forms of the default library call this one
+void * operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void * result = std::malloc(size ? size : 1))
+		return result;
+	throw std::bad_alloc();
+}
+
+void operator delete(void * pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+namespace engine
+{
+
+std::uint64_t allocation_count()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+bool allocation_counting()
+{
+	return true;
+}
+
+}
+
+#else
+
+namespace engine
+{
+
+std::uint64_t allocation_count()
+{
+	return 0;
+}
+
+bool allocation_counting()
+{
+	return false;
+}
+
+}
+
+#endif
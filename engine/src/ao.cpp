@@ -0,0 +1,134 @@
+#include <engine/ao.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine
+{
+
+namespace
+{
+
+std::size_t const vertex_chunk_size = 256;
+
+// Van der Corput sequence in base 2
+float radical_inverse(std::uint32_t bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 0x1p-32f;
+}
+
+// Well-mixed bits of a vertex index, the same on every run
+std::uint32_t hash(std::uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// Orthonormal basis around a unit vector without a branch on its
+// direction (Duff et al. 2017)
+void tangent_frame(glm::vec3 const & n, glm::vec3 & t, glm::vec3 & b)
+{
+	float sign = std::copysign(1.f, n.z);
+	float a = -1.f / (sign + n.z);
+	float c = n.x * n.y * a;
+	t = glm::vec3(1.f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+	b = glm::vec3(c, sign + n.y * n.y * a, -n.y);
+}
+
+}
+
+std::vector<float> bake_vertex_ao(bvh const & tree, std::span<glm::vec3 const> positions,
+	std::span<glm::vec3 const> normals, ao_options const & options)
+{
+	if (normals.size() != positions.size())
+		throw std::runtime_error("Expected " + std::to_string(positions.size()) + " normals, got " + std::to_string(normals.size()));
+	if (options.rays == 0)
+		throw std::runtime_error("No rays to bake ambient occlusion with");
+
+	// Cosine-distributed directions in the frame of the normal, z up:
+	// uniform points on the disk lifted onto the hemisphere (Malley)
+	std::vector<glm::vec2> samples(options.rays);
+	for (std::size_t i = 0; i < samples.size(); ++i)
+		samples[i] = glm::vec2((i + 0.5f) / samples.size(), radical_inverse(static_cast<std::uint32_t>(i)));
+
+	std::vector<float> result(positions.size(), 1.f);
+
+	parallel_for_chunks(options.pool, positions.size(), vertex_chunk_size, [&](std::size_t first, std::size_t last)
+	{
+		for (auto v = first; v < last; ++v)
+		{
+			float length = glm::length(normals[v]);
+			if (!(length > 0.f))
+				continue;
+			auto n = normals[v] / length;
+
+			glm::vec3 t, b;
+			tangent_frame(n, t, b);
+
+			// Cranley-Patterson rotation of the samples
+			auto bits = hash(static_cast<std::uint32_t>(v));
+			glm::vec2 offset(float(bits & 0xFFFFu) / 65536.f, float(bits >> 16) / 65536.f);
+
+			ray r;
+			r.origin = positions[v] + n * options.bias;
+			r.t_max = options.max_distance;
+
+			std::size_t open = 0;
+			for (auto const & sample : samples)
+			{
+				auto u = glm::fract(sample + offset);
+				float radius = std::sqrt(u.x);
+				float angle = 2.f * glm::pi<float>() * u.y;
+				float x = radius * std::cos(angle);
+				float y = radius * std::sin(angle);
+				float z = std::sqrt(std::max(0.f, 1.f - u.x));
+
+				r.direction = t * x + b * y + n * z;
+				open += !tree.any_hit(r);
+			}
+
+			result[v] = float(open) / samples.size();
+		}
+	});
+
+	return result;
+}
+
+std::string ao_report(std::span<float const> ao, std::size_t rays_per_vertex, double seconds)
+{
+	double sum = 0.0;
+	float min = 1.f;
+	for (auto value : ao)
+	{
+		sum += value;
+		min = std::min(min, value);
+	}
+
+	double rays = double(ao.size()) * rays_per_vertex;
+
+	std::ostringstream report;
+	report << std::fixed << ao.size() << " vertices, " << rays_per_vertex << " rays each, "
+		<< std::setprecision(1) << seconds * 1000.0 << " ms, "
+		<< std::setprecision(2) << (seconds > 0.0 ? rays / seconds / 1e6 : 0.0) << " Mrays/s, mean AO "
+		<< std::setprecision(3) << (ao.empty() ? 1.0 : sum / ao.size()) << ", min " << min;
+	return report.str();
+}
+
+}
@@ -0,0 +1,496 @@
+#include <engine/application.hpp>
+#include <engine/error.hpp>
+#include <engine/uniforms.hpp>
+#include <engine/clock.hpp>
+#include <engine/allocations.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+namespace
+{
+
+int parse_int(std::string_view str, std::string_view option)
+{
+	int result = 0;
+	auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), result);
+	if (error != std::errc{} || end != str.data() + str.size() || result <= 0)
+		throw std::runtime_error("Invalid value for " + to_string(option) + ": " + to_string(str));
+	return result;
+}
+
+application_config apply_command_line(int argc, char ** argv, application_config config)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+
+		auto value = [&]() -> std::string_view
+		{
+			if (i + 1 == argc)
+				throw std::runtime_error("Missing value for " + to_string(arg));
+			return argv[++i];
+		};
+
+		if (arg == "--headless")
+			config.headless = true;
+		else if (arg == "--frames")
+			config.frames = parse_int(value(), arg);
+		else if (arg == "--profile")
+			config.profile = true;
+		else if (arg == "--trace")
+			config.trace = value();
+		else if (arg == "--record")
+			config.record = value();
+		else if (arg == "--replay")
+			config.replay = value();
+		else if (arg == "--wait-assets")
+			config.wait_for_assets = true;
+		else if (arg == "--no-upload-context")
+			config.upload_context = false;
+		else if (arg == "--size")
+		{
+			auto size = value();
+			auto x = size.find('x');
+			if (x == std::string_view::npos)
+				throw std::runtime_error("Invalid value for --size, expected WxH: " + to_string(size));
+			config.width = parse_int(size.substr(0, x), arg);
+			config.height = parse_int(size.substr(x + 1), arg);
+		}
+		else
+			throw std::runtime_error("Unknown command line option: " + to_string(arg));
+	}
+	return config;
+}
+
+}
+
+application::application(int argc, char ** argv, application_config config)
+	: application(apply_command_line(argc, argv, std::move(config)))
+{}
+
+application::application(application_config const & config)
+	: report_interval_(config.report_interval)
+	, frames_(config.frames)
+	, start_time_(std::chrono::high_resolution_clock::now())
+	, asset_threads_(config.asset_threads)
+	, asset_upload_budget_ms_(config.asset_upload_budget_ms)
+	, upload_context_(config.upload_context)
+	, wait_for_assets_(config.wait_for_assets)
+{
+	if (config.headless)
+	{
+		width_ = config.width;
+		height_ = config.height;
+		headless_ = std::make_unique<headless_context>(width_, height_, config.multisamples);
+		init(config);
+		return;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+		sdl2_fail("SDL_Init: ");
+
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	if (config.multisamples > 0)
+	{
+		SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
+		SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, config.multisamples);
+	}
+	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+
+	window_ = SDL_CreateWindow(config.title.c_str(),
+		SDL_WINDOWPOS_CENTERED,
+		SDL_WINDOWPOS_CENTERED,
+		config.width, config.height,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
+
+	if (!window_)
+		sdl2_fail("SDL_CreateWindow: ");
+
+	SDL_GetWindowSize(window_, &width_, &height_);
+
+	gl_context_ = SDL_GL_CreateContext(window_);
+	if (!gl_context_)
+		sdl2_fail("SDL_GL_CreateContext: ");
+
+	if (!config.vsync)
+		SDL_GL_SetSwapInterval(0);
+
+	if (auto result = glewInit(); result != GLEW_NO_ERROR)
+		glew_fail("glewInit: ", result);
+
+	if (!GLEW_VERSION_3_3)
+		throw std::runtime_error("OpenGL 3.3 is not supported");
+
+	init(config);
+}
+
+// Common part of the windowed and headless setup, runs with a current context
+void application::init(application_config const & config)
+{
+	if (config.program_cache)
+		program_cache_ = std::make_unique<engine::program_cache>(default_program_cache_directory());
+
+	if (config.profile || !config.trace.empty())
+		profiler_.enable(config.trace);
+
+	if (config.uniform_buffer_size > 0)
+		uniform_ring_ = std::make_unique<uniform_ring>(config.uniform_buffer_size);
+
+	if (!config.replay.empty())
+		player_ = std::make_unique<session_reader>(config.replay);
+	if (!config.record.empty())
+		recorder_ = std::make_unique<session_writer>(config.record);
+}
+
+application::~application()
+{
+	profiler_.finish();
+	uniform_ring_.reset();
+	assets_.reset();
+
+	if (headless_)
+		return;
+
+	if (gl_context_)
+		SDL_GL_DeleteContext(gl_context_);
+	if (window_)
+		SDL_DestroyWindow(window_);
+	SDL_Quit();
+}
+
+uniform_ring & application::uniform_buffer()
+{
+	if (!uniform_ring_)
+		throw std::runtime_error("No uniform buffer, set uniform_buffer_size in the application config");
+	return *uniform_ring_;
+}
+
+asset_manager & application::assets()
+{
+	if (!assets_)
+	{
+		std::unique_ptr<shared_context> context;
+		if (upload_context_)
+			context = headless_ ? headless_->create_shared() : shared_context::create(window_, gl_context_);
+		assets_ = std::make_unique<asset_manager>(asset_threads_, asset_upload_budget_ms_, std::move(context));
+	}
+	return *assets_;
+}
+
+void application::on_event(std::function<void(SDL_Event const &)> handler)
+{
+	event_handler_ = std::move(handler);
+}
+
+void application::on_resize(std::function<void(int width, int height)> handler)
+{
+	resize_handler_ = std::move(handler);
+}
+
+void application::run(std::function<void(float dt)> const & frame)
+{
+	report_startup();
+
+	// Setup code changes the state with raw GL calls
+	state_.invalidate();
+
+	if (headless_)
+		run_headless(frame);
+	else
+		run_windowed(frame);
+}
+
+void application::run(float step, std::function<void(float step)> const & update, std::function<void(float alpha)> const & render)
+{
+	fixed_clock clock(step);
+
+	run([&](float dt)
+	{
+		for (int steps = clock.advance(dt); steps > 0; --steps)
+			update(step);
+		render(clock.alpha());
+	});
+}
+
+void application::dispatch(SDL_Event const & event)
+{
+	input_.handle(event);
+
+	switch (event.type)
+	{
+	case SDL_QUIT:
+		running_ = false;
+		break;
+	case SDL_WINDOWEVENT: switch (event.window.event)
+		{
+		case SDL_WINDOWEVENT_RESIZED:
+			width_ = event.window.data1;
+			height_ = event.window.data2;
+			state_.viewport(0, 0, width_, height_);
+			if (resize_handler_)
+				resize_handler_(width_, height_);
+			break;
+		}
+		break;
+	}
+
+	if (event_handler_)
+		event_handler_(event);
+}
+
+// Replaces dt and the input events of the frame with the recorded ones
+// when replaying, and records them when recording
+bool application::next_session_frame(float & dt)
+{
+	if (player_)
+	{
+		if (!player_->read_frame(dt, session_events_))
+			return false;
+		for (auto const & event : session_events_)
+			dispatch(event);
+	}
+
+	if (recorder_)
+		recorder_->write_frame(dt, session_events_);
+
+	session_events_.clear();
+	return true;
+}
+
+void application::run_windowed(std::function<void(float dt)> const & frame)
+{
+	auto last_frame_start = std::chrono::high_resolution_clock::now();
+
+	int report_frames_count = 0;
+	float report_time = 0.f;
+	auto report_counters = current_counters();
+
+	running_ = true;
+	while (running_)
+	{
+		input_.begin_frame();
+
+		for (SDL_Event event; SDL_PollEvent(&event);)
+		{
+			if (is_session_event(event))
+			{
+				// Live input is ignored while replaying
+				if (player_)
+					continue;
+				if (recorder_)
+					session_events_.push_back(event);
+			}
+
+			dispatch(event);
+		}
+
+		if (!running_)
+			break;
+
+		auto now = std::chrono::high_resolution_clock::now();
+		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
+		last_frame_start = now;
+
+		if (!next_session_frame(dt) || !running_)
+			break;
+
+		render_frame(frame, dt);
+
+		SDL_GL_SwapWindow(window_);
+
+		if (report_interval_ > 0.f)
+		{
+			++report_frames_count;
+			report_time += dt;
+			if (report_time >= report_interval_)
+			{
+				report_frames(report_frames_count, report_time, report_counters);
+				report_frames_count = 0;
+				report_time = 0.f;
+				report_counters = current_counters();
+			}
+		}
+	}
+}
+
+void application::run_headless(std::function<void(float dt)> const & frame)
+{
+	// Animations advance by a fixed step so that every run renders the
+	// same frames regardless of how slow the renderer is
+	float const default_dt = 1.f / 60.f;
+
+	std::vector<double> frame_ms;
+	frame_ms.reserve(frames_);
+
+	auto run_start = std::chrono::high_resolution_clock::now();
+	auto run_counters = current_counters();
+
+	running_ = true;
+	for (int i = 0; (player_ || i < frames_) && running_; ++i)
+	{
+		input_.begin_frame();
+
+		float dt = default_dt;
+		if (!next_session_frame(dt) || !running_)
+			break;
+
+		auto frame_start = std::chrono::high_resolution_clock::now();
+
+		render_frame(frame, dt);
+
+		// Stands in for the swap, otherwise the GPU work of a frame would
+		// be attributed to whichever later call happens to wait for it
+		glFinish();
+
+		frame_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frame_start).count());
+	}
+
+	double total_s = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - run_start).count();
+
+	if (frame_ms.empty())
+		return;
+
+	std::sort(frame_ms.begin(), frame_ms.end());
+	auto percentile = [&](double p)
+	{
+		return frame_ms[std::min(frame_ms.size() - 1, std::size_t(p * frame_ms.size()))];
+	};
+
+	double mean_ms = 0.0;
+	for (double ms : frame_ms)
+		mean_ms += ms;
+	mean_ms /= frame_ms.size();
+
+	std::cout << "Headless: " << frame_ms.size() << " frames at " << width_ << "x" << height_
+		<< " on " << glGetString(GL_RENDERER) << " in " << total_s << " s" << std::endl;
+	std::cout << "Frame time: mean " << mean_ms << " ms, min " << frame_ms.front()
+		<< " ms, median " << percentile(0.5) << " ms, p95 " << percentile(0.95)
+		<< " ms, max " << frame_ms.back() << " ms" << std::endl;
+
+	// Resolves the last frames before their times are printed
+	profiler_.finish();
+
+	report_frames(frame_ms.size(), total_s, run_counters);
+}
+
+void application::render_frame(std::function<void(float dt)> const & frame, float dt)
+{
+	profiler_.begin_frame();
+	if (uniform_ring_)
+		uniform_ring_->begin_frame();
+
+	update_assets();
+
+	frame(dt);
+
+	if (uniform_ring_)
+		uniform_ring_->end_frame();
+	profiler_.end_frame();
+
+	if (!first_frame_reported_)
+	{
+		first_frame_reported_ = true;
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time_).count();
+		std::cout << "First frame: " << ms << " ms after start" << std::endl;
+	}
+}
+
+void application::quit()
+{
+	running_ = false;
+}
+
+// Compare the numbers of a cold (empty cache) and a warm launch to see
+// how much of the startup goes into shader compilation
+void application::report_startup() const
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	double startup_ms = std::chrono::duration<double, std::milli>(now - start_time_).count();
+
+	std::cout << "Startup: " << startup_ms << " ms";
+	if (program_cache_)
+	{
+		auto const & stats = program_cache_->stats();
+		std::cout << ", programs: " << stats.seconds * 1000.0 << " ms ("
+			<< stats.loaded << " cached, " << stats.compiled << " compiled";
+		if (stats.rejected > 0)
+			std::cout << ", " << stats.rejected << " rejected";
+		if (!program_cache_->enabled())
+			std::cout << ", binaries not supported";
+		std::cout << ")";
+	}
+	std::cout << std::endl;
+}
+
+void application::update_assets()
+{
+	if (!assets_)
+		return;
+
+	{
+		profile_scope scope(profiler_, "asset uploads");
+		if ((wait_for_assets_ ? assets_->wait_all() : assets_->update()) > 0)
+			// Uploads bind whatever they need behind the cache's back
+			state_.invalidate();
+	}
+
+	// Time to a complete first view, as opposed to the first frame which
+	// may still show placeholders
+	if (!assets_reported_ && assets_->idle())
+	{
+		assets_reported_ = true;
+		auto const & stats = assets_->stats();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time_).count();
+		std::cout << "Assets: " << stats.uploaded << " loaded " << ms << " ms after start, uploads "
+			<< stats.upload_ms << " ms in " << stats.slices << " slices (longest " << stats.max_upload_ms << " ms) ";
+		if (assets_->background_uploads())
+			std::cout << "on the upload context, fence waits " << stats.fence_wait_ms << " ms" << std::endl;
+		else
+			std::cout << "on the render thread, " << stats.over_budget_frames << " frames over the "
+				<< asset_upload_budget_ms_ << " ms budget, " << stats.deferred_frames << " frames deferred" << std::endl;
+	}
+}
+
+application::counters application::current_counters()
+{
+	return {uniform_counters(), state_counters(), allocation_count(), meshlet_counters()};
+}
+
+void application::report_frames(int frames, float seconds, counters const & since)
+{
+	auto now = current_counters();
+	std::cout << frames / seconds << " FPS, uniform calls per frame: "
+		<< double(now.uniforms.issued - since.uniforms.issued) / frames << " issued, "
+		<< double(now.uniforms.skipped - since.uniforms.skipped) / frames << " skipped"
+		<< ", state calls per frame: "
+		<< double(now.state.issued - since.state.issued) / frames << " issued, "
+		<< double(now.state.filtered - since.state.filtered) / frames << " filtered";
+	if (allocation_counting())
+		std::cout << ", allocations per frame: " << double(now.allocations - since.allocations) / frames;
+	if (auto meshlets = now.meshlets.meshlets - since.meshlets.meshlets; meshlets > 0)
+		std::cout << ", meshlets per frame: " << double(meshlets) / frames << " tested, "
+			<< double(now.meshlets.triangles_drawn - since.meshlets.triangles_drawn) / frames << " triangles drawn of "
+			<< double(now.meshlets.triangles - since.meshlets.triangles) / frames
+			<< " in " << double(now.meshlets.draws - since.meshlets.draws) / frames << " draws";
+	std::cout << std::endl;
+	profiler_.print_summary(std::cout);
+}
+
+}
@@ -0,0 +1,348 @@
+#include <engine/assets.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace engine
+{
+
+namespace
+{
+
+double milliseconds_since(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// True once the fence is signaled, false if the timeout expired first
+bool wait_fence(GLsync fence, std::string const & name, GLuint64 timeout_ns)
+{
+	switch (glClientWaitSync(fence, 0, timeout_ns))
+	{
+	case GL_ALREADY_SIGNALED:
+	case GL_CONDITION_SATISFIED:
+		return true;
+	case GL_TIMEOUT_EXPIRED:
+		return false;
+	default:
+		throw std::runtime_error("Failed to wait for the upload of " + name);
+	}
+}
+
+}
+
+asset_manager::asset_manager(unsigned threads, double upload_budget_ms, std::unique_ptr<shared_context> context)
+	: upload_budget_ms_(upload_budget_ms)
+{
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	workers_.reserve(threads);
+	for (unsigned i = 0; i < threads; ++i)
+		workers_.emplace_back([this]{ worker(); });
+
+	if (context)
+	{
+		context_ = std::move(context);
+
+		std::promise<bool> started;
+		auto result = started.get_future();
+		uploader_ = std::thread([this, &started]{ uploader(started); });
+
+		// Not every platform can bind a context on another thread
+		if (!result.get())
+		{
+			uploader_.join();
+			context_.reset();
+		}
+	}
+}
+
+asset_manager::~asset_manager()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	requests_ready_.notify_all();
+
+	for (auto & thread : workers_)
+		thread.join();
+
+	if (uploader_.joinable())
+	{
+		stopping_uploader_ = true;
+		decoded_count_.fetch_add(1, std::memory_order_release);
+		decoded_count_.notify_all();
+		uploader_.join();
+	}
+
+	for (auto request : requests_)
+		delete request;
+
+	collect(decoded_, uploads_);
+	collect(uploaded_, uploads_);
+	for (auto const & j : uploads_)
+		if (j->fence)
+			glDeleteSync(j->fence);
+}
+
+asset asset_manager::load(std::string name, decode_function decode)
+{
+	auto request = std::make_unique<job>();
+	request->slot = std::make_shared<asset::slot>();
+	request->slot->name = std::move(name);
+	request->decode = std::move(decode);
+
+	asset result;
+	result.slot_ = request->slot;
+
+	{
+		std::lock_guard lock(mutex_);
+		requests_.push_back(request.release());
+	}
+	requests_ready_.notify_one();
+
+	++stats_.requested;
+	return result;
+}
+
+void asset_manager::worker()
+{
+	while (true)
+	{
+		job * j;
+		{
+			std::unique_lock lock(mutex_);
+			requests_ready_.wait(lock, [this]{ return stopping_ || !requests_.empty(); });
+			if (stopping_)
+				return;
+			j = requests_.front();
+			requests_.pop_front();
+		}
+
+		try
+		{
+			j->upload = j->decode();
+		}
+		catch (...)
+		{
+			j->error = std::current_exception();
+		}
+		// The decode step stays with the job, so that whatever it holds is
+		// released where jobs are freed, on the render thread
+
+		push(decoded_, j);
+		decoded_count_.fetch_add(1, std::memory_order_release);
+		decoded_count_.notify_all();
+	}
+}
+
+// Runs every upload step to completion on the shared context, unless the
+// manager is being destroyed, and fences it; the fence is flushed right
+// away so that the render thread polling it does not wait for this
+// context to flush on its own
+void asset_manager::uploader(std::promise<bool> & started)
+{
+	if (!context_->make_current())
+	{
+		started.set_value(false);
+		return;
+	}
+	started.set_value(true);
+
+	job_queue pending;
+	while (!stopping_uploader_)
+	{
+		auto decoded = decoded_count_.load(std::memory_order_acquire);
+
+		collect(decoded_, pending);
+		if (pending.empty())
+		{
+			decoded_count_.wait(decoded, std::memory_order_acquire);
+			continue;
+		}
+
+		for (; !pending.empty() && !stopping_uploader_; pending.pop_front())
+		{
+			auto & j = *pending.front();
+			bool done = upload_slice(j);
+			while (!done && !stopping_uploader_)
+				done = upload_slice(j);
+			if (!done)
+				break;
+
+			if (!j.error)
+			{
+				j.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				glFlush();
+			}
+
+			push(uploaded_, pending.front().release());
+			uploaded_count_.fetch_add(1, std::memory_order_release);
+			uploaded_count_.notify_all();
+		}
+	}
+
+	// Jobs abandoned on destruction are freed by the destructor, on the
+	// render thread, whose context is still current to delete whatever
+	// GL objects their steps hold
+	for (; !pending.empty(); pending.pop_front())
+		push(uploaded_, pending.front().release());
+
+	context_->release();
+}
+
+void asset_manager::push(std::atomic<job *> & stack, job * j)
+{
+	j->next = stack.load(std::memory_order_relaxed);
+	while (!stack.compare_exchange_weak(j->next, j, std::memory_order_release, std::memory_order_relaxed))
+	{}
+}
+
+// Moves everything pushed onto the stack so far to the end of the queue
+void asset_manager::collect(std::atomic<job *> & stack, job_queue & queue)
+{
+	job * head = stack.exchange(nullptr, std::memory_order_acquire);
+	if (!head)
+		return;
+
+	// The stack holds the newest job first
+	std::size_t first = queue.size();
+	for (job * j = head; j;)
+		queue.emplace_back(std::exchange(j, j->next));
+	std::reverse(queue.begin() + first, queue.end());
+}
+
+// Returns true once the job needs no more calls
+bool asset_manager::upload_slice(job & j)
+{
+	if (j.error || !j.upload)
+		return true;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	bool done;
+	try
+	{
+		done = j.upload();
+	}
+	catch (...)
+	{
+		j.error = std::current_exception();
+		done = true;
+	}
+	double ms = milliseconds_since(start);
+
+	j.upload_ms += ms;
+	j.max_upload_ms = std::max(j.max_upload_ms, ms);
+	++j.slices;
+	return done;
+}
+
+void asset_manager::publish(job & j)
+{
+	if (j.fence)
+		glDeleteSync(std::exchange(j.fence, nullptr));
+
+	if (j.error)
+	{
+		try
+		{
+			std::rethrow_exception(j.error);
+		}
+		catch (std::exception const & e)
+		{
+			throw std::runtime_error("Failed to load " + j.slot->name + ": " + e.what());
+		}
+	}
+
+	stats_.upload_ms += j.upload_ms;
+	stats_.max_upload_ms = std::max(stats_.max_upload_ms, j.max_upload_ms);
+	stats_.slices += j.slices;
+	++stats_.uploaded;
+	j.slot->ready = true;
+}
+
+std::size_t asset_manager::update()
+{
+	if (context_)
+	{
+		collect(uploaded_, uploads_);
+		for (auto it = uploads_.begin(); it != uploads_.end();)
+		{
+			auto & j = **it;
+			if (j.fence && !wait_fence(j.fence, j.slot->name, 0))
+			{
+				++it;
+				continue;
+			}
+			publish(j);
+			it = uploads_.erase(it);
+		}
+		return 0;
+	}
+
+	collect(decoded_, uploads_);
+	if (uploads_.empty())
+		return 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::size_t count = 0;
+	do
+	{
+		auto & j = *uploads_.front();
+		++count;
+		if (upload_slice(j))
+		{
+			publish(j);
+			uploads_.pop_front();
+		}
+	}
+	while (!uploads_.empty() && milliseconds_since(start) < upload_budget_ms_);
+
+	if (milliseconds_since(start) > upload_budget_ms_)
+		++stats_.over_budget_frames;
+	if (!uploads_.empty())
+		++stats_.deferred_frames;
+
+	return count;
+}
+
+std::size_t asset_manager::wait_all()
+{
+	std::size_t count = 0;
+	while (!idle())
+	{
+		auto & stack = context_ ? uploaded_ : decoded_;
+		auto & stack_count = context_ ? uploaded_count_ : decoded_count_;
+		auto pushed = stack_count.load(std::memory_order_acquire);
+
+		collect(stack, uploads_);
+		for (; !uploads_.empty(); uploads_.pop_front())
+		{
+			auto & j = *uploads_.front();
+			if (j.fence)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				while (!wait_fence(j.fence, j.slot->name, 1'000'000'000))
+				{}
+				stats_.fence_wait_ms += milliseconds_since(start);
+			}
+			else if (!context_)
+			{
+				for (++count; !upload_slice(j); ++count)
+				{}
+			}
+			publish(j);
+		}
+
+		if (!idle())
+			stack_count.wait(pushed, std::memory_order_acquire);
+	}
+	return count;
+}
+
+}
@@ -0,0 +1,648 @@
+#include <engine/bvh.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_BVH_SSE
+#include <emmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+float const inf = std::numeric_limits<float>::infinity();
+
+std::size_t const bin_count = 16;
+// Deeper nodes are made leaves whatever their size, which bounds the
+// traversal stacks
+std::size_t const max_depth = 60;
+std::size_t const ray_chunk_size = 1024;
+
+struct aabb
+{
+	glm::vec3 min{inf};
+	glm::vec3 max{-inf};
+
+	void grow(glm::vec3 const & p)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	void grow(aabb const & other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	float area() const
+	{
+		auto d = max - min;
+		if (d.x < 0.f || d.y < 0.f || d.z < 0.f)
+			return 0.f;
+		return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+};
+
+float area(bvh_node const & node)
+{
+	return aabb{node.bounds_min, node.bounds_max}.area();
+}
+
+// Splits ranges of triangle references; subtrees of disjoint ranges can
+// be built concurrently into separate node arrays
+struct builder
+{
+	std::span<aabb const> bounds;
+	std::span<glm::vec3 const> centroids;
+	std::span<std::uint32_t> refs;
+	std::size_t max_leaf_size;
+
+	// Sets the bounds of the node and either makes it a leaf or returns
+	// true with the range partitioned at mid
+	bool split(bvh_node & node, std::uint32_t begin, std::uint32_t end, std::size_t depth, std::uint32_t & mid) const
+	{
+		aabb node_bounds, centroid_bounds;
+		for (auto i = begin; i < end; ++i)
+		{
+			node_bounds.grow(bounds[refs[i]]);
+			centroid_bounds.grow(centroids[refs[i]]);
+		}
+
+		node.bounds_min = node_bounds.min;
+		node.bounds_max = node_bounds.max;
+		node.first = begin;
+		node.count = end - begin;
+
+		std::size_t count = end - begin;
+		if (count <= 1 || depth >= max_depth)
+			return false;
+
+		// Cost of a split relative to intersecting every triangle, with a
+		// traversal step as expensive as one triangle test
+		float best_cost = inf;
+		int best_axis = -1;
+		std::size_t best_bin = 0;
+		auto extent = centroid_bounds.max - centroid_bounds.min;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (!(extent[axis] > 0.f))
+				continue;
+
+			float scale = bin_count / extent[axis];
+			std::array<aabb, bin_count> bins;
+			std::array<std::uint32_t, bin_count> counts{};
+			for (auto i = begin; i < end; ++i)
+			{
+				auto bin = std::min(bin_count - 1, std::size_t((centroids[refs[i]][axis] - centroid_bounds.min[axis]) * scale));
+				bins[bin].grow(bounds[refs[i]]);
+				++counts[bin];
+			}
+
+			// Areas and counts left of every boundary, then the sweep from
+			// the right evaluates all of them
+			std::array<float, bin_count - 1> left_area;
+			std::array<std::uint32_t, bin_count - 1> left_count;
+			aabb left;
+			std::uint32_t left_sum = 0;
+			for (std::size_t b = 0; b + 1 < bin_count; ++b)
+			{
+				left.grow(bins[b]);
+				left_sum += counts[b];
+				left_area[b] = left.area();
+				left_count[b] = left_sum;
+			}
+
+			aabb right;
+			std::uint32_t right_sum = 0;
+			for (std::size_t b = bin_count - 1; b > 0; --b)
+			{
+				right.grow(bins[b]);
+				right_sum += counts[b];
+				if (left_count[b - 1] == 0 || right_sum == 0)
+					continue;
+				float cost = left_area[b - 1] * left_count[b - 1] + right.area() * right_sum;
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_bin = b;
+				}
+			}
+		}
+
+		float node_area = node_bounds.area();
+		float split_cost = node_area > 0.f ? 1.f + best_cost / node_area : inf;
+		if (split_cost >= float(count) && count <= max_leaf_size)
+			return false;
+
+		std::uint32_t * split_point = nullptr;
+		if (best_axis >= 0)
+		{
+			float scale = bin_count / extent[best_axis];
+			float origin = centroid_bounds.min[best_axis];
+			split_point = std::partition(refs.data() + begin, refs.data() + end, [&](std::uint32_t ref)
+			{
+				return std::min(bin_count - 1, std::size_t((centroids[ref][best_axis] - origin) * scale)) < best_bin;
+			});
+		}
+
+		// All centroids in one place: any split is as good as another
+		mid = split_point ? static_cast<std::uint32_t>(split_point - refs.data()) : begin + (end - begin) / 2;
+		return true;
+	}
+
+	void build(std::vector<bvh_node> & nodes, std::uint32_t node, std::uint32_t begin, std::uint32_t end, std::size_t depth) const
+	{
+		std::uint32_t mid;
+		if (!split(nodes[node], begin, end, depth, mid))
+			return;
+
+		auto children = static_cast<std::uint32_t>(nodes.size());
+		nodes[node].first = children;
+		nodes[node].count = 0;
+		nodes.resize(nodes.size() + 2);
+		build(nodes, children, begin, mid, depth + 1);
+		build(nodes, children + 1, mid, end, depth + 1);
+	}
+};
+
+// Entry distance of the ray into the box, infinity if it misses it
+float box_entry(glm::vec3 const & min, glm::vec3 const & max, glm::vec3 const & origin, glm::vec3 const & inverse_direction,
+	float t_min, float t_max)
+{
+	float enter = t_min;
+	float exit = t_max;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float t0 = (min[axis] - origin[axis]) * inverse_direction[axis];
+		float t1 = (max[axis] - origin[axis]) * inverse_direction[axis];
+		enter = std::max(enter, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+	}
+	return enter <= exit ? enter : inf;
+}
+
+float box_entry(bvh_node const & node, glm::vec3 const & origin, glm::vec3 const & inverse_direction, float t_min, float t_max)
+{
+	return box_entry(node.bounds_min, node.bounds_max, origin, inverse_direction, t_min, t_max);
+}
+
+std::uint32_t collapse(std::vector<bvh4_node> & wide, std::span<bvh_node const> nodes, std::uint32_t node)
+{
+	// The children of the node, the largest inner one replaced by its
+	// own children until there are four
+	std::array<std::uint32_t, 4> children;
+	std::size_t child_count = 0;
+	if (nodes[node].count > 0)
+		children[child_count++] = node;
+	else
+	{
+		children[child_count++] = nodes[node].first;
+		children[child_count++] = nodes[node].first + 1;
+	}
+
+	while (child_count < 4)
+	{
+		std::size_t largest = child_count;
+		for (std::size_t k = 0; k < child_count; ++k)
+			if (nodes[children[k]].count == 0 && (largest == child_count || area(nodes[children[k]]) > area(nodes[children[largest]])))
+				largest = k;
+		if (largest == child_count)
+			break;
+
+		auto first = nodes[children[largest]].first;
+		children[largest] = first;
+		children[child_count++] = first + 1;
+	}
+
+	auto index = static_cast<std::uint32_t>(wide.size());
+	wide.emplace_back();
+	for (std::size_t k = 0; k < 4; ++k)
+	{
+		bvh_node empty{glm::vec3(inf), 0, glm::vec3(-inf), 0};
+		auto const & child = k < child_count ? nodes[children[k]] : empty;
+
+		auto & w = wide[index];
+		w.min_x[k] = child.bounds_min.x;
+		w.min_y[k] = child.bounds_min.y;
+		w.min_z[k] = child.bounds_min.z;
+		w.max_x[k] = child.bounds_max.x;
+		w.max_y[k] = child.bounds_max.y;
+		w.max_z[k] = child.bounds_max.z;
+		w.child[k] = k < child_count && child.count > 0 ? child.first : no_hit;
+		w.count[k] = child.count;
+	}
+
+	// Recursion grows the array, so the node is written through its index
+	for (std::size_t k = 0; k < child_count; ++k)
+		if (nodes[children[k]].count == 0)
+		{
+			auto child = collapse(wide, nodes, children[k]);
+			wide[index].child[k] = child;
+		}
+
+	return index;
+}
+
+}
+
+ray screen_ray(glm::mat4 const & projection, glm::mat4 const & view, float x, float y, float width, float height)
+{
+	glm::vec2 ndc(2.f * (x + 0.5f) / width - 1.f, 1.f - 2.f * (y + 0.5f) / height);
+	auto inverse = glm::inverse(projection * view);
+	auto near = inverse * glm::vec4(ndc, -1.f, 1.f);
+	auto far = inverse * glm::vec4(ndc, 1.f, 1.f);
+
+	// t = 1 is the far plane
+	ray result;
+	result.origin = glm::vec3(near) / near.w;
+	result.direction = glm::vec3(far) / far.w - result.origin;
+	result.t_max = 1.f;
+	return result;
+}
+
+bvh::bvh(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions, bvh_options const & options)
+{
+	if (indices.size() % 3 != 0)
+		throw std::runtime_error("Index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+	for (auto index : indices)
+		if (index >= positions.size())
+			throw std::runtime_error("Index " + std::to_string(index) + " out of range, "
+				+ std::to_string(positions.size()) + " vertices");
+
+	auto const triangle_count = static_cast<std::uint32_t>(indices.size() / 3);
+	if (triangle_count == 0)
+		return;
+
+	std::vector<aabb> bounds(triangle_count);
+	std::vector<glm::vec3> centroids(triangle_count);
+	triangle_ids_.resize(triangle_count);
+	parallel_for_chunks(options.pool, triangle_count, 4096, [&](std::size_t first, std::size_t last)
+	{
+		for (auto t = first; t < last; ++t)
+		{
+			for (int k = 0; k < 3; ++k)
+				bounds[t].grow(positions[indices[3 * t + k]]);
+			centroids[t] = (bounds[t].min + bounds[t].max) * 0.5f;
+			triangle_ids_[t] = static_cast<std::uint32_t>(t);
+		}
+	});
+
+	builder build{bounds, centroids, triangle_ids_, std::max<std::size_t>(options.max_leaf_size, 1)};
+
+	nodes_.reserve(2 * triangle_count);
+	nodes_.resize(1);
+
+	if (!options.pool || options.pool->size() == 1)
+		build.build(nodes_, 0, 0, triangle_count, 0);
+	else
+	{
+		// The top levels are split here until the ranges are small enough
+		// to keep every thread busy, then their subtrees are built
+		// concurrently into their own arrays and appended
+		struct task
+		{
+			std::uint32_t node, begin, end, depth;
+		};
+
+		std::size_t const subtree_size = std::max<std::size_t>(triangle_count / (8 * options.pool->size()), 1024);
+		std::vector<task> pending{{0, 0, triangle_count, 0}};
+		std::vector<task> subtrees;
+		while (!pending.empty())
+		{
+			auto t = pending.back();
+			pending.pop_back();
+			if (t.end - t.begin <= subtree_size)
+			{
+				subtrees.push_back(t);
+				continue;
+			}
+
+			std::uint32_t mid;
+			if (!build.split(nodes_[t.node], t.begin, t.end, t.depth, mid))
+				continue;
+
+			auto children = static_cast<std::uint32_t>(nodes_.size());
+			nodes_[t.node].first = children;
+			nodes_[t.node].count = 0;
+			nodes_.resize(nodes_.size() + 2);
+			pending.push_back({children, t.begin, mid, t.depth + 1});
+			pending.push_back({children + 1, mid, t.end, t.depth + 1});
+		}
+
+		std::vector<std::vector<bvh_node>> subtree_nodes(subtrees.size());
+		options.pool->parallel_for(subtrees.size(), [&](std::size_t i)
+		{
+			auto const & t = subtrees[i];
+			subtree_nodes[i].reserve(2 * (t.end - t.begin));
+			subtree_nodes[i].resize(1);
+			build.build(subtree_nodes[i], 0, t.begin, t.end, t.depth);
+		});
+
+		for (std::size_t i = 0; i < subtrees.size(); ++i)
+		{
+			auto base = static_cast<std::uint32_t>(nodes_.size());
+			auto relocate = [base](bvh_node node)
+			{
+				if (node.count == 0)
+					node.first += base - 1;
+				return node;
+			};
+
+			auto const & local = subtree_nodes[i];
+			nodes_[subtrees[i].node] = relocate(local[0]);
+			for (std::size_t n = 1; n < local.size(); ++n)
+				nodes_.push_back(relocate(local[n]));
+		}
+	}
+	nodes_.shrink_to_fit();
+
+	triangles_.resize(triangle_count);
+	parallel_for_chunks(options.pool, triangle_count, 4096, [&](std::size_t first, std::size_t last)
+	{
+		for (auto t = first; t < last; ++t)
+		{
+			auto id = triangle_ids_[t];
+			auto const & v0 = positions[indices[3 * id]];
+			triangles_[t] = {v0, positions[indices[3 * id + 1]] - v0, positions[indices[3 * id + 2]] - v0};
+		}
+	});
+
+	if (options.wide)
+		collapse(wide_nodes_, nodes_, 0);
+}
+
+template <bool Any>
+bool bvh::intersect_leaf(ray const & r, std::uint32_t first, std::uint32_t count, ray_hit & hit) const
+{
+	bool found = false;
+	for (auto i = first; i < first + count; ++i)
+	{
+		auto const & tri = triangles_[i];
+
+		auto p = glm::cross(r.direction, tri.e2);
+		float det = glm::dot(tri.e1, p);
+		if (det == 0.f)
+			continue;
+		float inverse_det = 1.f / det;
+
+		auto s = r.origin - tri.v0;
+		float u = glm::dot(s, p) * inverse_det;
+		if (u < 0.f || u > 1.f)
+			continue;
+
+		auto q = glm::cross(s, tri.e1);
+		float v = glm::dot(r.direction, q) * inverse_det;
+		if (v < 0.f || u + v > 1.f)
+			continue;
+
+		float t = glm::dot(tri.e2, q) * inverse_det;
+		if (t < r.t_min || t > hit.t)
+			continue;
+
+		hit = {triangle_ids_[i], t, u, v};
+		found = true;
+		if constexpr (Any)
+			return true;
+	}
+	return found;
+}
+
+template <bool Any>
+bool bvh::traverse(ray const & r, ray_hit & hit) const
+{
+	auto inverse_direction = 1.f / r.direction;
+
+	std::uint32_t stack[max_depth + 4];
+	std::size_t stack_size = 0;
+
+	if (box_entry(nodes_[0], r.origin, inverse_direction, r.t_min, hit.t) == inf)
+		return false;
+
+	bool found = false;
+	std::uint32_t node = 0;
+	while (true)
+	{
+		auto const & n = nodes_[node];
+		if (n.count > 0)
+		{
+			if (intersect_leaf<Any>(r, n.first, n.count, hit))
+			{
+				found = true;
+				if constexpr (Any)
+					return true;
+			}
+		}
+		else
+		{
+			float near = box_entry(nodes_[n.first], r.origin, inverse_direction, r.t_min, hit.t);
+			float far = box_entry(nodes_[n.first + 1], r.origin, inverse_direction, r.t_min, hit.t);
+			auto near_node = n.first;
+			auto far_node = n.first + 1;
+			if (far < near)
+			{
+				std::swap(near, far);
+				std::swap(near_node, far_node);
+			}
+
+			if (near != inf)
+			{
+				if (far != inf)
+					stack[stack_size++] = far_node;
+				node = near_node;
+				continue;
+			}
+		}
+
+		if (stack_size == 0)
+			break;
+		node = stack[--stack_size];
+	}
+	return found;
+}
+
+template <bool Any>
+bool bvh::traverse_wide(ray const & r, ray_hit & hit) const
+{
+	auto inverse_direction = 1.f / r.direction;
+
+	// Wide nodes with their entry distances, skipped once a closer hit
+	// was found
+	struct entry
+	{
+		std::uint32_t node;
+		float t;
+	};
+	entry stack[3 * max_depth + 4];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = {0, r.t_min};
+
+	bool found = false;
+	while (stack_size > 0)
+	{
+		auto e = stack[--stack_size];
+		if (e.t > hit.t)
+			continue;
+
+		auto const & n = wide_nodes_[e.node];
+
+		alignas(16) float enter[4];
+		int mask = 0;
+#ifdef ENGINE_BVH_SSE
+		{
+			auto slab = [](float const * min, float const * max, float origin, float inverse, __m128 & near, __m128 & far)
+			{
+				__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(min), _mm_set1_ps(origin)), _mm_set1_ps(inverse));
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(max), _mm_set1_ps(origin)), _mm_set1_ps(inverse));
+				near = _mm_max_ps(near, _mm_min_ps(t0, t1));
+				far = _mm_min_ps(far, _mm_max_ps(t0, t1));
+			};
+
+			__m128 near = _mm_set1_ps(r.t_min);
+			__m128 far = _mm_set1_ps(hit.t);
+			slab(n.min_x, n.max_x, r.origin.x, inverse_direction.x, near, far);
+			slab(n.min_y, n.max_y, r.origin.y, inverse_direction.y, near, far);
+			slab(n.min_z, n.max_z, r.origin.z, inverse_direction.z, near, far);
+			_mm_store_ps(enter, near);
+			mask = _mm_movemask_ps(_mm_cmple_ps(near, far));
+		}
+#else
+		for (int k = 0; k < 4; ++k)
+		{
+			enter[k] = box_entry({n.min_x[k], n.min_y[k], n.min_z[k]}, {n.max_x[k], n.max_y[k], n.max_z[k]},
+				r.origin, inverse_direction, r.t_min, hit.t);
+			mask |= (enter[k] != inf) << k;
+		}
+#endif
+
+		// Leaves are intersected right away, the closest inner child is
+		// pushed last to be visited first
+		entry inner[4];
+		std::size_t inner_count = 0;
+		for (int k = 0; k < 4; ++k)
+		{
+			if (!(mask >> k & 1) || (n.count[k] == 0 && n.child[k] == no_hit))
+				continue;
+
+			if (n.count[k] == 0)
+				inner[inner_count++] = {n.child[k], enter[k]};
+			else if (intersect_leaf<Any>(r, n.child[k], n.count[k], hit))
+			{
+				found = true;
+				if constexpr (Any)
+					return true;
+			}
+		}
+
+		// Insertion into the stack, farthest first
+		for (std::size_t k = 0; k < inner_count; ++k)
+		{
+			auto position = stack_size++;
+			for (; position > stack_size - 1 - k && stack[position - 1].t < inner[k].t; --position)
+				stack[position] = stack[position - 1];
+			stack[position] = inner[k];
+		}
+	}
+	return found;
+}
+
+ray_hit bvh::closest_hit(ray const & r) const
+{
+	ray_hit hit;
+	hit.t = r.t_max;
+	bool found = false;
+	if (!nodes_.empty())
+		found = wide_nodes_.empty() ? traverse<false>(r, hit) : traverse_wide<false>(r, hit);
+	return found ? hit : ray_hit{};
+}
+
+bool bvh::any_hit(ray const & r) const
+{
+	ray_hit hit;
+	hit.t = r.t_max;
+	if (nodes_.empty())
+		return false;
+	return wide_nodes_.empty() ? traverse<true>(r, hit) : traverse_wide<true>(r, hit);
+}
+
+void bvh::closest_hit(std::span<ray const> rays, std::span<ray_hit> hits, thread_pool * pool) const
+{
+	if (hits.size() != rays.size())
+		throw std::runtime_error("Expected " + std::to_string(rays.size()) + " hits, got " + std::to_string(hits.size()));
+
+	parallel_for_chunks(pool, rays.size(), ray_chunk_size, [&](std::size_t first, std::size_t last)
+	{
+		for (auto i = first; i < last; ++i)
+			hits[i] = closest_hit(rays[i]);
+	});
+}
+
+void bvh::any_hit(std::span<ray const> rays, std::span<std::uint8_t> occluded, thread_pool * pool) const
+{
+	if (occluded.size() != rays.size())
+		throw std::runtime_error("Expected " + std::to_string(rays.size()) + " results, got " + std::to_string(occluded.size()));
+
+	parallel_for_chunks(pool, rays.size(), ray_chunk_size, [&](std::size_t first, std::size_t last)
+	{
+		for (auto i = first; i < last; ++i)
+			occluded[i] = any_hit(rays[i]);
+	});
+}
+
+std::string bvh_report(bvh const & tree)
+{
+	auto nodes = tree.nodes();
+	if (nodes.empty())
+		return "Empty BVH";
+
+	std::size_t leaves = 0;
+	std::size_t max_depth = 0;
+	float cost = 0.f;
+
+	std::vector<std::pair<std::uint32_t, std::size_t>> stack{{0, 0}};
+	while (!stack.empty())
+	{
+		auto [ node, depth ] = stack.back();
+		stack.pop_back();
+		max_depth = std::max(max_depth, depth);
+
+		auto const & n = nodes[node];
+		if (n.count > 0)
+		{
+			++leaves;
+			cost += area(n) * n.count;
+		}
+		else
+		{
+			cost += area(n);
+			stack.push_back({n.first, depth + 1});
+			stack.push_back({n.first + 1, depth + 1});
+		}
+	}
+
+	float root_area = area(nodes[0]);
+
+	std::ostringstream report;
+	report.precision(3);
+	report << tree.triangle_count() << " triangles, " << nodes.size() << " nodes, " << leaves << " leaves of "
+		<< double(tree.triangle_count()) / leaves << " triangles, depth " << max_depth << ", SAH cost "
+		<< (root_area > 0.f ? cost / root_area : 0.f);
+	if (!tree.wide_nodes().empty())
+		report << ", " << tree.wide_nodes().size() << " four-wide nodes";
+	return report.str();
+}
+
+}
@@ -0,0 +1,147 @@
+#include <engine/headless.hpp>
+#include <engine/error.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#ifdef ENGINE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace engine
+{
+
+#ifdef ENGINE_HAS_EGL
+
+namespace
+{
+
+[[noreturn]] void egl_fail(std::string_view message)
+{
+	throw std::runtime_error(to_string(message) + "EGL error " + std::to_string(eglGetError()));
+}
+
+}
+
+headless_context::headless_context(int width, int height, int multisamples)
+{
+	// The destructor does not run for a throwing constructor
+	try
+	{
+		init(width, height, multisamples);
+	}
+	catch (...)
+	{
+		release();
+		throw;
+	}
+}
+
+void headless_context::init(int width, int height, int multisamples)
+{
+	auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (!get_platform_display)
+		throw std::runtime_error("eglGetPlatformDisplayEXT is not supported");
+
+	EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		egl_fail("eglGetPlatformDisplayEXT: ");
+	if (!eglInitialize(display, nullptr, nullptr))
+		egl_fail("eglInitialize: ");
+	display_ = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+		egl_fail("eglBindAPI: ");
+
+	EGLint const context_attributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE,
+	};
+
+	// EGL_KHR_no_config_context: there is no surface to be compatible with
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+	if (context == EGL_NO_CONTEXT)
+		egl_fail("eglCreateContext: ");
+	context_ = context;
+
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		egl_fail("eglMakeCurrent: ");
+
+	// GLEW built for GLX fails to find an X display, but the GL entry
+	// points are already loaded by then
+	glewExperimental = GL_TRUE;
+	if (auto result = glewInit(); result != GLEW_NO_ERROR && result != GLEW_ERROR_NO_GLX_DISPLAY)
+		glew_fail("glewInit: ", result);
+
+	if (!GLEW_VERSION_3_3)
+		throw std::runtime_error("OpenGL 3.3 is not supported");
+
+	glGenRenderbuffers(1, &color_);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, multisamples, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depth_);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, multisamples, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &framebuffer_);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("Headless framebuffer incomplete");
+
+	// Without a surface the initial viewport is empty
+	glViewport(0, 0, width, height);
+}
+
+headless_context::~headless_context()
+{
+	release();
+}
+
+// GL objects are only created once the context is current and GLEW loaded
+void headless_context::release()
+{
+	if (framebuffer_)
+		glDeleteFramebuffers(1, &framebuffer_);
+	if (color_)
+		glDeleteRenderbuffers(1, &color_);
+	if (depth_)
+		glDeleteRenderbuffers(1, &depth_);
+	if (context_)
+	{
+		eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display_, context_);
+	}
+	if (display_)
+		eglTerminate(display_);
+}
+
+std::unique_ptr<shared_context> headless_context::create_shared() const
+{
+	return shared_context::create_egl(display_, context_);
+}
+
+#else
+
+headless_context::headless_context(int, int, int)
+{
+	throw std::runtime_error("Headless mode requires EGL, which was not found at build time");
+}
+
+headless_context::~headless_context() = default;
+
+std::unique_ptr<shared_context> headless_context::create_shared() const
+{
+	return nullptr;
+}
+
+#endif
+
+}
@@ -0,0 +1,93 @@
+#include <engine/input.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace engine
+{
+
+void input_state::begin_frame()
+{
+	pressed_.reset();
+	released_.reset();
+	mouse_pressed_ = 0;
+	mouse_released_ = 0;
+	mouse_dx_ = 0;
+	mouse_dy_ = 0;
+	wheel_ = 0;
+}
+
+void input_state::handle(SDL_Event const & event)
+{
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		{
+			auto key = event.key.keysym.scancode;
+			bool is_down = event.type == SDL_KEYDOWN;
+			// Auto-repeated key downs do not change anything
+			if (!valid(key) || down_[key] == is_down)
+				break;
+			down_[key] = is_down;
+			(is_down ? pressed_ : released_)[key] = true;
+		}
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+		mouse_down_ |= mask(event.button.button);
+		mouse_pressed_ |= mask(event.button.button);
+		break;
+	case SDL_MOUSEBUTTONUP:
+		mouse_down_ &= ~mask(event.button.button);
+		mouse_released_ |= mask(event.button.button);
+		break;
+	case SDL_MOUSEMOTION:
+		mouse_x_ = event.motion.x;
+		mouse_y_ = event.motion.y;
+		mouse_dx_ += event.motion.xrel;
+		mouse_dy_ += event.motion.yrel;
+		break;
+	case SDL_MOUSEWHEEL:
+		wheel_ += event.wheel.y;
+		break;
+	case SDL_WINDOWEVENT:
+		// Key ups that happen while another window has focus never arrive
+		if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+			release_all();
+		break;
+	}
+}
+
+void input_state::bind(std::size_t action, SDL_Scancode key)
+{
+	if (action >= max_actions)
+		throw std::runtime_error("Input action out of range: " + std::to_string(action));
+
+	auto & b = actions_[action];
+	if (b.count == max_keys_per_action)
+		throw std::runtime_error("Too many keys bound to input action " + std::to_string(action));
+
+	b.keys[b.count++] = key;
+}
+
+bool input_state::any(std::size_t action, key_set const & keys) const
+{
+	if (action >= max_actions)
+		return false;
+
+	auto const & b = actions_[action];
+	for (std::size_t i = 0; i < b.count; ++i)
+		if (valid(b.keys[i]) && keys[b.keys[i]])
+			return true;
+	return false;
+}
+
+void input_state::release_all()
+{
+	released_ |= down_;
+	down_.reset();
+	mouse_released_ |= mouse_down_;
+	mouse_down_ = 0;
+}
+
+}
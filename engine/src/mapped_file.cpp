@@ -0,0 +1,168 @@
+#include <engine/mapped_file.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(std::filesystem::path const & path, bool prefetch)
+{
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open " + path.string());
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to query the size of " + path.string());
+	}
+
+	size_ = static_cast<std::size_t>(size.QuadPart);
+	if (size_ == 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		throw std::runtime_error("Failed to map " + path.string());
+
+	// The view keeps the mapping alive
+	data_ = static_cast<std::byte const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+	if (!data_)
+		throw std::runtime_error("Failed to map " + path.string());
+
+	if (prefetch)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte *>(data_), size_};
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+}
+
+void mapped_file::reset()
+{
+	if (data_)
+		UnmapViewOfFile(data_);
+	data_ = nullptr;
+	size_ = 0;
+}
+
+#else
+
+mapped_file::mapped_file(std::filesystem::path const & path, bool prefetch)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Failed to open " + path.string());
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Failed to query the size of " + path.string());
+	}
+
+	size_ = static_cast<std::size_t>(info.st_size);
+	if (size_ == 0)
+	{
+		close(fd);
+		return;
+	}
+
+	int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	if (prefetch)
+		flags |= MAP_POPULATE;
+#endif
+
+	// The mapping stays valid after the descriptor is closed
+	void * data = mmap(nullptr, size_, PROT_READ, flags, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		size_ = 0;
+		throw std::runtime_error("Failed to map " + path.string());
+	}
+
+#ifndef MAP_POPULATE
+	if (prefetch)
+		madvise(data, size_, MADV_WILLNEED);
+#endif
+
+	data_ = static_cast<std::byte const *>(data);
+}
+
+void mapped_file::reset()
+{
+	if (data_)
+		munmap(const_cast<std::byte *>(data_), size_);
+	data_ = nullptr;
+	size_ = 0;
+}
+
+#endif
+
+mapped_file::~mapped_file()
+{
+	reset();
+}
+
+mapped_file::mapped_file(mapped_file && other) noexcept
+	: data_(std::exchange(other.data_, nullptr))
+	, size_(std::exchange(other.size_, 0))
+{}
+
+mapped_file & mapped_file::operator = (mapped_file && other) noexcept
+{
+	if (this != &other)
+	{
+		reset();
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+	}
+	return *this;
+}
+
+void mapped_reader::expect_end() const
+{
+	if (remaining() != 0)
+		fail(std::to_string(remaining()) + " unexpected bytes at the end");
+}
+
+void mapped_reader::fail(std::string const & message) const
+{
+	throw std::runtime_error(path_.string() + ": " + message);
+}
+
+std::byte const * mapped_reader::take(std::size_t size, std::size_t alignment)
+{
+	if (size > remaining())
+		fail("unexpected end of file at offset " + std::to_string(offset_));
+	// Mappings are page aligned, so the offset alone decides the alignment
+	if (offset_ % alignment != 0)
+		fail("misaligned data at offset " + std::to_string(offset_));
+
+	auto result = file_.data() + offset_;
+	offset_ += size;
+	return result;
+}
+
+}
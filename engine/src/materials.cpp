@@ -0,0 +1,108 @@
+#include <engine/materials.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine
+{
+
+namespace
+{
+
+std::int32_t texture_index(std::vector<std::string> & textures, std::string const & path)
+{
+	if (path.empty())
+		return -1;
+
+	auto it = std::find(textures.begin(), textures.end(), path);
+	if (it == textures.end())
+		it = textures.insert(textures.end(), path);
+	return static_cast<std::int32_t>(it - textures.begin());
+}
+
+}
+
+material_table pack_materials(std::span<obj_material const> materials)
+{
+	if (materials.size() > max_materials)
+		throw std::runtime_error("Too many materials: " + std::to_string(materials.size()) + ", at most "
+			+ std::to_string(max_materials) + " fit in a uniform block");
+
+	material_table result;
+	result.materials.reserve(materials.size());
+	for (auto const & material : materials)
+	{
+		auto & packed = result.materials.emplace_back();
+		packed.diffuse = glm::vec4(material.diffuse, material.opacity);
+		packed.specular = glm::vec4(material.specular, material.shininess);
+		packed.emission = glm::vec4(material.emission, material.refraction_index);
+		packed.maps = glm::ivec4(texture_index(result.textures, material.diffuse_map),
+			texture_index(result.textures, material.normal_map), material.illumination, 0);
+	}
+	return result;
+}
+
+material_batches batch_by_material(obj_model const & model)
+{
+	material_batches result;
+	result.indices.reserve(model.indices.size());
+
+	// Copy of every model vertex for the material being gathered, so that
+	// vertices shared by several materials are split but not duplicated
+	// within one
+	std::uint32_t const none = ~std::uint32_t(0);
+	std::vector<std::uint32_t> copies(model.vertices.size(), none);
+	std::vector<std::uint32_t> copy_material(model.vertices.size(), none);
+
+	auto gather = [&](obj_submesh const & submesh)
+	{
+		for (std::uint32_t i = 0; i < submesh.index_count; ++i)
+		{
+			auto index = model.indices[submesh.first_index + i];
+			if (copy_material[index] != submesh.material)
+			{
+				auto const & v = model.vertices[index];
+				copies[index] = static_cast<std::uint32_t>(result.vertices.size());
+				copy_material[index] = submesh.material;
+				result.vertices.push_back({v.position, v.normal, v.texcoord, submesh.material});
+			}
+			result.indices.push_back(copies[index]);
+		}
+	};
+
+	auto blended = [&](obj_submesh const & submesh)
+	{
+		return model.materials[submesh.material].opacity < 1.f;
+	};
+
+	auto first_opaque = static_cast<std::uint32_t>(result.indices.size());
+	for (auto const & submesh : model.submeshes)
+		if (!blended(submesh))
+			gather(submesh);
+	if (result.indices.size() > first_opaque)
+		result.draws.push_back({first_opaque, static_cast<std::uint32_t>(result.indices.size()) - first_opaque, false});
+
+	for (auto const & submesh : model.submeshes)
+		if (blended(submesh))
+		{
+			auto first = static_cast<std::uint32_t>(result.indices.size());
+			gather(submesh);
+			result.draws.push_back({first, submesh.index_count, true});
+		}
+
+	return result;
+}
+
+std::string material_report(obj_model const & model, material_batches const & batches)
+{
+	std::size_t blended = std::count_if(batches.draws.begin(), batches.draws.end(), [](material_draw const & draw){ return draw.blended; });
+
+	std::ostringstream report;
+	report << model.face_groups << " face groups, " << model.submeshes.size() << " submeshes, "
+		<< batches.draws.size() << " draws (" << batches.draws.size() - blended << " opaque, " << blended << " blended), "
+		<< model.materials.size() << " materials, " << model.vertices.size() << " -> " << batches.vertices.size() << " vertices";
+	return report.str();
+}
+
+}
@@ -0,0 +1,366 @@
+#include <engine/mesh_file.hpp>
+#include <engine/vertex_format.hpp>
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace engine
+{
+
+namespace
+{
+
+std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+std::uint64_t fnv1a(std::uint64_t hash, void const * data, std::size_t size)
+{
+	auto bytes = static_cast<unsigned char const *>(data);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+std::size_t type_size(std::uint32_t type)
+{
+	switch (type)
+	{
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:
+		return 2;
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:
+	case GL_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+		return 4;
+	}
+	return 0;
+}
+
+std::size_t attribute_size(mesh_attribute const & attribute)
+{
+	bool packed = attribute.type == GL_INT_2_10_10_10_REV || attribute.type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	return packed ? 4 : type_size(attribute.type) * attribute.components;
+}
+
+// Attributes read as integers by the shader unless normalized; packed
+// 10_10_10_2 formats can only be read as floats
+bool is_integer(std::uint32_t type)
+{
+	return type_size(type) != 0 && type != GL_FLOAT && type != GL_HALF_FLOAT
+		&& type != GL_INT_2_10_10_10_REV && type != GL_UNSIGNED_INT_2_10_10_10_REV;
+}
+
+void setup_attribute(mesh_attribute const & attribute, std::uint64_t base, std::uint32_t stride)
+{
+	auto offset = reinterpret_cast<void const *>(static_cast<std::uintptr_t>(base + attribute.offset));
+
+	glEnableVertexAttribArray(attribute.location);
+	if (is_integer(attribute.type) && !attribute.normalized)
+		glVertexAttribIPointer(attribute.location, attribute.components, attribute.type, stride, offset);
+	else
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, stride, offset);
+}
+
+}
+
+mesh_file::mesh_file(std::filesystem::path const & path)
+	: mapping_(path)
+	, bytes_(mapping_.bytes())
+{
+	validate(path);
+}
+
+mesh_file::mesh_file(mesh_data const & data, std::uint64_t source_hash)
+{
+	if (data.attributes.size() > mesh_header::max_attributes)
+		throw std::runtime_error("Too many vertex attributes for a mesh file: " + std::to_string(data.attributes.size()));
+	if (data.vertices.size() != data.vertex_count * data.vertex_stride)
+		throw std::runtime_error("Mesh vertex data does not match its count and stride");
+	if (data.lods.size() > mesh_header::max_lods)
+		throw std::runtime_error("Too many levels of detail for a mesh file: " + std::to_string(data.lods.size()));
+
+	mesh_header header{};
+	header.magic = mesh_header::magic_value;
+	header.version = mesh_header::current_version;
+	header.source_hash = source_hash;
+	header.vertex_stride = data.vertex_stride;
+	header.attribute_count = static_cast<std::uint32_t>(data.attributes.size());
+	std::copy(data.attributes.begin(), data.attributes.end(), header.attributes.begin());
+	header.index_type = index_type(data.vertex_count);
+	header.vertex_count = data.vertex_count;
+	header.index_count = data.indices.size();
+	header.lod_count = static_cast<std::uint32_t>(data.lods.size());
+
+	if (!data.attributes.empty() && data.attributes[0].type == GL_FLOAT && data.attributes[0].components == 3 && data.vertex_count > 0)
+	{
+		header.bounds_min = glm::vec3(std::numeric_limits<float>::infinity());
+		header.bounds_max = glm::vec3(-std::numeric_limits<float>::infinity());
+		for (std::uint64_t i = 0; i < data.vertex_count; ++i)
+		{
+			glm::vec3 position;
+			std::memcpy(&position, data.vertices.data() + i * data.vertex_stride + data.attributes[0].offset, sizeof(position));
+			header.bounds_min = glm::min(header.bounds_min, position);
+			header.bounds_max = glm::max(header.bounds_max, position);
+		}
+	}
+	else
+	{
+		header.bounds_min = data.bounds_min;
+		header.bounds_max = data.bounds_max;
+	}
+
+	auto packed_indices = pack_indices(data.indices, header.index_type);
+
+	// The position stream and the other attributes repacked without it,
+	// every attribute 4-byte aligned as GL prefers
+	std::vector<std::byte> positions;
+	std::vector<std::byte> split_vertices;
+	if (data.split_positions && !data.attributes.empty())
+	{
+		auto const & position = data.attributes[0];
+		auto position_size = attribute_size(position);
+		header.position_stride = static_cast<std::uint32_t>(align_up(position_size, 4));
+		header.attributes[0].offset = 0;
+
+		std::uint32_t stride = 0;
+		for (std::size_t a = 1; a < data.attributes.size(); ++a)
+		{
+			header.attributes[a].offset = stride;
+			stride += static_cast<std::uint32_t>(align_up(attribute_size(data.attributes[a]), 4));
+		}
+		header.vertex_stride = stride;
+
+		positions.resize(data.vertex_count * header.position_stride);
+		split_vertices.resize(data.vertex_count * header.vertex_stride);
+		for (std::uint64_t i = 0; i < data.vertex_count; ++i)
+		{
+			auto const * vertex = data.vertices.data() + i * data.vertex_stride;
+			std::memcpy(positions.data() + i * header.position_stride, vertex + position.offset, position_size);
+			for (std::size_t a = 1; a < data.attributes.size(); ++a)
+				std::memcpy(split_vertices.data() + i * header.vertex_stride + header.attributes[a].offset,
+					vertex + data.attributes[a].offset, attribute_size(data.attributes[a]));
+		}
+	}
+	std::span<std::byte const> vertices = header.position_stride ? split_vertices : data.vertices;
+
+	auto const lods_size = data.lods.size() * sizeof(mesh_lod);
+	header.position_offset = align_up(sizeof(mesh_header) + lods_size, mesh_header::section_alignment);
+	header.vertex_offset = align_up(header.position_offset + positions.size(), mesh_header::section_alignment);
+	header.index_offset = align_up(header.vertex_offset + vertices.size(), mesh_header::section_alignment);
+	header.file_size = header.index_offset + packed_indices.size();
+
+	image_.resize(header.file_size);
+	std::memcpy(image_.data(), &header, sizeof(header));
+	std::memcpy(image_.data() + sizeof(header), data.lods.data(), lods_size);
+	std::memcpy(image_.data() + header.position_offset, positions.data(), positions.size());
+	std::memcpy(image_.data() + header.vertex_offset, vertices.data(), vertices.size());
+	std::memcpy(image_.data() + header.index_offset, packed_indices.data(), packed_indices.size());
+
+	bytes_ = image_;
+	header_ = header;
+	validate("mesh data");
+}
+
+void mesh_file::validate(std::filesystem::path const & path)
+{
+	auto fail = [&](std::string const & message)
+	{
+		throw std::runtime_error(path.string() + ": " + message);
+	};
+
+	if (bytes_.size() < sizeof(mesh_header))
+		fail("too small for a mesh file");
+
+	std::memcpy(&header_, bytes_.data(), sizeof(mesh_header));
+
+	if (header_.magic != mesh_header::magic_value)
+		fail("not a mesh file");
+	if (header_.version != mesh_header::current_version)
+		fail("mesh file version " + std::to_string(header_.version) + ", expected " + std::to_string(mesh_header::current_version));
+	if (header_.file_size != bytes_.size())
+		fail("truncated mesh file");
+	if (header_.index_type != GL_UNSIGNED_SHORT && header_.index_type != GL_UNSIGNED_INT)
+		fail("unsupported index type");
+	if (header_.attribute_count > mesh_header::max_attributes)
+		fail("too many vertex attributes");
+	if (header_.lod_count > mesh_header::max_lods)
+		fail("too many levels of detail");
+
+	if (header_.position_stride != 0 && header_.attribute_count == 0)
+		fail("position stream without a position attribute");
+
+	for (std::uint32_t i = 0; i < header_.attribute_count; ++i)
+	{
+		auto const & attribute = header_.attributes[i];
+		auto size = attribute_size(attribute);
+		auto stride = (i == 0 && header_.position_stride != 0) ? header_.position_stride : header_.vertex_stride;
+		if (size == 0 || attribute.components < 1 || attribute.components > 4 || attribute.offset + size > stride)
+			fail("invalid vertex attribute " + std::to_string(i));
+	}
+
+	// The sections follow each other within the file; their sizes are
+	// compared with the room between two offsets, so that no sum of an
+	// offset from a corrupt file and a size can wrap around
+	auto const alignment = mesh_header::section_alignment;
+	auto const max_count = std::numeric_limits<std::uint64_t>::max() / 8;
+	auto const max_stride = std::max<std::uint64_t>({header_.vertex_stride, header_.position_stride, 1});
+	if (header_.vertex_count > max_count / max_stride || header_.index_count > max_count
+		|| header_.position_offset % alignment != 0 || header_.vertex_offset % alignment != 0 || header_.index_offset % alignment != 0
+		|| header_.position_offset < sizeof(mesh_header) + header_.lod_count * sizeof(mesh_lod)
+		|| header_.vertex_offset < header_.position_offset
+		|| header_.index_offset < header_.vertex_offset
+		|| header_.file_size < header_.index_offset
+		|| header_.vertex_count * header_.position_stride > header_.vertex_offset - header_.position_offset
+		|| (header_.position_stride == 0 && header_.position_offset != header_.vertex_offset)
+		|| header_.vertex_count * header_.vertex_stride > header_.index_offset - header_.vertex_offset
+		|| header_.index_count * index_size(header_.index_type) > header_.file_size - header_.index_offset)
+		fail("mesh file sections out of bounds");
+
+	for (auto const & lod : lods())
+		if (lod.first_index % 3 != 0 || lod.index_count % 3 != 0 || std::uint64_t(lod.first_index) + lod.index_count > header_.index_count)
+			fail("level of detail out of bounds");
+}
+
+std::span<std::byte const> mesh_file::vertices() const
+{
+	return bytes_.subspan(header_.position_offset,
+		header_.vertex_offset - header_.position_offset + header_.vertex_count * header_.vertex_stride);
+}
+
+std::span<std::byte const> mesh_file::positions() const
+{
+	if (header_.attribute_count == 0 || header_.vertex_count == 0)
+		return {};
+
+	auto const & position = header_.attributes[0];
+	auto stride = position_stride();
+	return bytes_.subspan(header_.position_offset + position.offset, (header_.vertex_count - 1) * stride + attribute_size(position));
+}
+
+std::uint32_t mesh_file::position_stride() const
+{
+	return split_positions() ? header_.position_stride : header_.vertex_stride;
+}
+
+std::span<mesh_lod const> mesh_file::lods() const
+{
+	return {reinterpret_cast<mesh_lod const *>(bytes_.data() + sizeof(mesh_header)), header_.lod_count};
+}
+
+std::span<std::byte const> mesh_file::index_bytes() const
+{
+	return bytes_.subspan(header_.index_offset, header_.index_count * index_size(header_.index_type));
+}
+
+std::vector<std::uint32_t> mesh_file::indices() const
+{
+	std::vector<std::uint32_t> result(header_.index_count);
+	auto bytes = index_bytes();
+	if (header_.index_type == GL_UNSIGNED_SHORT)
+	{
+		for (std::size_t i = 0; i < result.size(); ++i)
+		{
+			std::uint16_t index;
+			std::memcpy(&index, bytes.data() + 2 * i, sizeof(index));
+			result[i] = index;
+		}
+	}
+	else
+		std::memcpy(result.data(), bytes.data(), bytes.size());
+	return result;
+}
+
+void mesh_file::write(std::filesystem::path const & path) const
+{
+	auto temporary = path;
+	temporary += ".tmp";
+
+	{
+		std::ofstream output(temporary, std::ios::binary);
+		output.write(reinterpret_cast<char const *>(bytes_.data()), bytes_.size());
+		if (!output)
+			throw std::runtime_error("Failed to write " + temporary.string());
+	}
+
+	std::filesystem::rename(temporary, path);
+}
+
+void mesh_file::setup_attributes() const
+{
+	setup_position_attribute();
+
+	// Offsets are relative to the start of vertices()
+	auto base = header_.vertex_offset - header_.position_offset;
+	for (std::uint32_t i = 1; i < header_.attribute_count; ++i)
+		setup_attribute(header_.attributes[i], base, header_.vertex_stride);
+}
+
+void mesh_file::setup_position_attribute() const
+{
+	if (header_.attribute_count > 0)
+		setup_attribute(header_.attributes[0], 0, position_stride());
+}
+
+std::uint64_t mesh_source_hash(std::filesystem::path const & source, std::string_view build_key)
+{
+	std::uint64_t size = std::filesystem::file_size(source);
+	auto time = std::filesystem::last_write_time(source).time_since_epoch().count();
+
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	hash = fnv1a(hash, &size, sizeof(size));
+	hash = fnv1a(hash, &time, sizeof(time));
+	hash = fnv1a(hash, build_key.data(), build_key.size());
+	return hash;
+}
+
+mesh_file load_cached_mesh(std::filesystem::path const & cache, std::filesystem::path const & source,
+	std::string_view build_key, std::function<mesh_data()> const & build)
+{
+	auto hash = mesh_source_hash(source, build_key);
+
+	std::error_code error;
+	if (std::filesystem::exists(cache, error))
+	{
+		try
+		{
+			mesh_file cached(cache);
+			if (cached.header().source_hash == hash)
+				return cached;
+		}
+		catch (std::runtime_error const &)
+		{
+			// A damaged or outdated cache is simply rebuilt
+		}
+	}
+
+	mesh_file result(build(), hash);
+
+	try
+	{
+		result.write(cache);
+	}
+	catch (std::exception const &)
+	{
+		// Running without a writable cache only costs the rebuild next time
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,279 @@
+#include <engine/mesh_optimize.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine
+{
+
+namespace
+{
+
+// Forsyth's scoring: the three vertices of the last triangle score a
+// flat bonus (using them again right away is free but does not free
+// anything), the rest of the cache decays with the position, and a
+// vertex with few triangles left gets a boost to finish it off
+float const last_triangle_score = 0.75f;
+float const cache_decay_power = 1.5f;
+float const valence_boost_scale = 2.f;
+float const valence_boost_power = 0.5f;
+
+std::size_t const max_scored_valence = 32;
+
+struct vertex_scores
+{
+	std::vector<float> cache;
+	std::vector<float> valence;
+
+	explicit vertex_scores(std::size_t cache_size)
+		: cache(cache_size)
+		, valence(max_scored_valence + 1)
+	{
+		for (std::size_t i = 0; i < cache_size; ++i)
+		{
+			if (i < 3)
+				cache[i] = last_triangle_score;
+			else
+				cache[i] = std::pow(1.f - float(i - 3) / float(cache_size - 3), cache_decay_power);
+		}
+
+		for (std::size_t i = 1; i <= max_scored_valence; ++i)
+			valence[i] = valence_boost_scale * std::pow(float(i), -valence_boost_power);
+	}
+
+	// Vertices without triangles left are never picked
+	float operator()(int cache_position, std::uint32_t live_triangles) const
+	{
+		if (live_triangles == 0)
+			return -1.f;
+
+		float score = valence[std::min<std::size_t>(live_triangles, max_scored_valence)];
+		if (cache_position >= 0)
+			score += cache[cache_position];
+		return score;
+	}
+};
+
+void check_indices(std::span<std::uint32_t const> indices, std::size_t vertex_count)
+{
+	if (indices.size() % 3 != 0)
+		throw std::runtime_error("Index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+
+	for (auto index : indices)
+		if (index >= vertex_count)
+			throw std::runtime_error("Index " + std::to_string(index) + " out of range, "
+				+ std::to_string(vertex_count) + " vertices");
+}
+
+}
+
+void optimize_vertex_cache(std::span<std::uint32_t> indices, std::size_t vertex_count, std::size_t cache_size)
+{
+	check_indices(indices, vertex_count);
+	if (cache_size < 4)
+		throw std::runtime_error("Vertex cache size must be at least 4");
+
+	std::size_t const triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return;
+
+	vertex_scores const score(cache_size);
+
+	// Triangles of every vertex, compacted as they are emitted so that
+	// the first live_triangles[v] entries are the ones still to go
+	std::vector<std::uint32_t> live_triangles(vertex_count, 0);
+	for (auto index : indices)
+		++live_triangles[index];
+
+	std::vector<std::uint32_t> adjacency_offset(vertex_count + 1, 0);
+	for (std::size_t v = 0; v < vertex_count; ++v)
+		adjacency_offset[v + 1] = adjacency_offset[v] + live_triangles[v];
+
+	std::vector<std::uint32_t> adjacency(indices.size());
+	{
+		std::vector<std::uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); ++i)
+			adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<int> cache_position(vertex_count, -1);
+	std::vector<float> vertex_score(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v)
+		vertex_score[v] = score(-1, live_triangles[v]);
+
+	std::vector<float> triangle_score(triangle_count);
+	for (std::size_t t = 0; t < triangle_count; ++t)
+		triangle_score[t] = vertex_score[indices[3 * t]] + vertex_score[indices[3 * t + 1]] + vertex_score[indices[3 * t + 2]];
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<std::uint32_t> output;
+	output.reserve(indices.size());
+
+	// Room for the cache plus the three vertices pushed in front of it
+	std::vector<std::uint32_t> cache, next_cache;
+	cache.reserve(cache_size + 3);
+	next_cache.reserve(cache_size + 3);
+
+	std::size_t best = std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin();
+	// Lowest triangle that may not have been emitted yet, for when no
+	// cached vertex has triangles left
+	std::size_t next_unemitted = 0;
+
+	for (std::size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count)
+	{
+		if (best == triangle_count)
+		{
+			while (emitted[next_unemitted])
+				++next_unemitted;
+			best = next_unemitted;
+		}
+
+		emitted[best] = true;
+		std::uint32_t const * triangle = &indices[3 * best];
+		output.insert(output.end(), triangle, triangle + 3);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			auto v = triangle[k];
+			auto begin = adjacency.begin() + adjacency_offset[v];
+			auto end = begin + live_triangles[v];
+			std::iter_swap(std::find(begin, end, best), end - 1);
+			--live_triangles[v];
+		}
+
+		// The triangle's vertices move to the front, in order, the rest of
+		// the cache shifts back and whatever falls off the end is evicted
+		next_cache.assign(triangle, triangle + 3);
+		for (auto v : cache)
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				next_cache.push_back(v);
+
+		for (std::size_t i = cache_size; i < next_cache.size(); ++i)
+		{
+			auto v = next_cache[i];
+			cache_position[v] = -1;
+			vertex_score[v] = score(-1, live_triangles[v]);
+		}
+		if (next_cache.size() > cache_size)
+			next_cache.resize(cache_size);
+
+		for (std::size_t i = 0; i < next_cache.size(); ++i)
+		{
+			auto v = next_cache[i];
+			cache_position[v] = i;
+			vertex_score[v] = score(i, live_triangles[v]);
+		}
+
+		// Only triangles touching the cache changed their score, the best
+		// of them is the next one to emit
+		float best_score = -1.f;
+		best = triangle_count;
+		for (auto v : next_cache)
+		{
+			auto begin = adjacency.begin() + adjacency_offset[v];
+			for (auto it = begin; it != begin + live_triangles[v]; ++it)
+			{
+				auto t = *it;
+				float s = vertex_score[indices[3 * t]] + vertex_score[indices[3 * t + 1]] + vertex_score[indices[3 * t + 2]];
+				triangle_score[t] = s;
+				if (s > best_score)
+				{
+					best_score = s;
+					best = t;
+				}
+			}
+		}
+
+		std::swap(cache, next_cache);
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+std::vector<std::uint32_t> optimize_vertex_fetch_remap(std::span<std::uint32_t> indices, std::size_t vertex_count)
+{
+	check_indices(indices, vertex_count);
+
+	std::vector<std::uint32_t> remap(vertex_count, no_vertex);
+	std::uint32_t next = 0;
+	for (auto & index : indices)
+	{
+		if (remap[index] == no_vertex)
+			remap[index] = next++;
+		index = remap[index];
+	}
+	return remap;
+}
+
+vertex_cache_statistics analyze_vertex_cache(std::span<std::uint32_t const> indices, std::size_t vertex_count,
+	std::size_t cache_size, vertex_cache_policy policy)
+{
+	check_indices(indices, vertex_count);
+
+	vertex_cache_statistics result;
+	result.triangles = indices.size() / 3;
+
+	std::vector<bool> referenced(vertex_count, false);
+	for (auto index : indices)
+	{
+		result.vertices += !referenced[index];
+		referenced[index] = true;
+	}
+
+	if (policy == vertex_cache_policy::fifo)
+	{
+		// A vertex is cached while fewer than cache_size misses happened
+		// since its own; hits do not move it
+		std::vector<std::size_t> missed_at(vertex_count, 0);
+		for (auto index : indices)
+		{
+			if (missed_at[index] == 0 || result.transformed + 1 - missed_at[index] > cache_size)
+				missed_at[index] = ++result.transformed;
+		}
+	}
+	else
+	{
+		std::vector<std::uint32_t> cache;
+		cache.reserve(cache_size);
+		for (auto index : indices)
+		{
+			auto it = std::find(cache.begin(), cache.end(), index);
+			if (it == cache.end())
+			{
+				++result.transformed;
+				if (cache.size() == cache_size)
+					cache.pop_back();
+				it = cache.insert(cache.begin(), index);
+			}
+			else
+				std::rotate(cache.begin(), it, it + 1);
+		}
+	}
+
+	return result;
+}
+
+std::string vertex_cache_report(std::span<std::uint32_t const> before, std::span<std::uint32_t const> after,
+	std::size_t vertex_count)
+{
+	std::ostringstream report;
+	report.precision(3);
+
+	auto compare = [&](char const * name, std::size_t cache_size, vertex_cache_policy policy)
+	{
+		auto old_stats = analyze_vertex_cache(before, vertex_count, cache_size, policy);
+		auto new_stats = analyze_vertex_cache(after, vertex_count, cache_size, policy);
+		report << name << " " << cache_size << " ACMR " << old_stats.acmr() << " -> " << new_stats.acmr()
+			<< ", ATVR " << old_stats.atvr() << " -> " << new_stats.atvr();
+	};
+
+	report << "Vertex cache: ";
+	compare("FIFO", 16, vertex_cache_policy::fifo);
+	report << "; ";
+	compare("LRU", default_vertex_cache_size, vertex_cache_policy::lru);
+	return report.str();
+}
+
+}
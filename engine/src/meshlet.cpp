@@ -0,0 +1,342 @@
+#include <engine/meshlet.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_MESHLET_SSE
+#include <emmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+// Normals spreading further than this from the cone axis make the cone
+// too wide to cull anything worth the test
+float const min_cone_spread = 0.1f;
+
+enum : std::uint8_t
+{
+	visible = 0,
+	frustum_culled = 1,
+	backface_culled = 2,
+};
+
+void compute_bounds(meshlet & m, std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions)
+{
+	glm::vec3 min(std::numeric_limits<float>::infinity());
+	glm::vec3 max(-std::numeric_limits<float>::infinity());
+	for (auto index : indices)
+	{
+		min = glm::min(min, positions[index]);
+		max = glm::max(max, positions[index]);
+	}
+
+	m.center = (min + max) * 0.5f;
+	m.radius = 0.f;
+	for (auto index : indices)
+		m.radius = std::max(m.radius, glm::distance(m.center, positions[index]));
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(indices.size() / 3);
+	glm::vec3 axis(0.f);
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		auto const & p0 = positions[indices[i]];
+		auto n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+		float length = glm::length(n);
+		if (length == 0.f)
+			continue;
+		normals.push_back(n / length);
+		axis += normals.back();
+	}
+
+	m.cone_apex = m.center;
+	m.cone_axis = glm::vec3(0.f, 0.f, 1.f);
+	m.cone_cutoff = 2.f;
+
+	float axis_length = glm::length(axis);
+	if (normals.empty() || axis_length == 0.f)
+		return;
+	axis /= axis_length;
+
+	float min_dot = 1.f;
+	for (auto const & n : normals)
+		min_dot = std::min(min_dot, glm::dot(n, axis));
+	if (min_dot <= min_cone_spread)
+		return;
+
+	// The apex is moved back along the axis until it is behind the
+	// planes of all triangles
+	float max_t = 0.f;
+	std::size_t normal = 0;
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		auto const & p0 = positions[indices[i]];
+		auto n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+		if (glm::length(n) == 0.f)
+			continue;
+		auto const & unit = normals[normal++];
+		max_t = std::max(max_t, glm::dot(m.center - p0, unit) / glm::dot(axis, unit));
+	}
+
+	m.cone_apex = m.center - axis * max_t;
+	m.cone_axis = axis;
+	m.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+}
+
+}
+
+std::vector<meshlet> build_meshlets(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::uint32_t first_index)
+{
+	if (indices.size() % 3 != 0)
+		throw std::runtime_error("Index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+	for (auto index : indices)
+		if (index >= positions.size())
+			throw std::runtime_error("Index " + std::to_string(index) + " out of range, "
+				+ std::to_string(positions.size()) + " vertices");
+
+	std::vector<meshlet> result;
+
+	// Meshlet number + 1 that last counted the vertex
+	std::vector<std::uint32_t> seen(positions.size(), 0);
+
+	std::size_t begin = 0;
+	std::uint32_t vertex_count = 0;
+
+	auto close = [&](std::size_t end)
+	{
+		meshlet m{};
+		m.first_index = first_index + static_cast<std::uint32_t>(begin);
+		m.index_count = static_cast<std::uint32_t>(end - begin);
+		m.vertex_count = vertex_count;
+		compute_bounds(m, indices.subspan(begin, end - begin), positions);
+		result.push_back(m);
+
+		begin = end;
+		vertex_count = 0;
+	};
+
+	// Vertices of the triangle not in the current meshlet yet, each
+	// counted once even if the triangle is degenerate
+	auto new_vertices = [&](std::size_t i)
+	{
+		auto tag = static_cast<std::uint32_t>(result.size() + 1);
+		auto a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		return std::uint32_t(seen[a] != tag) + std::uint32_t(seen[b] != tag && b != a)
+			+ std::uint32_t(seen[c] != tag && c != a && c != b);
+	};
+
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		if (vertex_count + new_vertices(i) > max_meshlet_vertices || (i - begin) / 3 >= max_meshlet_triangles)
+			close(i);
+
+		vertex_count += new_vertices(i);
+		for (int k = 0; k < 3; ++k)
+			seen[indices[i + k]] = static_cast<std::uint32_t>(result.size() + 1);
+	}
+
+	if (begin < indices.size())
+		close(indices.size());
+
+	return result;
+}
+
+meshlet_statistics & meshlet_statistics::operator += (meshlet_statistics const & other)
+{
+	meshlets += other.meshlets;
+	frustum_culled += other.frustum_culled;
+	backface_culled += other.backface_culled;
+	triangles += other.triangles;
+	triangles_drawn += other.triangles_drawn;
+	draws += other.draws;
+	return *this;
+}
+
+meshlet_statistics & meshlet_counters()
+{
+	static meshlet_statistics counters;
+	return counters;
+}
+
+std::string meshlet_report(meshlet_statistics const & statistics)
+{
+	auto const & s = statistics;
+	auto percent = [](std::uint64_t part, std::uint64_t whole){ return whole ? 100.0 * part / whole : 0.0; };
+
+	std::ostringstream report;
+	report.precision(3);
+	report << s.meshlets << " meshlets, " << percent(s.frustum_culled, s.meshlets) << "% frustum culled, "
+		<< percent(s.backface_culled, s.meshlets) << "% backface culled, "
+		<< percent(s.triangles - s.triangles_drawn, s.triangles) << "% of " << s.triangles << " triangles culled, "
+		<< s.draws << " draws";
+	return report.str();
+}
+
+void multi_draw::draw(GLenum index_type) const
+{
+	if (!counts.empty())
+		glMultiDrawElements(GL_TRIANGLES, counts.data(), index_type, offsets.data(), static_cast<GLsizei>(counts.size()));
+}
+
+meshlet_culler::meshlet_culler(std::vector<meshlet> meshlets)
+	: meshlets_(std::move(meshlets))
+{
+	// Padding lanes get an empty sphere far behind every plane
+	std::size_t padded = (meshlets_.size() + 3) / 4 * 4;
+	for (auto * array : {&center_x_, &center_y_, &center_z_, &apex_x_, &apex_y_, &apex_z_, &axis_x_, &axis_y_, &axis_z_})
+		array->assign(padded, 0.f);
+	radius_.assign(padded, -std::numeric_limits<float>::max());
+	cutoff_.assign(padded, 2.f);
+	visible_.resize(padded);
+
+	for (std::size_t i = 0; i < meshlets_.size(); ++i)
+	{
+		auto const & m = meshlets_[i];
+		center_x_[i] = m.center.x;
+		center_y_[i] = m.center.y;
+		center_z_[i] = m.center.z;
+		radius_[i] = m.radius;
+		apex_x_[i] = m.cone_apex.x;
+		apex_y_[i] = m.cone_apex.y;
+		apex_z_[i] = m.cone_apex.z;
+		axis_x_[i] = m.cone_axis.x;
+		axis_y_[i] = m.cone_axis.y;
+		axis_z_[i] = m.cone_axis.z;
+		cutoff_[i] = m.cone_cutoff;
+	}
+}
+
+meshlet_statistics meshlet_culler::cull(glm::mat4 const & projection, glm::mat4 const & view, glm::mat4 const & model,
+	std::size_t index_size, multi_draw & draws)
+{
+	// Frustum planes in model space (Gribb & Hartmann), normalized so that
+	// the plane equation gives distances in model units
+	glm::mat4 clip = projection * view * model;
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; ++r)
+		rows[r] = glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]);
+
+	glm::vec4 planes[6] = {
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[3] + rows[2], rows[3] - rows[2],
+	};
+	for (auto & plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	// The vector from the camera to a point p is p * w - camera.xyz: the
+	// camera position with w = 1, the negated view direction with w = 0
+	glm::mat4 inverse_model_view = glm::inverse(view * model);
+	glm::vec4 camera;
+	bool orthographic = projection[2][3] == 0.f && projection[3][3] == 1.f;
+	if (orthographic)
+		camera = glm::vec4(-glm::normalize(glm::vec3(inverse_model_view * glm::vec4(0.f, 0.f, -1.f, 0.f))), 0.f);
+	else
+	{
+		auto position = inverse_model_view * glm::vec4(0.f, 0.f, 0.f, 1.f);
+		camera = glm::vec4(glm::vec3(position) / position.w, 1.f);
+	}
+
+	std::size_t const padded = visible_.size();
+
+#ifdef ENGINE_MESHLET_SSE
+	for (std::size_t i = 0; i < padded; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&center_x_[i]);
+		__m128 cy = _mm_loadu_ps(&center_y_[i]);
+		__m128 cz = _mm_loadu_ps(&center_z_[i]);
+		__m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius_[i]));
+
+		__m128 outside = _mm_setzero_ps();
+		for (auto const & plane : planes)
+		{
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negative_radius));
+		}
+
+		__m128 w = _mm_set1_ps(camera.w);
+		__m128 vx = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&apex_x_[i]), w), _mm_set1_ps(camera.x));
+		__m128 vy = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&apex_y_[i]), w), _mm_set1_ps(camera.y));
+		__m128 vz = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&apex_z_[i]), w), _mm_set1_ps(camera.z));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		__m128 along = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(vx, _mm_loadu_ps(&axis_x_[i])), _mm_mul_ps(vy, _mm_loadu_ps(&axis_y_[i]))),
+			_mm_mul_ps(vz, _mm_loadu_ps(&axis_z_[i])));
+		__m128 backfacing = _mm_cmpge_ps(along, _mm_mul_ps(_mm_loadu_ps(&cutoff_[i]), length));
+
+		int outside_mask = _mm_movemask_ps(outside);
+		int backfacing_mask = _mm_movemask_ps(backfacing);
+		for (int k = 0; k < 4; ++k)
+			visible_[i + k] = (outside_mask >> k) & 1 ? frustum_culled : (backfacing_mask >> k) & 1 ? backface_culled : visible;
+	}
+#else
+	for (std::size_t i = 0; i < padded; ++i)
+	{
+		bool outside = false;
+		for (auto const & plane : planes)
+			outside |= center_x_[i] * plane.x + center_y_[i] * plane.y + center_z_[i] * plane.z + plane.w < -radius_[i];
+
+		glm::vec3 v(apex_x_[i] * camera.w - camera.x, apex_y_[i] * camera.w - camera.y, apex_z_[i] * camera.w - camera.z);
+		bool backfacing = v.x * axis_x_[i] + v.y * axis_y_[i] + v.z * axis_z_[i] >= cutoff_[i] * glm::length(v);
+
+		visible_[i] = outside ? frustum_culled : backfacing ? backface_culled : visible;
+	}
+#endif
+
+	meshlet_statistics result;
+	result.meshlets = meshlets_.size();
+
+	draws.counts.clear();
+	draws.offsets.clear();
+	std::uint32_t range_end = 0;
+
+	for (std::size_t i = 0; i < meshlets_.size(); ++i)
+	{
+		auto const & m = meshlets_[i];
+		result.triangles += m.index_count / 3;
+
+		if (visible_[i] == frustum_culled)
+		{
+			++result.frustum_culled;
+			continue;
+		}
+		if (visible_[i] == backface_culled)
+		{
+			++result.backface_culled;
+			continue;
+		}
+
+		result.triangles_drawn += m.index_count / 3;
+
+		// Neighbouring visible meshlets are drawn as one range
+		if (!draws.counts.empty() && range_end == m.first_index)
+			draws.counts.back() += m.index_count;
+		else
+		{
+			draws.counts.push_back(m.index_count);
+			draws.offsets.push_back(reinterpret_cast<void const *>(std::uintptr_t(m.first_index) * index_size));
+		}
+		range_end = m.first_index + m.index_count;
+	}
+
+	result.draws = draws.counts.size();
+	meshlet_counters() += result;
+	return result;
+}
+
+}
@@ -0,0 +1,247 @@
+#include <engine/normals.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_NORMALS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+// Triangles or vertices handed to a thread at a time
+std::size_t const chunk_size = 4096;
+
+// Counting sort of the corners by their vertex
+void build_adjacency(std::span<std::uint32_t const> indices, std::size_t vertex_count,
+	std::vector<std::uint32_t> & offsets, std::vector<std::uint32_t> & corners)
+{
+	if (indices.size() % 3 != 0)
+		throw std::runtime_error("Index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+
+	offsets.assign(vertex_count + 1, 0);
+	for (auto index : indices)
+	{
+		if (index >= vertex_count)
+			throw std::runtime_error("Index " + std::to_string(index) + " out of range, "
+				+ std::to_string(vertex_count) + " vertices");
+		++offsets[index + 1];
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	corners.resize(indices.size());
+	std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+	for (std::size_t i = 0; i < indices.size(); ++i)
+		corners[next[indices[i]]++] = static_cast<std::uint32_t>(i);
+}
+
+}
+
+normal_generator::normal_generator(std::span<std::uint32_t const> indices, std::size_t vertex_count)
+	: indices_(indices.begin(), indices.end())
+{
+	build_adjacency(indices_, vertex_count, offsets_, corners_);
+}
+
+void normal_generator::compute(std::span<glm::vec3 const> positions, std::span<glm::vec3> normals,
+	normal_weighting weighting, thread_pool * pool)
+{
+	if (positions.size() != vertex_count() || normals.size() != vertex_count())
+		throw std::runtime_error("Expected " + std::to_string(vertex_count()) + " positions and normals, got "
+			+ std::to_string(positions.size()) + " and " + std::to_string(normals.size()));
+
+	std::size_t const triangle_count = indices_.size() / 3;
+	bool const by_angle = weighting == normal_weighting::angle;
+	face_normals_.resize(triangle_count);
+	if (by_angle)
+		corner_weights_.resize(indices_.size());
+
+	auto const * indices = indices_.data();
+	auto * faces = face_normals_.data();
+
+	parallel_for_chunks(pool, triangle_count, chunk_size, [&](std::size_t first, std::size_t last)
+	{
+		std::size_t t = first;
+
+#ifdef ENGINE_NORMALS_SSE
+		// Four triangles at a time, gathered into one register per
+		// coordinate of every corner
+		for (; t + 4 <= last; t += 4)
+		{
+			auto gather = [&](int corner, int axis)
+			{
+				auto const * i = indices + 3 * t + corner;
+				return _mm_setr_ps(positions[i[0]][axis], positions[i[3]][axis], positions[i[6]][axis], positions[i[9]][axis]);
+			};
+
+			__m128 x0 = gather(0, 0), y0 = gather(0, 1), z0 = gather(0, 2);
+			__m128 ax = _mm_sub_ps(gather(1, 0), x0), ay = _mm_sub_ps(gather(1, 1), y0), az = _mm_sub_ps(gather(1, 2), z0);
+			__m128 bx = _mm_sub_ps(gather(2, 0), x0), by = _mm_sub_ps(gather(2, 1), y0), bz = _mm_sub_ps(gather(2, 2), z0);
+
+			alignas(16) float nx[4], ny[4], nz[4];
+			_mm_store_ps(nx, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+			_mm_store_ps(ny, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+			_mm_store_ps(nz, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+
+			for (int k = 0; k < 4; ++k)
+				faces[t + k] = glm::vec3(nx[k], ny[k], nz[k]);
+		}
+#endif
+
+		for (; t < last; ++t)
+		{
+			auto const & p0 = positions[indices[3 * t]];
+			faces[t] = glm::cross(positions[indices[3 * t + 1]] - p0, positions[indices[3 * t + 2]] - p0);
+		}
+
+		if (!by_angle)
+			return;
+
+		// The corner weight turns the cross product into the unit normal
+		// times the angle. Every angle is atan2(|cross|, dot) of its edges,
+		// and the cross product is the same for all three corners.
+		for (t = first; t < last; ++t)
+		{
+			auto const & p0 = positions[indices[3 * t]];
+			auto const & p1 = positions[indices[3 * t + 1]];
+			auto const & p2 = positions[indices[3 * t + 2]];
+			float length = glm::length(faces[t]);
+			if (length == 0.f)
+			{
+				corner_weights_[3 * t] = corner_weights_[3 * t + 1] = corner_weights_[3 * t + 2] = 0.f;
+				continue;
+			}
+
+			float angle0 = std::atan2(length, glm::dot(p1 - p0, p2 - p0));
+			float angle1 = std::atan2(length, glm::dot(p2 - p1, p0 - p1));
+			corner_weights_[3 * t] = angle0 / length;
+			corner_weights_[3 * t + 1] = angle1 / length;
+			corner_weights_[3 * t + 2] = (glm::pi<float>() - angle0 - angle1) / length;
+		}
+	});
+
+	parallel_for_chunks(pool, vertex_count(), chunk_size, [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t v = first; v < last; ++v)
+		{
+			glm::vec3 sum(0.f);
+			for (auto c = offsets_[v]; c < offsets_[v + 1]; ++c)
+			{
+				auto corner = corners_[c];
+				sum += by_angle ? faces[corner / 3] * corner_weights_[corner] : faces[corner / 3];
+			}
+
+			float length = glm::length(sum);
+			normals[v] = length > 0.f ? sum / length : glm::vec3(0.f, 0.f, 1.f);
+		}
+	});
+}
+
+std::vector<glm::vec3> compute_normals(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	normal_weighting weighting, thread_pool * pool)
+{
+	std::vector<glm::vec3> normals(positions.size());
+	normal_generator(indices, positions.size()).compute(positions, normals, weighting, pool);
+	return normals;
+}
+
+std::vector<std::uint32_t> split_hard_edges(std::span<std::uint32_t> indices, std::span<glm::vec3 const> positions,
+	float max_angle_degrees)
+{
+	std::vector<std::uint32_t> offsets, corners;
+	build_adjacency(indices, positions.size(), offsets, corners);
+
+	// Rewritten indices are only read back through this copy
+	std::vector<std::uint32_t> const original(indices.begin(), indices.end());
+
+	std::vector<glm::vec3> faces(original.size() / 3);
+	for (std::size_t t = 0; t < faces.size(); ++t)
+	{
+		auto const & p0 = positions[original[3 * t]];
+		auto n = glm::cross(positions[original[3 * t + 1]] - p0, positions[original[3 * t + 2]] - p0);
+		float length = glm::length(n);
+		faces[t] = length > 0.f ? n / length : glm::vec3(0.f);
+	}
+
+	float const min_cos = std::cos(glm::radians(max_angle_degrees));
+
+	std::vector<std::uint32_t> sources(positions.size());
+	std::iota(sources.begin(), sources.end(), 0u);
+
+	// Groups of the corners of one vertex, as a union-find forest
+	std::vector<std::uint32_t> group;
+	std::vector<std::uint32_t> copy;
+
+	for (std::uint32_t v = 0; v < positions.size(); ++v)
+	{
+		auto begin = offsets[v];
+		auto count = offsets[v + 1] - begin;
+		if (count < 2)
+			continue;
+
+		group.resize(count);
+		std::iota(group.begin(), group.end(), 0u);
+		auto root = [&](std::uint32_t i)
+		{
+			while (group[i] != i)
+				i = group[i] = group[group[i]];
+			return i;
+		};
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			auto ti = corners[begin + i] / 3;
+			for (std::uint32_t j = i + 1; j < count; ++j)
+			{
+				auto tj = corners[begin + j] / 3;
+
+				// Neighbours around v share one more vertex
+				bool adjacent = false;
+				for (int a = 0; a < 3; ++a)
+					for (int b = 0; b < 3; ++b)
+						adjacent |= original[3 * ti + a] != v && original[3 * ti + a] == original[3 * tj + b];
+
+				// Degenerate triangles join whatever they touch
+				bool smooth = faces[ti] == glm::vec3(0.f) || faces[tj] == glm::vec3(0.f)
+					|| glm::dot(faces[ti], faces[tj]) >= min_cos;
+
+				if (adjacent && smooth)
+					group[root(i)] = root(j);
+			}
+		}
+
+		// The group of the first corner keeps the vertex, every other one
+		// gets a copy
+		copy.assign(count, 0);
+		auto first = root(0);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			auto r = root(i);
+			if (r == first)
+				continue;
+			if (copy[r] == 0)
+			{
+				copy[r] = static_cast<std::uint32_t>(sources.size());
+				sources.push_back(v);
+			}
+			indices[corners[begin + i]] = copy[r];
+		}
+	}
+
+	return sources;
+}
+
+}
@@ -0,0 +1,802 @@
+#include <engine/obj.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace engine
+{
+
+namespace
+{
+
+[[noreturn]] void fail(std::size_t line, std::string const & message)
+{
+	throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+}
+
+bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+char const * skip_spaces(char const * p, char const * end)
+{
+	while (p != end && is_space(*p))
+		++p;
+	return p;
+}
+
+char const * token_end(char const * p, char const * end)
+{
+	while (p != end && !is_space(*p))
+		++p;
+	return p;
+}
+
+char const * line_end(char const * p, char const * end)
+{
+	auto newline = static_cast<char const *>(std::memchr(p, '\n', end - p));
+	return newline ? newline : end;
+}
+
+// Walks the rows of an OBJ or MTL file, skipping empty lines and
+// comments. After next() the keyword is the first token of the row and
+// [p, eol) is the rest of it.
+struct row_reader
+{
+	char const * next_line;
+	char const * end;
+
+	std::size_t line = 0;
+	std::string_view keyword;
+	char const * p = nullptr;
+	char const * eol = nullptr;
+
+	explicit row_reader(std::string_view text)
+		: next_line(text.data())
+		, end(text.data() + text.size())
+	{}
+
+	bool next()
+	{
+		while (next_line != end)
+		{
+			++line;
+			eol = line_end(next_line, end);
+			char const * row = skip_spaces(next_line, eol);
+			next_line = (eol == end) ? end : eol + 1;
+
+			if (row == eol || *row == '#')
+				continue;
+
+			p = token_end(row, eol);
+			keyword = std::string_view(row, p - row);
+			return true;
+		}
+		return false;
+	}
+
+	[[noreturn]] void error(std::string const & message) const
+	{
+		fail(line, message);
+	}
+
+	float read_float()
+	{
+		p = skip_spaces(p, eol);
+		// from_chars does not accept an explicit plus sign
+		if (p != eol && *p == '+')
+			++p;
+
+		float result;
+		auto [next, error_code] = std::from_chars(p, eol, result);
+		if (error_code != std::errc{})
+			error("expected a number");
+		p = next;
+		return result;
+	}
+
+	glm::vec3 read_vec3()
+	{
+		glm::vec3 result;
+		result.x = read_float();
+		result.y = read_float();
+		result.z = read_float();
+		return result;
+	}
+
+	bool at_end()
+	{
+		p = skip_spaces(p, eol);
+		return p == eol;
+	}
+
+	// Rest of the row without surrounding whitespace
+	std::string_view rest()
+	{
+		p = skip_spaces(p, eol);
+		char const * last = eol;
+		while (last != p && is_space(last[-1]))
+			--last;
+		return std::string_view(p, last - p);
+	}
+
+	long long read_integer(char const * what)
+	{
+		long long result;
+		auto [next, error_code] = std::from_chars(p, eol, result);
+		if (error_code != std::errc{})
+			error(std::string("expected a ") + what + " index");
+		p = next;
+		return result;
+	}
+
+	// Skips the texture coordinate and normal references after the vertex
+	// index of a face corner ("/vt", "/vt/vn" or "//vn"), read just like
+	// parse_obj_model reads them, for the parsers that only need positions
+	void skip_references()
+	{
+		if (p == eol || *p != '/')
+			return;
+		++p;
+		if (p != eol && *p != '/')
+			read_integer("texture coordinate");
+		if (p != eol && *p == '/')
+		{
+			++p;
+			read_integer("normal");
+		}
+	}
+
+	// Throws unless the face corner just read ends its token, so that
+	// e.g. "1x" is not taken for "1"
+	void end_corner() const
+	{
+		if (p != eol && !is_space(*p))
+			error("invalid face corner");
+	}
+
+	// Resolves an OBJ index (one-based, or negative counting back from the
+	// last element read so far) to a zero-based one
+	std::uint32_t read_index(std::size_t count, char const * what)
+	{
+		long long index = read_integer(what);
+
+		if (index < 0)
+			index += static_cast<long long>(count) + 1;
+		if (index < 1 || index > static_cast<long long>(count))
+			error(std::string(what) + " index out of range");
+
+		return static_cast<std::uint32_t>(index - 1);
+	}
+};
+
+bool is_row(char const * p, char const * end, char type)
+{
+	return end - p >= 2 && p[0] == type && is_space(p[1]);
+}
+
+// Rows that carry nothing a positions-only mesh needs: every row type
+// parse_obj_model accepts, so that a file loads with both or neither
+bool is_skipped_row(std::string_view keyword)
+{
+	return keyword == "vt" || keyword == "vn" || keyword == "vp"
+		|| keyword == "o" || keyword == "g" || keyword == "s"
+		|| keyword == "l" || keyword == "p"
+		|| keyword == "usemtl" || keyword == "mtllib";
+}
+
+void count_rows(std::string_view text, std::size_t & vertex_rows, std::size_t & face_rows)
+{
+	char const * end = text.data() + text.size();
+	for (char const * p = text.data(); p != end;)
+	{
+		char const * row = skip_spaces(p, end);
+		if (is_row(row, end, 'v'))
+			++vertex_rows;
+		else if (is_row(row, end, 'f'))
+			++face_rows;
+
+		p = line_end(row, end);
+		if (p != end)
+			++p;
+	}
+}
+
+// A piece of the text given to the parallel parse_obj, parsed without
+// knowing how many vertices the preceding chunks define
+struct obj_chunk
+{
+	std::string_view text;
+
+	std::vector<glm::vec3> positions;
+	// Positive OBJ indices are global and stored final; relative ones are
+	// stored as signed offsets from the first vertex of the chunk and
+	// listed in relative_slots for the fix-up pass
+	std::vector<std::uint32_t> indices;
+	std::vector<std::size_t> relative_slots;
+
+	// Validity of the indices depends on the vertices before the chunk:
+	// every positive index minus the vertices of the chunk read before it
+	// must not exceed their number, every relative offset must not point
+	// before the first of them
+	long long max_ahead = 0;
+	long long min_relative = 0;
+
+	bool failed = false;
+};
+
+void parse_chunk(obj_chunk & chunk)
+{
+	std::size_t vertex_rows = 0;
+	std::size_t face_rows = 0;
+	count_rows(chunk.text, vertex_rows, face_rows);
+
+	chunk.positions.reserve(vertex_rows);
+	chunk.indices.reserve(face_rows * 3);
+
+	try
+	{
+		row_reader reader(chunk.text);
+		while (reader.next())
+		{
+			if (reader.keyword == "v")
+			{
+				chunk.positions.push_back(reader.read_vec3());
+				continue;
+			}
+
+			if (reader.keyword == "f")
+			{
+				auto local_count = static_cast<long long>(chunk.positions.size());
+
+				std::uint32_t first = 0, previous = 0;
+				bool first_relative = false, previous_relative = false;
+
+				auto emit = [&](std::uint32_t index, bool relative)
+				{
+					if (relative)
+						chunk.relative_slots.push_back(chunk.indices.size());
+					chunk.indices.push_back(index);
+				};
+
+				int count = 0;
+				for (; !reader.at_end(); ++count)
+				{
+					long long value = reader.read_integer("vertex");
+					// Texture coordinate and normal references are not used
+					reader.skip_references();
+					reader.end_corner();
+
+					std::uint32_t index;
+					bool relative = value < 0;
+					if (value > 0)
+					{
+						chunk.max_ahead = std::max(chunk.max_ahead, value - local_count);
+						index = static_cast<std::uint32_t>(value - 1);
+					}
+					else if (relative)
+					{
+						chunk.min_relative = std::min(chunk.min_relative, local_count + value);
+						index = static_cast<std::uint32_t>(static_cast<std::int32_t>(local_count + value));
+					}
+					else
+						reader.error("vertex index out of range");
+
+					if (count == 0)
+					{
+						first = index;
+						first_relative = relative;
+					}
+					else if (count >= 2)
+					{
+						emit(first, first_relative);
+						emit(previous, previous_relative);
+						emit(index, relative);
+					}
+					previous = index;
+					previous_relative = relative;
+				}
+
+				if (count < 3)
+					reader.error("a face needs at least three vertices");
+				continue;
+			}
+
+			if (!is_skipped_row(reader.keyword))
+				reader.error("unknown row type");
+		}
+	}
+	catch (std::runtime_error const &)
+	{
+		chunk.failed = true;
+	}
+}
+
+std::string read_file(std::filesystem::path const & path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("Failed to open " + path.string());
+
+	std::string text(std::filesystem::file_size(path), '\0');
+	if (!file.read(text.data(), text.size()))
+		throw std::runtime_error("Failed to read " + path.string());
+	return text;
+}
+
+template <typename Parse>
+auto parse_file(std::filesystem::path const & path, Parse const & parse)
+{
+	auto text = read_file(path);
+	try
+	{
+		return parse(text);
+	}
+	catch (std::runtime_error const & e)
+	{
+		throw std::runtime_error(path.string() + ": " + e.what());
+	}
+}
+
+// Face corner as written in the file, zero-based; missing texture
+// coordinates and normals are none
+struct corner
+{
+	static constexpr std::uint32_t none = ~std::uint32_t(0);
+
+	std::uint32_t position;
+	std::uint32_t texcoord;
+	std::uint32_t normal;
+
+	bool operator == (corner const &) const = default;
+};
+
+// Open-addressing map from face corners to the indices of the welded
+// vertices; the corners are stored alongside the vertices, the table
+// itself only holds vertex indices
+class corner_table
+{
+public:
+	explicit corner_table(std::size_t expected)
+	{
+		slots_.assign(std::max<std::size_t>(std::bit_ceil(expected * 2 + 1), 16), empty);
+	}
+
+	// Returns the vertex of the corner, appending the corner as a new
+	// vertex if it was not seen before
+	std::uint32_t insert(corner const & c, std::vector<corner> & corners)
+	{
+		if ((corners.size() + 1) * 2 > slots_.size())
+			grow(corners);
+
+		std::size_t mask = slots_.size() - 1;
+		for (std::size_t slot = hash(c) & mask;; slot = (slot + 1) & mask)
+		{
+			if (slots_[slot] == empty)
+			{
+				auto index = static_cast<std::uint32_t>(corners.size());
+				slots_[slot] = index;
+				corners.push_back(c);
+				return index;
+			}
+			if (corners[slots_[slot]] == c)
+				return slots_[slot];
+		}
+	}
+
+private:
+	static constexpr std::uint32_t empty = ~std::uint32_t(0);
+
+	std::vector<std::uint32_t> slots_;
+
+	static std::size_t hash(corner const & c)
+	{
+		std::uint64_t h = c.position * 0x9E3779B97F4A7C15ull;
+		h ^= (c.texcoord + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+		h ^= (c.normal + 0x165667B19E3779F9ull) * 0x94D049BB133111EBull;
+		return static_cast<std::size_t>(h ^ (h >> 29));
+	}
+
+	void grow(std::vector<corner> const & corners)
+	{
+		slots_.assign(slots_.size() * 2, empty);
+		std::size_t mask = slots_.size() - 1;
+		for (std::uint32_t index = 0; index < corners.size(); ++index)
+		{
+			std::size_t slot = hash(corners[index]) & mask;
+			while (slots_[slot] != empty)
+				slot = (slot + 1) & mask;
+			slots_[slot] = index;
+		}
+	}
+};
+
+}
+
+obj_mesh parse_obj(std::string_view text)
+{
+	obj_mesh result;
+
+	std::size_t vertex_rows = 0;
+	std::size_t face_rows = 0;
+	count_rows(text, vertex_rows, face_rows);
+
+	result.positions.reserve(vertex_rows);
+	result.indices.reserve(face_rows * 3);
+
+	row_reader reader(text);
+	while (reader.next())
+	{
+		if (reader.keyword == "v")
+		{
+			result.positions.push_back(reader.read_vec3());
+			continue;
+		}
+
+		if (reader.keyword == "f")
+		{
+			auto vertex_count = result.positions.size();
+
+			std::uint32_t first = 0;
+			std::uint32_t previous = 0;
+			int count = 0;
+			for (; !reader.at_end(); ++count)
+			{
+				auto index = reader.read_index(vertex_count, "vertex");
+				// Texture coordinate and normal references are not used
+				reader.skip_references();
+				reader.end_corner();
+
+				if (count == 0)
+					first = index;
+				else if (count >= 2)
+				{
+					result.indices.push_back(first);
+					result.indices.push_back(previous);
+					result.indices.push_back(index);
+				}
+				previous = index;
+			}
+
+			if (count < 3)
+				reader.error("a face needs at least three vertices");
+			continue;
+		}
+
+		if (!is_skipped_row(reader.keyword))
+			reader.error("unknown row type: " + std::string(reader.keyword));
+	}
+
+	return result;
+}
+
+obj_mesh load_obj(std::filesystem::path const & path)
+{
+	return parse_file(path, [](std::string_view text){ return parse_obj(text); });
+}
+
+obj_mesh parse_obj(std::string_view text, thread_pool & pool)
+{
+	// Below this size per chunk the threads cost more than they save
+	constexpr std::size_t min_chunk_size = 4 << 20;
+	// A few chunks per thread even out chunks that parse slower than others
+	constexpr std::size_t chunks_per_thread = 4;
+
+	std::size_t chunk_count = std::min<std::size_t>(text.size() / min_chunk_size, pool.size() * chunks_per_thread);
+	if (pool.size() == 1 || chunk_count <= 1)
+		return parse_obj(text);
+
+	std::vector<obj_chunk> chunks(chunk_count);
+	std::size_t begin = 0;
+	for (std::size_t i = 0; i < chunk_count; ++i)
+	{
+		std::size_t end = text.size();
+		if (i + 1 < chunk_count)
+		{
+			end = std::max(begin, text.size() * (i + 1) / chunk_count);
+			end = text.find('\n', end);
+			end = (end == std::string_view::npos) ? text.size() : end + 1;
+		}
+		chunks[i].text = text.substr(begin, end - begin);
+		begin = end;
+	}
+
+	pool.parallel_for(chunks.size(), [&](std::size_t i){ parse_chunk(chunks[i]); });
+
+	std::vector<std::size_t> vertex_offsets(chunks.size());
+	std::vector<std::size_t> index_offsets(chunks.size());
+	std::size_t vertex_count = 0;
+	std::size_t index_count = 0;
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+	{
+		auto const & chunk = chunks[i];
+		auto offset = static_cast<long long>(vertex_count);
+		if (chunk.failed || chunk.max_ahead > offset || chunk.min_relative < -offset)
+			return parse_obj(text);
+
+		vertex_offsets[i] = vertex_count;
+		index_offsets[i] = index_count;
+		vertex_count += chunk.positions.size();
+		index_count += chunk.indices.size();
+	}
+
+	obj_mesh result;
+	result.positions.resize(vertex_count);
+	result.indices.resize(index_count);
+
+	pool.parallel_for(chunks.size(), [&](std::size_t i)
+	{
+		auto & chunk = chunks[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + vertex_offsets[i]);
+
+		auto offset = static_cast<long long>(vertex_offsets[i]);
+		for (auto slot : chunk.relative_slots)
+			chunk.indices[slot] = static_cast<std::uint32_t>(static_cast<std::int32_t>(chunk.indices[slot]) + offset);
+		std::copy(chunk.indices.begin(), chunk.indices.end(), result.indices.begin() + index_offsets[i]);
+
+		chunk = obj_chunk{};
+	});
+
+	return result;
+}
+
+obj_mesh load_obj(std::filesystem::path const & path, thread_pool & pool)
+{
+	return parse_file(path, [&](std::string_view text){ return parse_obj(text, pool); });
+}
+
+std::vector<obj_material> parse_mtl(std::string_view text)
+{
+	std::vector<obj_material> result;
+
+	row_reader reader(text);
+	while (reader.next())
+	{
+		auto const & keyword = reader.keyword;
+
+		if (keyword == "newmtl")
+		{
+			result.emplace_back().name = reader.rest();
+			continue;
+		}
+
+		if (result.empty())
+			reader.error("material property before newmtl");
+
+		auto & material = result.back();
+
+		if (keyword == "Ka")
+			material.ambient = reader.read_vec3();
+		else if (keyword == "Kd")
+			material.diffuse = reader.read_vec3();
+		else if (keyword == "Ks")
+			material.specular = reader.read_vec3();
+		else if (keyword == "Ke")
+			material.emission = reader.read_vec3();
+		else if (keyword == "Ns")
+			material.shininess = reader.read_float();
+		else if (keyword == "Ni")
+			material.refraction_index = reader.read_float();
+		else if (keyword == "d")
+			material.opacity = reader.read_float();
+		else if (keyword == "Tr")
+			material.opacity = 1.f - reader.read_float();
+		else if (keyword == "illum")
+			material.illumination = static_cast<int>(reader.read_float());
+		else if (keyword == "map_Kd" || keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm")
+		{
+			// Options like -bm 1.0 may precede the file name
+			auto value = reader.rest();
+			auto space = value.find_last_of(" \t");
+			auto file = (space == std::string_view::npos) ? value : value.substr(space + 1);
+			(keyword == "map_Kd" ? material.diffuse_map : material.normal_map) = file;
+		}
+		// Other properties (reflection maps, transmission filters, ...) are not used
+	}
+
+	return result;
+}
+
+obj_model parse_obj_model(std::string_view text, std::filesystem::path const & directory)
+{
+	std::size_t position_rows = 0;
+	std::size_t texcoord_rows = 0;
+	std::size_t normal_rows = 0;
+	std::size_t face_rows = 0;
+	{
+		row_reader reader(text);
+		while (reader.next())
+		{
+			if (reader.keyword == "v")
+				++position_rows;
+			else if (reader.keyword == "vt")
+				++texcoord_rows;
+			else if (reader.keyword == "vn")
+				++normal_rows;
+			else if (reader.keyword == "f")
+				++face_rows;
+		}
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texcoords;
+	std::vector<glm::vec3> normals;
+	positions.reserve(position_rows);
+	texcoords.reserve(texcoord_rows);
+	normals.reserve(normal_rows);
+
+	obj_model result;
+
+	std::vector<corner> corners;
+	corners.reserve(position_rows);
+	corner_table table(position_rows);
+
+	// Triangles of every material, concatenated into submeshes at the end
+	std::vector<std::vector<std::uint32_t>> material_indices;
+	std::uint32_t current_material = corner::none;
+	// Materials that already got their definition from an MTL file
+	std::vector<bool> defined;
+	// Whether the last face continued the current run of faces
+	bool in_face_group = false;
+
+	auto find_material = [&](std::string_view name) -> std::uint32_t
+	{
+		for (std::uint32_t i = 0; i < result.materials.size(); ++i)
+			if (result.materials[i].name == name)
+				return i;
+
+		result.materials.emplace_back().name = name;
+		return static_cast<std::uint32_t>(result.materials.size() - 1);
+	};
+
+	row_reader reader(text);
+	while (reader.next())
+	{
+		auto const & keyword = reader.keyword;
+
+		if (keyword == "v")
+			positions.push_back(reader.read_vec3());
+		else if (keyword == "vt")
+		{
+			glm::vec2 t;
+			t.x = reader.read_float();
+			t.y = reader.at_end() ? 0.f : reader.read_float();
+			texcoords.push_back(t);
+		}
+		else if (keyword == "vn")
+			normals.push_back(reader.read_vec3());
+		else if (keyword == "f")
+		{
+			if (current_material == corner::none)
+				current_material = find_material("");
+			if (material_indices.size() <= current_material)
+				material_indices.resize(current_material + 1);
+			auto & indices = material_indices[current_material];
+
+			if (!in_face_group)
+				++result.face_groups;
+			in_face_group = true;
+
+			std::uint32_t first = 0;
+			std::uint32_t previous = 0;
+			int count = 0;
+			for (; !reader.at_end(); ++count)
+			{
+				corner c{reader.read_index(positions.size(), "vertex"), corner::none, corner::none};
+				if (reader.p != reader.eol && *reader.p == '/')
+				{
+					++reader.p;
+					if (reader.p != reader.eol && *reader.p != '/')
+						c.texcoord = reader.read_index(texcoords.size(), "texture coordinate");
+					if (reader.p != reader.eol && *reader.p == '/')
+					{
+						++reader.p;
+						c.normal = reader.read_index(normals.size(), "normal");
+					}
+				}
+				reader.end_corner();
+
+				auto index = table.insert(c, corners);
+
+				if (count == 0)
+					first = index;
+				else if (count >= 2)
+				{
+					indices.push_back(first);
+					indices.push_back(previous);
+					indices.push_back(index);
+				}
+				previous = index;
+			}
+
+			if (count < 3)
+				reader.error("a face needs at least three vertices");
+		}
+		else if (keyword == "usemtl")
+		{
+			current_material = find_material(reader.rest());
+			in_face_group = false;
+		}
+		else if (keyword == "mtllib")
+		{
+			// Several files may be listed; materials defined twice keep the first definition
+			auto names = reader.rest();
+			while (!names.empty())
+			{
+				auto space = names.find_first_of(" \t");
+				auto name = names.substr(0, space);
+				names = (space == std::string_view::npos) ? std::string_view{} : names.substr(space + 1);
+				if (name.empty())
+					continue;
+
+				auto path = directory / std::filesystem::path(name);
+				for (auto & material : parse_file(path, [](std::string_view text){ return parse_mtl(text); }))
+				{
+					auto index = find_material(material.name);
+					defined.resize(result.materials.size(), false);
+					if (!defined[index])
+					{
+						result.materials[index] = std::move(material);
+						defined[index] = true;
+					}
+				}
+			}
+		}
+		else if (keyword == "o" || keyword == "g")
+		{
+			// Groups do not matter once faces are sorted by material, they
+			// only end the current run of faces
+			in_face_group = false;
+		}
+		else if (keyword == "vp" || keyword == "s" || keyword == "l" || keyword == "p")
+		{
+			// Lines, points and parameter space vertices are not drawn
+		}
+		else
+			reader.error("unknown row type: " + std::string(keyword));
+	}
+
+	result.vertices.resize(corners.size());
+	for (std::size_t i = 0; i < corners.size(); ++i)
+	{
+		auto const & c = corners[i];
+		auto & v = result.vertices[i];
+		v.position = positions[c.position];
+		v.texcoord = (c.texcoord == corner::none) ? glm::vec2(0.f) : texcoords[c.texcoord];
+		v.normal = (c.normal == corner::none) ? glm::vec3(0.f) : normals[c.normal];
+		result.has_texcoords |= (c.texcoord != corner::none);
+		result.has_normals |= (c.normal != corner::none);
+	}
+
+	std::size_t index_count = 0;
+	for (auto const & indices : material_indices)
+		index_count += indices.size();
+	result.indices.reserve(index_count);
+
+	for (std::uint32_t material = 0; material < material_indices.size(); ++material)
+	{
+		auto const & indices = material_indices[material];
+		if (indices.empty())
+			continue;
+
+		result.submeshes.push_back({material, static_cast<std::uint32_t>(result.indices.size()), static_cast<std::uint32_t>(indices.size())});
+		result.indices.insert(result.indices.end(), indices.begin(), indices.end());
+	}
+
+	return result;
+}
+
+obj_model import_obj(std::filesystem::path const & path)
+{
+	auto directory = path.parent_path();
+	return parse_file(path, [&](std::string_view text){ return parse_obj_model(text, directory); });
+}
+
+}
@@ -0,0 +1,238 @@
+#include <engine/profiler.hpp>
+
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+namespace engine
+{
+
+void frame_profiler::enable(std::string const & trace_path)
+{
+	enabled_ = true;
+	start_ = std::chrono::steady_clock::now();
+
+	// GPU timestamps are converted to the CPU timeline with a single offset
+	// measured here, which is good enough for frames of a few seconds
+	GLint64 gpu_now = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+	gpu_offset_ = gpu_now - now();
+
+	if (trace_path.empty())
+		return;
+
+	trace_.open(trace_path, std::ios::trunc);
+	if (!trace_)
+		throw std::runtime_error("Failed to open trace file " + trace_path);
+
+	trace_ << "{\"traceEvents\":[\n"
+		<< R"({"name":"thread_name","ph":"M","pid":1,"tid":1,"args":{"name":"CPU"}},)" << '\n'
+		<< R"({"name":"thread_name","ph":"M","pid":1,"tid":2,"args":{"name":"GPU"}})";
+	first_trace_event_ = false;
+}
+
+std::int64_t frame_profiler::now() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+GLuint frame_profiler::query(frame & f, std::uint32_t index)
+{
+	while (f.queries.size() <= index)
+	{
+		GLuint id;
+		glGenQueries(1, &id);
+		f.queries.push_back(id);
+	}
+	return f.queries[index];
+}
+
+void frame_profiler::begin(char const * name)
+{
+	if (!enabled_)
+		return;
+
+	frame & f = frames_[current_];
+	int parent = stack_.empty() ? -1 : stack_.back();
+	std::uint32_t index = f.events.size();
+
+	f.events.push_back({name, parent, now(), 0, 2 * index});
+	glQueryCounter(query(f, 2 * index), GL_TIMESTAMP);
+
+	stack_.push_back(index);
+}
+
+void frame_profiler::end()
+{
+	if (!enabled_ || stack_.empty())
+		return;
+
+	frame & f = frames_[current_];
+	auto & e = f.events[stack_.back()];
+	stack_.pop_back();
+
+	e.cpu_end = now();
+	glQueryCounter(query(f, e.query + 1), GL_TIMESTAMP);
+}
+
+void frame_profiler::begin_frame()
+{
+	if (!enabled_)
+		return;
+
+	current_ = (current_ + 1) % frames_in_flight;
+
+	// The oldest frame in the ring was submitted frames_in_flight - 1
+	// frames ago, its results are most likely available by now
+	frame & f = frames_[current_];
+	if (f.pending)
+		resolve(f, false);
+	f.events.clear();
+
+	begin("frame");
+}
+
+void frame_profiler::end_frame()
+{
+	if (!enabled_)
+		return;
+
+	// Close scopes that the frame left open, including the root one
+	while (!stack_.empty())
+		end();
+
+	frames_[current_].pending = true;
+}
+
+void frame_profiler::resolve(frame & f, bool wait)
+{
+	f.pending = false;
+	if (f.events.empty())
+		return;
+
+	// The root scope ends last, so its end query is the last one issued
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(f.queries[f.events.front().query + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available && !wait)
+	{
+		++dropped_frames_;
+		return;
+	}
+
+	std::vector<int> entries(f.events.size());
+	for (std::size_t i = 0; i < f.events.size(); ++i)
+	{
+		auto const & e = f.events[i];
+
+		GLint64 gpu_begin = 0;
+		GLint64 gpu_end = 0;
+		glGetQueryObjecti64v(f.queries[e.query], GL_QUERY_RESULT, &gpu_begin);
+		glGetQueryObjecti64v(f.queries[e.query + 1], GL_QUERY_RESULT, &gpu_end);
+
+		entries[i] = summary_entry(e.parent < 0 ? -1 : entries[e.parent], e.name);
+		summary_[entries[i]].cpu_ms += (e.cpu_end - e.cpu_begin) * 1e-6;
+		summary_[entries[i]].gpu_ms += (gpu_end - gpu_begin) * 1e-6;
+
+		if (trace_.is_open())
+		{
+			write_event(e.name, 1, e.cpu_begin, e.cpu_end);
+			write_event(e.name, 2, gpu_begin - gpu_offset_, gpu_end - gpu_offset_);
+		}
+	}
+
+	++summary_frames_;
+}
+
+int frame_profiler::summary_entry(int parent, char const * name)
+{
+	for (std::size_t i = 0; i < summary_.size(); ++i)
+		if (summary_[i].parent == parent && std::strcmp(summary_[i].name, name) == 0)
+			return i;
+
+	int depth = (parent < 0) ? 0 : summary_[parent].depth + 1;
+	summary_.push_back({name, parent, depth});
+	return summary_.size() - 1;
+}
+
+void frame_profiler::write_event(char const * name, int thread, std::int64_t begin, std::int64_t end)
+{
+	if (!first_trace_event_)
+		trace_ << ",\n";
+	first_trace_event_ = false;
+
+	trace_ << R"({"name":")";
+	for (char const * c = name; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			trace_ << '\\';
+		trace_ << *c;
+	}
+	trace_ << R"(","ph":"X","pid":1,"tid":)" << thread
+		<< std::fixed << std::setprecision(3)
+		<< R"(,"ts":)" << begin * 1e-3
+		<< R"(,"dur":)" << (end - begin) * 1e-3 << "}"
+		<< std::defaultfloat;
+}
+
+void frame_profiler::finish()
+{
+	if (!enabled_)
+		return;
+
+	end_frame();
+
+	// Oldest frames first to keep the trace ordered
+	for (std::size_t i = 1; i <= frames_in_flight; ++i)
+	{
+		frame & f = frames_[(current_ + i) % frames_in_flight];
+		if (f.pending)
+			resolve(f, true);
+		glDeleteQueries(f.queries.size(), f.queries.data());
+		f.queries.clear();
+		f.events.clear();
+	}
+
+	if (trace_.is_open())
+	{
+		trace_ << "\n]}\n";
+		trace_.close();
+	}
+
+	enabled_ = false;
+}
+
+void frame_profiler::print_summary(std::ostream & out)
+{
+	if (summary_frames_ == 0)
+		return;
+
+	out << "Profile, average per frame over " << summary_frames_ << " frames";
+	if (dropped_frames_ > 0)
+		out << " (" << dropped_frames_ << " dropped, results were late)";
+	out << ":\n";
+
+	auto flags = out.flags();
+	auto precision = out.precision();
+	out << std::fixed << std::setprecision(3);
+
+	for (auto & entry : summary_)
+	{
+		std::string label(2 * entry.depth, ' ');
+		label += entry.name;
+		out << "  " << std::left << std::setw(32) << label << std::right
+			<< " cpu " << std::setw(8) << entry.cpu_ms / summary_frames_ << " ms"
+			<< "   gpu " << std::setw(8) << entry.gpu_ms / summary_frames_ << " ms\n";
+
+		entry.cpu_ms = 0.0;
+		entry.gpu_ms = 0.0;
+	}
+	out << std::flush;
+
+	out.flags(flags);
+	out.precision(precision);
+
+	summary_frames_ = 0;
+	dropped_frames_ = 0;
+}
+
+}
@@ -0,0 +1,194 @@
+#include <engine/program.hpp>
+#include <engine/program_cache.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+namespace
+{
+
+GLuint create_shader(GLenum type, std::string_view source)
+{
+	GLuint result = glCreateShader(type);
+	char const * source_data = source.data();
+	GLint source_length = source.size();
+	glShaderSource(result, 1, &source_data, &source_length);
+	glCompileShader(result);
+	GLint status;
+	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint info_log_length;
+		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::string info_log(info_log_length, '\0');
+		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
+		glDeleteShader(result);
+		throw std::runtime_error("Shader compilation failed: " + info_log);
+	}
+	return result;
+}
+
+// Inserts the defines right after the #version directive, which has to stay first
+std::string with_defines(std::string_view source, std::string_view defines)
+{
+	std::string result;
+	result.reserve(source.size() + defines.size() + 1);
+
+	std::size_t insert_at = 0;
+	if (source.starts_with("#version"))
+	{
+		insert_at = source.find('\n');
+		insert_at = (insert_at == std::string_view::npos) ? source.size() : insert_at + 1;
+	}
+
+	result.append(source.substr(0, insert_at));
+	result.append(defines);
+	if (!defines.empty() && defines.back() != '\n')
+		result.push_back('\n');
+	result.append(source.substr(insert_at));
+	return result;
+}
+
+void link_program(GLuint program)
+{
+	glLinkProgram(program);
+
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint info_log_length;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::string info_log(info_log_length, '\0');
+		glGetProgramInfoLog(program, info_log.size(), nullptr, info_log.data());
+		throw std::runtime_error("Program linkage failed: " + info_log);
+	}
+}
+
+}
+
+program::program(std::initializer_list<shader_source> sources, program_cache * cache, std::string_view defines)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	auto record_time = [&]
+	{
+		if (cache)
+			cache->add_time(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+	};
+
+	std::uint64_t key = 0;
+	if (cache)
+	{
+		key = cache->key(sources, defines);
+		if ((id_ = cache->load(key)) != 0)
+		{
+			uniforms_ = uniform_table(id_);
+			record_time();
+			return;
+		}
+	}
+
+	std::vector<GLuint> shaders;
+	shaders.reserve(sources.size());
+
+	auto delete_shaders = [&]
+	{
+		for (GLuint shader : shaders)
+		{
+			if (id_ != 0)
+				glDetachShader(id_, shader);
+			glDeleteShader(shader);
+		}
+	};
+
+	try
+	{
+		for (auto const & source : sources)
+		{
+			if (defines.empty())
+				shaders.push_back(create_shader(source.type, source.source));
+			else
+				shaders.push_back(create_shader(source.type, with_defines(source.source, defines)));
+		}
+
+		id_ = glCreateProgram();
+		for (GLuint shader : shaders)
+			glAttachShader(id_, shader);
+		if (cache && cache->enabled())
+			glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		link_program(id_);
+	}
+	catch (...)
+	{
+		delete_shaders();
+		if (id_ != 0)
+			glDeleteProgram(id_);
+		throw;
+	}
+
+	// The linked program keeps the compiled code, the stages are not needed anymore
+	delete_shaders();
+
+	uniforms_ = uniform_table(id_);
+
+	if (cache)
+	{
+		cache->store(key, id_);
+		record_time();
+	}
+}
+
+program::program(program && other) noexcept
+	: id_(std::exchange(other.id_, 0))
+	, uniforms_(std::move(other.uniforms_))
+{}
+
+program & program::operator = (program && other) noexcept
+{
+	if (this != &other)
+	{
+		if (id_ != 0)
+			glDeleteProgram(id_);
+		id_ = std::exchange(other.id_, 0);
+		uniforms_ = std::move(other.uniforms_);
+	}
+	return *this;
+}
+
+program::~program()
+{
+	if (id_ != 0)
+		glDeleteProgram(id_);
+}
+
+GLint program::uniform_location(char const * name) const
+{
+	// Elements other than the first one are not in the table by name
+	if (auto u = uniforms_.find(name))
+		return uniforms_.location(u);
+	return glGetUniformLocation(id_, name);
+}
+
+void program::bind_block(std::string_view name, GLuint binding, std::size_t size) const
+{
+	for (auto const & block : uniforms_.blocks())
+	{
+		if (block.name != name)
+			continue;
+
+		if (size != 0 && std::size_t(block.data_size) != size)
+			throw std::runtime_error("Uniform block " + block.name + " is " + std::to_string(block.data_size)
+				+ " bytes, expected " + std::to_string(size));
+
+		glUniformBlockBinding(id_, block.index, binding);
+		return;
+	}
+}
+
+}
@@ -0,0 +1,213 @@
+#include <engine/program_cache.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr std::uint32_t blob_magic = 0x31425047; // "GPB1"
+
+struct blob_header
+{
+	std::uint32_t magic;
+	std::uint32_t format;
+	std::uint32_t length;
+	std::uint32_t reserved;
+};
+
+// 64-bit FNV-1a, good enough to tell programs apart in a local cache
+struct hasher
+{
+	std::uint64_t value = 0xcbf29ce484222325ull;
+
+	void add(void const * data, std::size_t size)
+	{
+		auto bytes = static_cast<unsigned char const *>(data);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			value ^= bytes[i];
+			value *= 0x100000001b3ull;
+		}
+	}
+
+	void add(std::string_view str)
+	{
+		// The length separates consecutive strings, so "ab" + "c" != "a" + "bc"
+		std::uint64_t size = str.size();
+		add(&size, sizeof(size));
+		add(str.data(), str.size());
+	}
+};
+
+unsigned long current_process_id()
+{
+#ifdef _WIN32
+	return static_cast<unsigned long>(_getpid());
+#else
+	return static_cast<unsigned long>(getpid());
+#endif
+}
+
+std::string_view gl_string(GLenum name)
+{
+	auto str = reinterpret_cast<char const *>(glGetString(name));
+	return str ? str : "";
+}
+
+}
+
+program_cache::program_cache(std::filesystem::path directory)
+	: directory_(std::move(directory))
+{
+	hasher h;
+	h.add(gl_string(GL_VENDOR));
+	h.add(gl_string(GL_RENDERER));
+	h.add(gl_string(GL_VERSION));
+	driver_hash_ = h.value;
+
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+		return;
+
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	if (format_count == 0)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory_, error);
+	enabled_ = !error;
+}
+
+std::uint64_t program_cache::key(std::initializer_list<shader_source> sources, std::string_view defines) const
+{
+	hasher h;
+	h.add(&driver_hash_, sizeof(driver_hash_));
+	h.add(defines);
+	for (auto const & source : sources)
+	{
+		h.add(&source.type, sizeof(source.type));
+		h.add(source.source);
+	}
+	return h.value;
+}
+
+GLuint program_cache::load(std::uint64_t key)
+{
+	if (!enabled_)
+		return 0;
+
+	std::error_code size_error;
+	auto file_size = std::filesystem::file_size(path(key), size_error);
+	if (size_error)
+		return 0;
+
+	std::ifstream file(path(key), std::ios::binary);
+	if (!file)
+		return 0;
+
+	// The length has to account for the rest of the file, so that a
+	// corrupt header cannot ask for an arbitrarily large allocation
+	blob_header header;
+	if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != blob_magic
+		|| file_size != sizeof(header) + std::uintmax_t(header.length))
+		return 0;
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), binary.size()))
+		return 0;
+
+	GLuint result = glCreateProgram();
+	glProgramBinary(result, header.format, binary.data(), binary.size());
+
+	GLint status;
+	glGetProgramiv(result, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		// Stale blob, e.g. after a driver update that kept the version string
+		glDeleteProgram(result);
+		file.close();
+		std::error_code error;
+		std::filesystem::remove(path(key), error);
+		++stats_.rejected;
+		return 0;
+	}
+
+	++stats_.loaded;
+	return result;
+}
+
+void program_cache::store(std::uint64_t key, GLuint program)
+{
+	++stats_.compiled;
+
+	if (!enabled_)
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	blob_header header{blob_magic, format, static_cast<std::uint32_t>(length), 0};
+
+	// Write to a temporary file of this process first so that concurrently
+	// running demos neither see a partially written blob nor write into
+	// the same temporary file
+	auto target = path(key);
+	auto temporary = target;
+	temporary += "." + std::to_string(current_process_id()) + ".tmp";
+	bool written;
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+		file.write(binary.data(), length);
+		written = static_cast<bool>(file);
+	}
+
+	// Per-process temporary files would pile up if left behind
+	std::error_code error;
+	if (written)
+		std::filesystem::rename(temporary, target, error);
+	if (!written || error)
+		std::filesystem::remove(temporary, error);
+}
+
+std::filesystem::path program_cache::path(std::uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory_ / name;
+}
+
+std::filesystem::path default_program_cache_directory()
+{
+	if (auto root = std::getenv("GRAPHICS_COURSE_CACHE"))
+		return std::filesystem::path(root) / "programs";
+
+	std::error_code error;
+	auto temp = std::filesystem::temp_directory_path(error);
+	if (error)
+		temp = ".";
+	return temp / "graphics-course-practice" / "programs";
+}
+
+}
@@ -0,0 +1,115 @@
+#include <engine/session.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr char session_magic[8] = {'G', 'C', 'S', 'E', 'S', 'S', '0', '1'};
+
+struct session_header
+{
+	char magic[8];
+	std::uint32_t event_size;
+};
+
+struct frame_header
+{
+	float dt;
+	std::uint32_t event_count;
+};
+
+}
+
+bool is_session_event(SDL_Event const & event)
+{
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+	case SDL_MOUSEMOTION:
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+	case SDL_MOUSEWHEEL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+session_writer::session_writer(std::string const & path)
+	: file_(path, std::ios::binary | std::ios::trunc)
+{
+	if (!file_)
+		throw std::runtime_error("Failed to create session file " + path);
+
+	session_header header{};
+	std::memcpy(header.magic, session_magic, sizeof(session_magic));
+	header.event_size = sizeof(SDL_Event);
+	file_.write(reinterpret_cast<char const *>(&header), sizeof(header));
+}
+
+void session_writer::write_frame(float dt, std::vector<SDL_Event> const & events)
+{
+	frame_header header{dt, static_cast<std::uint32_t>(events.size())};
+	file_.write(reinterpret_cast<char const *>(&header), sizeof(header));
+	file_.write(reinterpret_cast<char const *>(events.data()), events.size() * sizeof(SDL_Event));
+}
+
+session_reader::session_reader(std::string const & path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("Failed to open session file " + path);
+	data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	session_header header;
+	if (data_.size() < sizeof(header))
+		throw std::runtime_error("Session file is truncated: " + path);
+	std::memcpy(&header, data_.data(), sizeof(header));
+	if (std::memcmp(header.magic, session_magic, sizeof(session_magic)) != 0)
+		throw std::runtime_error("Not a session file: " + path);
+	if (header.event_size != sizeof(SDL_Event))
+		throw std::runtime_error("Session file was recorded with a different SDL_Event layout: " + path);
+
+	// Validate the whole stream upfront rather than failing mid-replay;
+	// a partially written last frame (e.g. the recording crashed) is ignored
+	std::size_t offset = sizeof(header);
+	while (offset + sizeof(frame_header) <= data_.size())
+	{
+		frame_header frame;
+		std::memcpy(&frame, data_.data() + offset, sizeof(frame));
+		std::size_t frame_size = sizeof(frame) + std::size_t(frame.event_count) * sizeof(SDL_Event);
+		if (offset + frame_size > data_.size())
+			break;
+		offset += frame_size;
+		++frame_count_;
+	}
+	data_.resize(offset);
+
+	offset_ = sizeof(header);
+}
+
+bool session_reader::read_frame(float & dt, std::vector<SDL_Event> & events)
+{
+	events.clear();
+	if (offset_ == data_.size())
+		return false;
+
+	frame_header frame;
+	std::memcpy(&frame, data_.data() + offset_, sizeof(frame));
+	offset_ += sizeof(frame);
+
+	dt = frame.dt;
+	events.resize(frame.event_count);
+	std::memcpy(events.data(), data_.data() + offset_, frame.event_count * sizeof(SDL_Event));
+	offset_ += frame.event_count * sizeof(SDL_Event);
+	return true;
+}
+
+}
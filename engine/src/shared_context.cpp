@@ -0,0 +1,98 @@
+#include <engine/shared_context.hpp>
+
+#ifdef ENGINE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace engine
+{
+
+std::unique_ptr<shared_context> shared_context::create(SDL_Window * window, SDL_GLContext context)
+{
+	// Creating a context makes it current, the window's one has to be
+	// current beforehand to be shared with
+	if (SDL_GL_MakeCurrent(window, context) != 0)
+		return nullptr;
+
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	SDL_GLContext shared = SDL_GL_CreateContext(window);
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+	SDL_GL_MakeCurrent(window, context);
+
+	if (!shared)
+		return nullptr;
+
+	std::unique_ptr<shared_context> result(new shared_context);
+	result->window_ = window;
+	result->sdl_context_ = shared;
+	return result;
+}
+
+#ifdef ENGINE_HAS_EGL
+
+std::unique_ptr<shared_context> shared_context::create_egl(void * display, void * context)
+{
+	EGLint const context_attributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE,
+	};
+
+	EGLContext shared = eglCreateContext(display, EGL_NO_CONFIG_KHR, context, context_attributes);
+	if (shared == EGL_NO_CONTEXT)
+		return nullptr;
+
+	std::unique_ptr<shared_context> result(new shared_context);
+	result->display_ = display;
+	result->egl_context_ = shared;
+	return result;
+}
+
+#else
+
+std::unique_ptr<shared_context> shared_context::create_egl(void *, void *)
+{
+	return nullptr;
+}
+
+#endif
+
+shared_context::~shared_context()
+{
+	if (sdl_context_)
+		SDL_GL_DeleteContext(sdl_context_);
+#ifdef ENGINE_HAS_EGL
+	if (egl_context_)
+		eglDestroyContext(display_, egl_context_);
+#endif
+}
+
+bool shared_context::make_current()
+{
+	if (sdl_context_)
+		return SDL_GL_MakeCurrent(window_, sdl_context_) == 0;
+#ifdef ENGINE_HAS_EGL
+	if (egl_context_)
+		return eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context_);
+#endif
+	return false;
+}
+
+void shared_context::release()
+{
+	if (sdl_context_)
+		SDL_GL_MakeCurrent(window_, nullptr);
+#ifdef ENGINE_HAS_EGL
+	if (egl_context_)
+	{
+		eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglReleaseThread();
+	}
+#endif
+}
+
+}
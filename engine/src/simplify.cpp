@@ -0,0 +1,509 @@
+#include <engine/simplify.hpp>
+#include <engine/mesh_optimize.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace engine
+{
+
+namespace
+{
+
+// Sum of squared distances to a set of weighted planes, as the
+// symmetric matrix of the planes' outer products
+struct quadric
+{
+	float a2 = 0.f, b2 = 0.f, c2 = 0.f, d2 = 0.f;
+	float ab = 0.f, ac = 0.f, ad = 0.f, bc = 0.f, bd = 0.f, cd = 0.f;
+	float weight = 0.f;
+
+	static quadric plane(glm::vec3 const & normal, float distance, float weight)
+	{
+		quadric q;
+		q.a2 = weight * normal.x * normal.x;
+		q.b2 = weight * normal.y * normal.y;
+		q.c2 = weight * normal.z * normal.z;
+		q.d2 = weight * distance * distance;
+		q.ab = weight * normal.x * normal.y;
+		q.ac = weight * normal.x * normal.z;
+		q.ad = weight * normal.x * distance;
+		q.bc = weight * normal.y * normal.z;
+		q.bd = weight * normal.y * distance;
+		q.cd = weight * normal.z * distance;
+		q.weight = weight;
+		return q;
+	}
+
+	quadric & operator += (quadric const & q)
+	{
+		a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+		ab += q.ab; ac += q.ac; ad += q.ad; bc += q.bc; bd += q.bd; cd += q.cd;
+		weight += q.weight;
+		return *this;
+	}
+
+	// Weighted average squared distance of p to the planes
+	float error(glm::vec3 const & p) const
+	{
+		float rx = a2 * p.x + ab * p.y + ac * p.z + ad;
+		float ry = ab * p.x + b2 * p.y + bc * p.z + bd;
+		float rz = ac * p.x + bc * p.y + c2 * p.z + cd;
+		float r = rx * p.x + ry * p.y + rz * p.z + (ad * p.x + bd * p.y + cd * p.z + d2);
+		return weight > 0.f ? std::abs(r) / weight : 0.f;
+	}
+};
+
+quadric operator + (quadric a, quadric const & b)
+{
+	return a += b;
+}
+
+// Border planes are weighted up so that borders keep their shape
+float const border_weight = 10.f;
+
+// A collapse is rejected if it turns a triangle by more than about 75
+// degrees, which also rules out flipping it over
+float const max_normal_turn_cosine = 0.25f;
+
+std::uint64_t edge_key(std::uint32_t a, std::uint32_t b)
+{
+	return (std::uint64_t(a) << 32) | b;
+}
+
+enum class vertex_kind : std::uint8_t
+{
+	interior,
+	border,
+	locked,
+};
+
+struct collapse
+{
+	std::uint32_t from;
+	std::uint32_t to;
+	// Geometric error plus attribute penalty; the error reported is the
+	// geometric part alone
+	float cost;
+	float error;
+};
+
+class simplifier
+{
+public:
+	simplifier(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+		std::span<float const> attributes, std::span<float const> attribute_weights)
+		: indices_(indices.begin(), indices.end())
+		, attributes_(attributes)
+		, attribute_weights_(attribute_weights)
+	{
+		if (indices.size() % 3 != 0)
+			throw std::runtime_error("Index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+		for (auto index : indices)
+			if (index >= positions.size())
+				throw std::runtime_error("Index " + std::to_string(index) + " out of range, "
+					+ std::to_string(positions.size()) + " vertices");
+		if (attributes.size() != positions.size() * attribute_weights.size())
+			throw std::runtime_error("Expected " + std::to_string(attribute_weights.size()) + " attributes per vertex");
+
+		// Everything is scaled to a unit box, so that errors and attribute
+		// weights are relative to the size of the mesh
+		glm::vec3 min(std::numeric_limits<float>::infinity());
+		glm::vec3 max(-std::numeric_limits<float>::infinity());
+		for (auto const & p : positions)
+		{
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+		auto size = max - min;
+		scale_ = std::max({size.x, size.y, size.z, 0.f});
+		if (!(scale_ > 0.f))
+			scale_ = 1.f;
+
+		positions_.resize(positions.size());
+		for (std::size_t v = 0; v < positions.size(); ++v)
+			positions_[v] = (positions[v] - min) / scale_;
+
+		weld_positions();
+		compute_quadrics();
+	}
+
+	float scale() const { return scale_; }
+
+	std::vector<std::uint32_t> const & indices() const { return indices_; }
+
+	// Returns the largest error of a collapse made, relative to the mesh
+	// size
+	float run(std::size_t target_index_count, float max_error)
+	{
+		float const max_squared_error = max_error * max_error;
+		float result_error = 0.f;
+
+		while (indices_.size() > target_index_count)
+		{
+			classify_vertices();
+			build_adjacency();
+
+			auto collapses = pick_collapses();
+			std::sort(collapses.begin(), collapses.end(), [](collapse const & a, collapse const & b){ return a.cost < b.cost; });
+
+			std::size_t const triangles_to_remove = (indices_.size() - target_index_count + 2) / 3;
+			std::size_t removed = 0;
+
+			std::vector<std::uint32_t> remap(positions_.size());
+			for (std::uint32_t v = 0; v < remap.size(); ++v)
+				remap[v] = v;
+			std::vector<bool> pass_locked(positions_.size(), false);
+
+			for (auto const & c : collapses)
+			{
+				if (removed >= triangles_to_remove)
+					break;
+				if (c.error > max_squared_error || pass_locked[c.from] || pass_locked[c.to] || flips(c.from, c.to))
+					continue;
+
+				remap[c.from] = c.to;
+				quadrics_[c.to] += quadrics_[c.from];
+				result_error = std::max(result_error, std::sqrt(c.error));
+				removed += kinds_[c.from] == vertex_kind::border ? 1 : 2;
+
+				// The triangles around the collapsed vertex change, their
+				// vertices must not move again in this pass
+				pass_locked[c.from] = pass_locked[c.to] = true;
+				for (auto t : triangles_of(c.from))
+					for (int k = 0; k < 3; ++k)
+						pass_locked[indices_[3 * t + k]] = true;
+			}
+
+			if (removed == 0)
+				break;
+
+			std::size_t output = 0;
+			for (std::size_t i = 0; i < indices_.size(); i += 3)
+			{
+				std::uint32_t a = remap[indices_[i]], b = remap[indices_[i + 1]], c = remap[indices_[i + 2]];
+				std::uint32_t wa = welded_[a], wb = welded_[b], wc = welded_[c];
+				if (wa == wb || wb == wc || wc == wa)
+					continue;
+				indices_[output++] = a;
+				indices_[output++] = b;
+				indices_[output++] = c;
+			}
+			indices_.resize(output);
+		}
+
+		return result_error;
+	}
+
+private:
+	std::vector<std::uint32_t> indices_;
+	std::vector<glm::vec3> positions_;
+	std::span<float const> attributes_;
+	std::span<float const> attribute_weights_;
+	float scale_ = 1.f;
+
+	// First vertex with the same position, the topology is built on these
+	std::vector<std::uint32_t> welded_;
+	std::vector<bool> seam_;
+	std::vector<quadric> quadrics_;
+	std::vector<vertex_kind> kinds_;
+
+	// Directed welded edges of the current triangles, sorted
+	std::vector<std::uint64_t> edges_;
+
+	// Current triangles of every vertex
+	std::vector<std::uint32_t> adjacency_offset_;
+	std::vector<std::uint32_t> adjacency_;
+
+	void weld_positions()
+	{
+		struct hash
+		{
+			std::size_t operator()(glm::vec3 const & p) const
+			{
+				auto bits = [](float x){ std::uint32_t u; std::memcpy(&u, &x, sizeof(u)); return u; };
+				return (bits(p.x) * 73856093u) ^ (bits(p.y) * 19349663u) ^ (bits(p.z) * 83492791u);
+			}
+		};
+
+		std::unordered_map<glm::vec3, std::uint32_t, hash> first;
+		first.reserve(positions_.size());
+		welded_.resize(positions_.size());
+		seam_.assign(positions_.size(), false);
+		for (std::uint32_t v = 0; v < positions_.size(); ++v)
+		{
+			auto [it, inserted] = first.emplace(positions_[v], v);
+			welded_[v] = it->second;
+			if (!inserted)
+				seam_[v] = seam_[it->second] = true;
+		}
+	}
+
+	bool is_border_edge(std::uint32_t a, std::uint32_t b) const
+	{
+		return !std::binary_search(edges_.begin(), edges_.end(), edge_key(welded_[b], welded_[a]));
+	}
+
+	void collect_edges()
+	{
+		edges_.clear();
+		edges_.reserve(indices_.size());
+		for (std::size_t i = 0; i < indices_.size(); i += 3)
+			for (int k = 0; k < 3; ++k)
+				edges_.push_back(edge_key(welded_[indices_[i + k]], welded_[indices_[i + (k + 1) % 3]]));
+		std::sort(edges_.begin(), edges_.end());
+	}
+
+	void compute_quadrics()
+	{
+		quadrics_.assign(positions_.size(), quadric{});
+		collect_edges();
+
+		for (std::size_t i = 0; i < indices_.size(); i += 3)
+		{
+			auto const & p0 = positions_[indices_[i]];
+			auto const & p1 = positions_[indices_[i + 1]];
+			auto const & p2 = positions_[indices_[i + 2]];
+
+			auto normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length == 0.f)
+				continue;
+			normal /= length;
+
+			// Weighted by area
+			auto q = quadric::plane(normal, -glm::dot(normal, p0), 0.5f * length);
+			for (int k = 0; k < 3; ++k)
+				quadrics_[indices_[i + k]] += q;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				auto a = indices_[i + k];
+				auto b = indices_[i + (k + 1) % 3];
+				if (!is_border_edge(a, b))
+					continue;
+
+				auto edge = positions_[b] - positions_[a];
+				auto edge_normal = glm::cross(edge, normal);
+				float edge_length = glm::length(edge_normal);
+				if (edge_length == 0.f)
+					continue;
+				edge_normal /= edge_length;
+
+				auto border = quadric::plane(edge_normal, -glm::dot(edge_normal, positions_[a]), border_weight * glm::dot(edge, edge));
+				quadrics_[a] += border;
+				quadrics_[b] += border;
+			}
+		}
+	}
+
+	void classify_vertices()
+	{
+		collect_edges();
+
+		std::vector<std::uint32_t> border_edges(positions_.size(), 0);
+		for (std::size_t i = 0; i < indices_.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				auto a = indices_[i + k];
+				auto b = indices_[i + (k + 1) % 3];
+				if (is_border_edge(a, b))
+				{
+					++border_edges[welded_[a]];
+					++border_edges[welded_[b]];
+				}
+			}
+		}
+
+		kinds_.resize(positions_.size());
+		for (std::uint32_t v = 0; v < positions_.size(); ++v)
+		{
+			auto count = border_edges[welded_[v]];
+			// Seams are not collapsed, neither are vertices where borders
+			// meet, which would tear the surface apart
+			if (seam_[v] || (count != 0 && count != 2))
+				kinds_[v] = vertex_kind::locked;
+			else
+				kinds_[v] = count == 0 ? vertex_kind::interior : vertex_kind::border;
+		}
+	}
+
+	void build_adjacency()
+	{
+		adjacency_offset_.assign(positions_.size() + 1, 0);
+		for (auto index : indices_)
+			++adjacency_offset_[index + 1];
+		for (std::size_t v = 0; v < positions_.size(); ++v)
+			adjacency_offset_[v + 1] += adjacency_offset_[v];
+
+		adjacency_.resize(indices_.size());
+		std::vector<std::uint32_t> fill(adjacency_offset_.begin(), adjacency_offset_.end() - 1);
+		for (std::size_t i = 0; i < indices_.size(); ++i)
+			adjacency_[fill[indices_[i]]++] = i / 3;
+	}
+
+	std::span<std::uint32_t const> triangles_of(std::uint32_t v) const
+	{
+		return std::span(adjacency_).subspan(adjacency_offset_[v], adjacency_offset_[v + 1] - adjacency_offset_[v]);
+	}
+
+	float attribute_cost(std::uint32_t from, std::uint32_t to) const
+	{
+		auto const count = attribute_weights_.size();
+		float cost = 0.f;
+		for (std::size_t k = 0; k < count; ++k)
+		{
+			float d = attribute_weights_[k] * (attributes_[from * count + k] - attributes_[to * count + k]);
+			cost += d * d;
+		}
+		return cost;
+	}
+
+	bool can_collapse(std::uint32_t from, std::uint32_t to) const
+	{
+		switch (kinds_[from])
+		{
+		case vertex_kind::interior:
+			return true;
+		case vertex_kind::border:
+			// Along the border only, either direction
+			return is_border_edge(from, to) || is_border_edge(to, from);
+		default:
+			return false;
+		}
+	}
+
+	std::vector<collapse> pick_collapses() const
+	{
+		// The cheapest collapse of every vertex
+		std::vector<collapse> best(positions_.size(), collapse{0, 0, std::numeric_limits<float>::infinity(), 0.f});
+
+		for (std::size_t i = 0; i < indices_.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				std::uint32_t a = indices_[i + k];
+				std::uint32_t b = indices_[i + (k + 1) % 3];
+				for (auto [from, to] : {std::pair{a, b}, std::pair{b, a}})
+				{
+					if (!can_collapse(from, to))
+						continue;
+					float error = (quadrics_[from] + quadrics_[to]).error(positions_[to]);
+					float cost = error + attribute_cost(from, to);
+					if (cost < best[from].cost)
+						best[from] = {from, to, cost, error};
+				}
+			}
+		}
+
+		std::vector<collapse> result;
+		for (auto const & c : best)
+			if (c.cost < std::numeric_limits<float>::infinity())
+				result.push_back(c);
+		return result;
+	}
+
+	bool flips(std::uint32_t from, std::uint32_t to) const
+	{
+		auto const & target = positions_[to];
+		for (auto t : triangles_of(from))
+		{
+			std::uint32_t const * triangle = &indices_[3 * t];
+			if (welded_[triangle[0]] == welded_[to] || welded_[triangle[1]] == welded_[to] || welded_[triangle[2]] == welded_[to])
+				continue;
+
+			glm::vec3 p[3] = {positions_[triangle[0]], positions_[triangle[1]], positions_[triangle[2]]};
+			auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			for (int k = 0; k < 3; ++k)
+				if (triangle[k] == from)
+					p[k] = target;
+			auto after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+			if (glm::dot(before, after) < max_normal_turn_cosine * glm::length(before) * glm::length(after))
+				return true;
+		}
+		return false;
+	}
+};
+
+}
+
+simplify_result simplify(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::size_t target_index_count, float max_error, std::span<float const> attributes,
+	std::span<float const> attribute_weights)
+{
+	simplifier s(indices, positions, attributes, attribute_weights);
+	float error = s.run(target_index_count, max_error / s.scale());
+	return {s.indices(), error * s.scale()};
+}
+
+lod_chain build_lod_chain(std::span<std::uint32_t const> indices, std::span<glm::vec3 const> positions,
+	std::span<float const> triangle_ratios, std::span<float const> attributes,
+	std::span<float const> attribute_weights)
+{
+	lod_chain result;
+	result.indices.assign(indices.begin(), indices.end());
+	optimize_vertex_cache(result.indices, positions.size());
+	result.lods.push_back({0, static_cast<std::uint32_t>(indices.size()), 0.f});
+
+	std::vector<std::uint32_t> previous(result.indices);
+	float error = 0.f;
+
+	for (float ratio : triangle_ratios)
+	{
+		std::size_t target = static_cast<std::size_t>(indices.size() / 3 * ratio) * 3;
+		auto simplified = simplify(previous, positions, target, std::numeric_limits<float>::infinity(), attributes, attribute_weights);
+		if (simplified.indices.size() >= previous.size() || simplified.indices.empty())
+			continue;
+
+		// Errors of successive simplifications add up at worst
+		error += simplified.error;
+		optimize_vertex_cache(simplified.indices, positions.size());
+
+		result.lods.push_back({static_cast<std::uint32_t>(result.indices.size()), static_cast<std::uint32_t>(simplified.indices.size()), error});
+		result.indices.insert(result.indices.end(), simplified.indices.begin(), simplified.indices.end());
+		previous = std::move(simplified.indices);
+	}
+
+	return result;
+}
+
+std::string lod_report(std::span<mesh_lod const> lods)
+{
+	std::ostringstream report;
+	report.precision(3);
+	report << "Levels of detail:";
+	for (std::size_t i = 0; i < lods.size(); ++i)
+		report << (i ? ", " : " ") << lods[i].index_count / 3 << " triangles (error " << lods[i].error << ")";
+	return report.str();
+}
+
+float perspective_pixels_per_unit(float fovy, float viewport_height, float distance)
+{
+	return viewport_height / (2.f * std::tan(fovy / 2.f) * std::max(distance, 1e-6f));
+}
+
+float orthographic_pixels_per_unit(float view_height, float viewport_height)
+{
+	return viewport_height / view_height;
+}
+
+std::size_t select_lod(std::span<mesh_lod const> lods, float pixels_per_unit, float max_pixels)
+{
+	std::size_t result = 0;
+	for (std::size_t i = 1; i < lods.size(); ++i)
+		if (lods[i].error * pixels_per_unit <= max_pixels)
+			result = i;
+	return result;
+}
+
+}
@@ -0,0 +1,207 @@
+#include <engine/state.hpp>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr std::size_t unknown = ~std::size_t(0);
+
+std::size_t texture_target_index(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_1D:                   return 0;
+	case GL_TEXTURE_2D:                   return 1;
+	case GL_TEXTURE_3D:                   return 2;
+	case GL_TEXTURE_1D_ARRAY:             return 3;
+	case GL_TEXTURE_2D_ARRAY:             return 4;
+	case GL_TEXTURE_RECTANGLE:            return 5;
+	case GL_TEXTURE_CUBE_MAP:             return 6;
+	case GL_TEXTURE_BUFFER:               return 7;
+	case GL_TEXTURE_2D_MULTISAMPLE:       return 8;
+	case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return 9;
+	default:                              return unknown;
+	}
+}
+
+std::size_t capability_index(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_BLEND:                     return 0;
+	case GL_CULL_FACE:                 return 1;
+	case GL_DEPTH_TEST:                return 2;
+	case GL_DEPTH_CLAMP:               return 3;
+	case GL_SCISSOR_TEST:              return 4;
+	case GL_STENCIL_TEST:              return 5;
+	case GL_POLYGON_OFFSET_FILL:       return 6;
+	case GL_POLYGON_OFFSET_LINE:       return 7;
+	case GL_MULTISAMPLE:               return 8;
+	case GL_SAMPLE_ALPHA_TO_COVERAGE:  return 9;
+	case GL_FRAMEBUFFER_SRGB:          return 10;
+	case GL_PROGRAM_POINT_SIZE:        return 11;
+	case GL_PRIMITIVE_RESTART:         return 12;
+	case GL_RASTERIZER_DISCARD:        return 13;
+	case GL_TEXTURE_CUBE_MAP_SEAMLESS: return 14;
+	case GL_LINE_SMOOTH:               return 15;
+	default:                           return unknown;
+	}
+}
+
+}
+
+state_statistics & state_counters()
+{
+	static state_statistics counters;
+	return counters;
+}
+
+template <typename T>
+bool gl_state::change(tracked<T> & state, T const & value)
+{
+	auto & counters = state_counters();
+	if (state.known && state.value == value)
+	{
+		++counters.filtered;
+		return false;
+	}
+
+	state.value = value;
+	state.known = true;
+	++counters.issued;
+	return true;
+}
+
+void gl_state::use_program(GLuint program)
+{
+	if (change(program_, program))
+		glUseProgram(program);
+}
+
+void gl_state::bind_vertex_array(GLuint vertex_array)
+{
+	if (change(vertex_array_, vertex_array))
+		glBindVertexArray(vertex_array);
+}
+
+void gl_state::active_texture(GLuint unit)
+{
+	if (change(active_texture_, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void gl_state::bind_texture(GLuint unit, GLenum target, GLuint texture)
+{
+	auto index = texture_target_index(target);
+	if (unit >= max_texture_units || index == unknown)
+	{
+		active_texture(unit);
+		++state_counters().issued;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	auto & binding = textures_[unit][index];
+	if (binding.known && binding.value == texture)
+	{
+		++state_counters().filtered;
+		return;
+	}
+
+	active_texture(unit);
+	change(binding, texture);
+	glBindTexture(target, texture);
+}
+
+void gl_state::bind_framebuffer(GLenum target, GLuint framebuffer)
+{
+	switch (target)
+	{
+	case GL_DRAW_FRAMEBUFFER:
+		if (change(draw_framebuffer_, framebuffer))
+			glBindFramebuffer(target, framebuffer);
+		break;
+	case GL_READ_FRAMEBUFFER:
+		if (change(read_framebuffer_, framebuffer))
+			glBindFramebuffer(target, framebuffer);
+		break;
+	default:
+		if (draw_framebuffer_.known && draw_framebuffer_.value == framebuffer
+			&& read_framebuffer_.known && read_framebuffer_.value == framebuffer)
+		{
+			++state_counters().filtered;
+			break;
+		}
+		draw_framebuffer_ = {framebuffer, true};
+		read_framebuffer_ = {framebuffer, true};
+		++state_counters().issued;
+		glBindFramebuffer(target, framebuffer);
+		break;
+	}
+}
+
+void gl_state::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (change(viewport_, {x, y, width, height}))
+		glViewport(x, y, width, height);
+}
+
+void gl_state::set(GLenum capability, bool enabled)
+{
+	auto index = capability_index(capability);
+	if (index != unknown && !change(capabilities_[index], enabled))
+		return;
+
+	if (index == unknown)
+		++state_counters().issued;
+
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void gl_state::depth_func(GLenum func)
+{
+	if (change(depth_func_, func))
+		glDepthFunc(func);
+}
+
+void gl_state::depth_mask(bool write)
+{
+	if (change(depth_mask_, write))
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void gl_state::cull_face(GLenum face)
+{
+	if (change(cull_face_, face))
+		glCullFace(face);
+}
+
+void gl_state::front_face(GLenum mode)
+{
+	if (change(front_face_, mode))
+		glFrontFace(mode);
+}
+
+void gl_state::blend_func(GLenum source, GLenum destination)
+{
+	if (change(blend_func_, {source, destination}))
+		glBlendFunc(source, destination);
+}
+
+void gl_state::blend_equation(GLenum mode)
+{
+	if (change(blend_equation_, mode))
+		glBlendEquation(mode);
+}
+
+void gl_state::invalidate()
+{
+	*this = gl_state();
+}
+
+}
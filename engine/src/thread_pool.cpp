@@ -0,0 +1,108 @@
+#include <engine/thread_pool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace engine
+{
+
+thread_pool::thread_pool(unsigned threads)
+{
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	workers_.reserve(threads - 1);
+	for (unsigned i = 1; i < threads; ++i)
+		workers_.emplace_back([this]{ worker(); });
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	work_ready_.notify_all();
+
+	for (auto & thread : workers_)
+		thread.join();
+}
+
+void thread_pool::run(std::size_t count, void const * task, call_type call)
+{
+	if (count == 0)
+		return;
+
+	if (workers_.empty() || count == 1)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			call(task, i);
+		return;
+	}
+
+	{
+		std::lock_guard lock(mutex_);
+		task_ = task;
+		call_ = call;
+		count_ = count;
+		next_.store(0, std::memory_order_relaxed);
+		busy_ = static_cast<unsigned>(workers_.size());
+		error_ = nullptr;
+		++generation_;
+	}
+	work_ready_.notify_all();
+
+	work();
+
+	std::unique_lock lock(mutex_);
+	work_done_.wait(lock, [this]{ return busy_ == 0; });
+
+	if (auto error = std::exchange(error_, nullptr))
+		std::rethrow_exception(error);
+}
+
+void thread_pool::work()
+{
+	for (std::size_t index; (index = next_.fetch_add(1, std::memory_order_relaxed)) < count_;)
+	{
+		try
+		{
+			call_(task_, index);
+		}
+		catch (...)
+		{
+			std::lock_guard lock(mutex_);
+			if (!error_)
+				error_ = std::current_exception();
+			// Nobody picks up the remaining indices
+			next_.store(count_, std::memory_order_relaxed);
+		}
+	}
+}
+
+void thread_pool::worker()
+{
+	std::uint64_t seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock lock(mutex_);
+			work_ready_.wait(lock, [&]{ return stopping_ || generation_ != seen; });
+			if (stopping_)
+				return;
+			seen = generation_;
+		}
+
+		work();
+
+		bool last;
+		{
+			std::lock_guard lock(mutex_);
+			last = (--busy_ == 0);
+		}
+		if (last)
+			work_done_.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,119 @@
+#include <engine/uniform_ring.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace engine
+{
+
+namespace
+{
+
+std::size_t align_up(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+uniform_ring::uniform_ring(std::size_t frame_capacity)
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		alignment_ = alignment;
+
+	frame_capacity_ = align_up(frame_capacity, alignment_);
+	auto total_size = static_cast<GLsizeiptr>(frame_capacity_ * frames_in_flight);
+
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, total_size, nullptr, flags);
+		mapping_ = static_cast<unsigned char *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, total_size, flags));
+	}
+
+	if (!mapping_)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+		staging_.resize(frame_capacity_);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+uniform_ring::~uniform_ring()
+{
+	for (auto fence : fences_)
+		if (fence)
+			glDeleteSync(fence);
+
+	if (mapping_)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	glDeleteBuffers(1, &buffer_);
+}
+
+void uniform_ring::begin_frame()
+{
+	region_ = (region_ + 1) % frames_in_flight;
+	used_ = 0;
+	flushed_ = 0;
+
+	auto & fence = fences_[region_];
+	if (!fence)
+		return;
+
+	// A zero-timeout poll first tells apart the frames that really stall
+	if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+	{
+		++stats_.stalls;
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+		{}
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void uniform_ring::end_frame()
+{
+	flush();
+	fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+uniform_ring::range uniform_ring::allocate(std::size_t size)
+{
+	std::size_t offset = align_up(used_, alignment_);
+	if (offset + size > frame_capacity_)
+		throw std::runtime_error("Uniform ring overflow: " + std::to_string(offset + size)
+			+ " bytes requested in a frame, capacity is " + std::to_string(frame_capacity_));
+
+	used_ = offset + size;
+	stats_.bytes += size;
+	++stats_.blocks;
+
+	std::size_t region_offset = region_ * frame_capacity_;
+	void * data = mapping_ ? mapping_ + region_offset + offset : staging_.data() + offset;
+	return {buffer_, static_cast<GLintptr>(region_offset + offset), static_cast<GLsizeiptr>(size), data};
+}
+
+void uniform_ring::flush()
+{
+	if (mapping_ || flushed_ == used_)
+		return;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+	glBufferSubData(GL_UNIFORM_BUFFER, region_ * frame_capacity_ + flushed_, used_ - flushed_, staging_.data() + flushed_);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	flushed_ = used_;
+}
+
+}
@@ -0,0 +1,309 @@
+#include <engine/uniforms.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace engine
+{
+
+namespace
+{
+
+using scalar_kind = detail::uniform_kind;
+
+struct type_info
+{
+	scalar_kind kind;
+	// Vector components, or columns * rows for matrices
+	int components;
+	// Zero for scalars and vectors
+	int columns;
+};
+
+type_info describe(GLenum type)
+{
+	switch (type)
+	{
+	case GL_FLOAT:             return {scalar_kind::floating, 1, 0};
+	case GL_FLOAT_VEC2:        return {scalar_kind::floating, 2, 0};
+	case GL_FLOAT_VEC3:        return {scalar_kind::floating, 3, 0};
+	case GL_FLOAT_VEC4:        return {scalar_kind::floating, 4, 0};
+	case GL_FLOAT_MAT2:        return {scalar_kind::floating, 4, 2};
+	case GL_FLOAT_MAT2x3:      return {scalar_kind::floating, 6, 2};
+	case GL_FLOAT_MAT2x4:      return {scalar_kind::floating, 8, 2};
+	case GL_FLOAT_MAT3x2:      return {scalar_kind::floating, 6, 3};
+	case GL_FLOAT_MAT3:        return {scalar_kind::floating, 9, 3};
+	case GL_FLOAT_MAT3x4:      return {scalar_kind::floating, 12, 3};
+	case GL_FLOAT_MAT4x2:      return {scalar_kind::floating, 8, 4};
+	case GL_FLOAT_MAT4x3:      return {scalar_kind::floating, 12, 4};
+	case GL_FLOAT_MAT4:        return {scalar_kind::floating, 16, 4};
+	case GL_INT_VEC2:
+	case GL_BOOL_VEC2:         return {scalar_kind::integer, 2, 0};
+	case GL_INT_VEC3:
+	case GL_BOOL_VEC3:         return {scalar_kind::integer, 3, 0};
+	case GL_INT_VEC4:
+	case GL_BOOL_VEC4:         return {scalar_kind::integer, 4, 0};
+	case GL_UNSIGNED_INT:      return {scalar_kind::unsigned_integer, 1, 0};
+	case GL_UNSIGNED_INT_VEC2: return {scalar_kind::unsigned_integer, 2, 0};
+	case GL_UNSIGNED_INT_VEC3: return {scalar_kind::unsigned_integer, 3, 0};
+	case GL_UNSIGNED_INT_VEC4: return {scalar_kind::unsigned_integer, 4, 0};
+	// int, bool and all the sampler types
+	default:                   return {scalar_kind::integer, 1, 0};
+	}
+}
+
+// Doubles (GL 4.0 or ARB_gpu_shader_fp64) have no setter in the table
+bool is_double(GLenum type)
+{
+	switch (type)
+	{
+	case GL_DOUBLE:
+	case GL_DOUBLE_VEC2:
+	case GL_DOUBLE_VEC3:
+	case GL_DOUBLE_VEC4:
+	case GL_DOUBLE_MAT2:
+	case GL_DOUBLE_MAT2x3:
+	case GL_DOUBLE_MAT2x4:
+	case GL_DOUBLE_MAT3x2:
+	case GL_DOUBLE_MAT3:
+	case GL_DOUBLE_MAT3x4:
+	case GL_DOUBLE_MAT4x2:
+	case GL_DOUBLE_MAT4x3:
+	case GL_DOUBLE_MAT4:
+		return true;
+	}
+	return false;
+}
+
+std::uint32_t hash(std::string_view name)
+{
+	std::uint32_t result = 2166136261u;
+	for (char c : name)
+	{
+		result ^= static_cast<unsigned char>(c);
+		result *= 16777619u;
+	}
+	return result;
+}
+
+void issue(GLenum type, GLint location, void const * data)
+{
+	auto info = describe(type);
+	auto f = static_cast<GLfloat const *>(data);
+	auto i = static_cast<GLint const *>(data);
+	auto u = static_cast<GLuint const *>(data);
+
+	if (info.columns)
+	{
+		switch (type)
+		{
+		case GL_FLOAT_MAT2:   glUniformMatrix2fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT2x3: glUniformMatrix2x3fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT2x4: glUniformMatrix2x4fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT3x2: glUniformMatrix3x2fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT3:   glUniformMatrix3fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT3x4: glUniformMatrix3x4fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT4x2: glUniformMatrix4x2fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT4x3: glUniformMatrix4x3fv(location, 1, GL_FALSE, f); break;
+		case GL_FLOAT_MAT4:   glUniformMatrix4fv(location, 1, GL_FALSE, f); break;
+		}
+		return;
+	}
+
+	switch (info.kind)
+	{
+	case scalar_kind::floating: switch (info.components)
+		{
+		case 1: glUniform1fv(location, 1, f); break;
+		case 2: glUniform2fv(location, 1, f); break;
+		case 3: glUniform3fv(location, 1, f); break;
+		case 4: glUniform4fv(location, 1, f); break;
+		}
+		break;
+	case scalar_kind::integer: switch (info.components)
+		{
+		case 1: glUniform1iv(location, 1, i); break;
+		case 2: glUniform2iv(location, 1, i); break;
+		case 3: glUniform3iv(location, 1, i); break;
+		case 4: glUniform4iv(location, 1, i); break;
+		}
+		break;
+	case scalar_kind::unsigned_integer: switch (info.components)
+		{
+		case 1: glUniform1uiv(location, 1, u); break;
+		case 2: glUniform2uiv(location, 1, u); break;
+		case 3: glUniform3uiv(location, 1, u); break;
+		case 4: glUniform4uiv(location, 1, u); break;
+		}
+		break;
+	}
+}
+
+}
+
+uniform_statistics & uniform_counters()
+{
+	static uniform_statistics counters;
+	return counters;
+}
+
+uniform_table::uniform_table(GLuint program)
+{
+	GLint uniform_count = 0;
+	GLint max_name_length = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+	std::string name_buffer(std::max(max_name_length, 1), '\0');
+
+	for (GLint i = 0; i < uniform_count; ++i)
+	{
+		GLsizei name_length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, i, name_buffer.size(), &name_length, &size, &type, name_buffer.data());
+		std::string name(name_buffer.data(), name_length);
+
+		// Members of uniform blocks are backed by buffers and have no location
+		GLint location = glGetUniformLocation(program, name.c_str());
+		if (location == -1)
+			continue;
+
+		if (is_double(type))
+			throw std::runtime_error("Uniform " + name + " is a double, which uniform_table does not support");
+
+		bool array = name.ends_with("[0]");
+		if (array)
+			name.resize(name.size() - 3);
+
+		auto info = describe(type);
+
+		entry e;
+		e.name = name;
+		e.array = array;
+		e.type = type;
+		e.size = size;
+		e.first_location = locations_.size();
+		e.value_offset = values_.size();
+		e.value_size = info.components * 4;
+
+		// Elements of an array are not guaranteed to have consecutive locations
+		locations_.push_back(location);
+		for (GLint element = 1; element < size; ++element)
+			locations_.push_back(glGetUniformLocation(program, (name + "[" + std::to_string(element) + "]").c_str()));
+
+		values_.resize(values_.size() + std::size_t(size) * e.value_size);
+		entries_.push_back(std::move(e));
+	}
+
+	known_.assign(locations_.size(), 0);
+
+	// Four slots per entry: an array is also found as "name[0]", so the
+	// table is at most half full, which keeps the probe sequences short
+	slots_.assign(std::bit_ceil(entries_.size() * 4 + 1), uniform::invalid);
+	for (std::uint32_t index = 0; index < entries_.size(); ++index)
+	{
+		insert(entries_[index].name, index);
+		if (entries_[index].array)
+			insert(entries_[index].name + "[0]", index);
+	}
+
+	GLint block_count = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+	for (GLint i = 0; i < block_count; ++i)
+	{
+		GLint name_length = 0;
+		glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &name_length);
+		std::string name(std::max(name_length, 1), '\0');
+		glGetActiveUniformBlockName(program, i, name.size(), &name_length, name.data());
+		name.resize(name_length);
+
+		GLint data_size = 0;
+		glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+
+		blocks_.push_back({std::move(name), static_cast<GLuint>(i), data_size});
+	}
+}
+
+void uniform_table::insert(std::string_view name, std::uint32_t index)
+{
+	std::size_t mask = slots_.size() - 1;
+	for (std::size_t slot = hash(name) & mask;; slot = (slot + 1) & mask)
+	{
+		if (slots_[slot] == uniform::invalid)
+		{
+			slots_[slot] = index;
+			return;
+		}
+	}
+}
+
+uniform uniform_table::find(std::string_view name) const
+{
+	if (slots_.empty())
+		return {};
+
+	std::size_t mask = slots_.size() - 1;
+	for (std::size_t slot = hash(name) & mask; slots_[slot] != uniform::invalid; slot = (slot + 1) & mask)
+	{
+		auto const & e = entries_[slots_[slot]];
+		if (e.name == name || (e.array && name.size() == e.name.size() + 3 && name.starts_with(e.name) && name.ends_with("[0]")))
+			return {slots_[slot]};
+	}
+	return {};
+}
+
+GLuint uniform_table::block_index(std::string_view name) const
+{
+	for (auto const & block : blocks_)
+		if (block.name == name)
+			return block.index;
+	return GL_INVALID_INDEX;
+}
+
+GLint uniform_table::location(uniform u, std::size_t element) const
+{
+	if (!u || element >= std::size_t(entries_[u.index].size))
+		return -1;
+	return locations_[entries_[u.index].first_location + element];
+}
+
+void uniform_table::invalidate()
+{
+	std::fill(known_.begin(), known_.end(), 0);
+}
+
+void uniform_table::upload(uniform u, std::size_t element, detail::uniform_kind kind, int columns, void const * data, std::size_t size)
+{
+	if (!u)
+		return;
+
+	// Bools are set as ints, samplers as the int of their texture unit
+	auto const & e = entries_[u.index];
+	auto info = describe(e.type);
+	if (size != e.value_size || kind != info.kind || columns != info.columns)
+		throw std::runtime_error("Uniform type mismatch: " + e.name);
+	if (element >= std::size_t(e.size))
+		throw std::runtime_error("Uniform array index out of range: " + e.name + "[" + std::to_string(element) + "]");
+
+	auto slot = e.first_location + element;
+	auto shadow = values_.data() + e.value_offset + element * e.value_size;
+
+	auto & counters = uniform_counters();
+	if (known_[slot] && std::memcmp(shadow, data, size) == 0)
+	{
+		++counters.skipped;
+		return;
+	}
+
+	std::memcpy(shadow, data, size);
+	known_[slot] = 1;
+	++counters.issued;
+
+	issue(e.type, locations_[slot], data);
+}
+
+}
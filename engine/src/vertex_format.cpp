@@ -0,0 +1,186 @@
+#include <engine/vertex_format.hpp>
+
+#include <GL/glew.h>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine
+{
+
+namespace
+{
+
+float const position_steps = 65535.f;
+
+float sign_not_zero(float x)
+{
+	return x >= 0.f ? 1.f : -1.f;
+}
+
+}
+
+position_quantization::position_quantization(glm::vec3 const & bounds_min, glm::vec3 const & bounds_max)
+	: origin(bounds_min)
+{
+	auto size = bounds_max - bounds_min;
+	extent = std::max({size.x, size.y, size.z});
+	// A single point still needs a box to live in
+	if (!(extent > 0.f))
+		extent = 1.f;
+}
+
+glm::u16vec4 position_quantization::encode(glm::vec3 const & position) const
+{
+	auto normalized = glm::clamp((position - origin) / extent, glm::vec3(0.f), glm::vec3(1.f));
+	return glm::u16vec4(glm::u16vec3(glm::round(normalized * position_steps)), 0);
+}
+
+glm::vec3 position_quantization::decode(glm::u16vec4 const & quantized) const
+{
+	return origin + glm::vec3(quantized.x, quantized.y, quantized.z) / position_steps * extent;
+}
+
+glm::mat4 position_quantization::dequantize() const
+{
+	return glm::scale(glm::translate(glm::mat4(1.f), origin), glm::vec3(extent));
+}
+
+float position_quantization::max_error() const
+{
+	return 0.5f * std::sqrt(3.f) * extent / position_steps;
+}
+
+template <typename Component>
+glm::vec<2, Component> encode_octahedral(glm::vec3 const & normal)
+{
+	static_assert(std::is_same_v<Component, std::int8_t> || std::is_same_v<Component, std::int16_t>);
+	float const scale = float(std::numeric_limits<Component>::max());
+
+	// A zero, infinite or NaN normal has no direction to keep
+	float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (!(length > 0.f) || !std::isfinite(length))
+		return glm::vec<2, Component>(0);
+
+	auto n = normal / length;
+	glm::vec2 e(n.x, n.y);
+	if (n.z < 0.f)
+		e = glm::vec2((1.f - std::abs(n.y)) * sign_not_zero(n.x), (1.f - std::abs(n.x)) * sign_not_zero(n.y));
+
+	auto unit = glm::normalize(normal);
+	auto lower = glm::floor(glm::clamp(e, -1.f, 1.f) * scale);
+
+	glm::vec<2, Component> best(0);
+	float best_dot = -2.f;
+	for (int dy = 0; dy < 2; ++dy)
+	{
+		for (int dx = 0; dx < 2; ++dx)
+		{
+			auto candidate = glm::clamp(lower + glm::vec2(dx, dy), -scale, scale);
+			float d = glm::dot(decode_octahedral(candidate / scale), unit);
+			if (d > best_dot)
+			{
+				best_dot = d;
+				best = glm::vec<2, Component>(candidate);
+			}
+		}
+	}
+	return best;
+}
+
+template glm::vec<2, std::int8_t> encode_octahedral<std::int8_t>(glm::vec3 const & normal);
+template glm::vec<2, std::int16_t> encode_octahedral<std::int16_t>(glm::vec3 const & normal);
+
+glm::vec3 decode_octahedral(glm::vec2 const & encoded)
+{
+	glm::vec3 n(encoded.x, encoded.y, 1.f - std::abs(encoded.x) - std::abs(encoded.y));
+	float t = std::max(-n.z, 0.f);
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+	return glm::normalize(n);
+}
+
+std::uint32_t index_type(std::size_t vertex_count)
+{
+	return vertex_count <= std::numeric_limits<std::uint16_t>::max() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+std::size_t index_size(std::uint32_t index_type)
+{
+	switch (index_type)
+	{
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_UNSIGNED_SHORT:
+		return 2;
+	case GL_UNSIGNED_INT:
+		return 4;
+	}
+	throw std::runtime_error("Unknown index type " + std::to_string(index_type));
+}
+
+std::vector<std::byte> pack_indices(std::span<std::uint32_t const> indices, std::uint32_t index_type)
+{
+	auto const size = index_size(index_type);
+	std::uint32_t const max_index = size == 4 ? std::numeric_limits<std::uint32_t>::max() : (1u << (8 * size)) - 1;
+
+	std::vector<std::byte> result(indices.size() * size);
+	auto output = result.data();
+	for (auto index : indices)
+	{
+		if (index > max_index)
+			throw std::runtime_error("Index " + std::to_string(index) + " does not fit in " + std::to_string(size) + " bytes");
+
+		if (size == 1)
+			*output = static_cast<std::byte>(index);
+		else if (size == 2)
+		{
+			auto narrow = static_cast<std::uint16_t>(index);
+			std::memcpy(output, &narrow, size);
+		}
+		else
+			std::memcpy(output, &index, size);
+		output += size;
+	}
+	return result;
+}
+
+void vertex_format_statistics::add_position(glm::vec3 const & original, glm::vec3 const & decoded)
+{
+	max_position_error = std::max(max_position_error, glm::distance(original, decoded));
+}
+
+void vertex_format_statistics::add_normal(glm::vec3 const & original, glm::vec3 const & decoded)
+{
+	// acos loses small angles to float rounding, atan2 keeps them
+	auto a = glm::normalize(original);
+	auto b = glm::normalize(decoded);
+	float angle = std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+	max_normal_error_degrees = std::max(max_normal_error_degrees, glm::degrees(angle));
+}
+
+std::string vertex_format_report(vertex_format_statistics const & statistics)
+{
+	auto const & s = statistics;
+	auto bytes_before = s.vertices * s.vertex_size_before + s.indices * s.index_size_before;
+	auto bytes_after = s.vertices * s.vertex_size_after + s.indices * s.index_size_after;
+
+	std::ostringstream report;
+	report.precision(3);
+	report << "Vertex format: " << s.vertex_size_before << " -> " << s.vertex_size_after << " bytes per vertex, "
+		<< s.index_size_before << " -> " << s.index_size_after << " bytes per index, "
+		<< bytes_before / 1024 << " -> " << bytes_after / 1024 << " KiB; max position error "
+		<< s.max_position_error << ", max normal error " << s.max_normal_error_degrees << " degrees";
+	return report.str();
+}
+
+}
@@ -0,0 +1,88 @@
+#include <engine/vertex_format.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+// Octahedral normals: a sweep of directions has to survive the round trip
+// within the grid spacing, and normals without a direction have to encode
+// as +Z instead of whatever the candidate search left behind
+
+namespace
+{
+
+int failures = 0;
+
+void check(bool condition, std::string const & what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+template <typename Component>
+void check_round_trip(char const * name, float max_degrees)
+{
+	float worst = 0.f;
+	for (int i = 0; i <= 64; ++i)
+	{
+		for (int j = 0; j < 128; ++j)
+		{
+			float theta = float(M_PI) * i / 64.f;
+			float phi = 2.f * float(M_PI) * j / 128.f;
+			glm::vec3 normal(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+
+			// The length of the input must not matter
+			auto encoded = engine::encode_octahedral<Component>(normal * 3.f);
+			auto decoded = engine::decode_octahedral(encoded);
+			float degrees = glm::degrees(std::acos(std::min(glm::dot(decoded, normal), 1.f)));
+			worst = std::max(worst, degrees);
+		}
+	}
+	check(worst <= max_degrees, std::string(name) + " round trip error " + std::to_string(worst) + " degrees");
+}
+
+template <typename Component>
+void check_degenerate(char const * name)
+{
+	float const nan = std::numeric_limits<float>::quiet_NaN();
+	float const inf = std::numeric_limits<float>::infinity();
+	glm::vec3 const degenerate[] =
+	{
+		glm::vec3(0.f),
+		glm::vec3(-0.f),
+		glm::vec3(nan, 0.f, 1.f),
+		glm::vec3(nan),
+		glm::vec3(inf, 0.f, 0.f),
+	};
+
+	for (auto const & normal : degenerate)
+	{
+		auto encoded = engine::encode_octahedral<Component>(normal);
+		check(encoded == glm::vec<2, Component>(0), std::string(name) + " degenerate normal encoded as ("
+			+ std::to_string(encoded.x) + ", " + std::to_string(encoded.y) + ")");
+		check(engine::decode_octahedral(encoded) == glm::vec3(0.f, 0.f, 1.f), std::string(name) + " degenerate normal does not decode to +Z");
+	}
+}
+
+}
+
+int main()
+{
+	check_round_trip<std::int8_t>("int8", 1.f);
+	check_round_trip<std::int16_t>("int16", 0.05f);
+	check_degenerate<std::int8_t>("int8");
+	check_degenerate<std::int16_t>("int16");
+
+	if (failures)
+		return EXIT_FAILURE;
+	std::cout << "vertex_format: all checks passed" << std::endl;
+}
@@ -0,0 +1,246 @@
+#include <engine/obj.hpp>
+#include <engine/thread_pool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <charconv>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <algorithm>
+
+// Compares engine::load_obj with the istringstream-per-line loader the
+// practices used before, on bunny.obj and on a synthetic OBJ made of
+// many translated copies of it:
+//     obj-loading [COPIES [THREADS]]
+// The synthetic file is written to the temporary directory and removed
+// afterwards. Both loaders have to produce identical meshes. The
+// synthetic file is then parsed by the parallel engine::load_obj on 1 up
+// to THREADS threads (by default one per hardware thread), which has to
+// reproduce the single-threaded result. Finally
+// practice12/house.obj is run through engine::import_obj, the full
+// OBJ/MTL importer, to report what it welds and groups by material.
+
+// The previous loader of practice8 and practice9, kept as the baseline
+engine::obj_mesh load_obj_istream(std::filesystem::path const & path)
+{
+	std::ifstream input(path);
+
+	engine::obj_mesh result;
+
+	for (std::string line; std::getline(input, line);)
+	{
+		std::istringstream line_stream(line);
+
+		char type;
+		line_stream >> type;
+
+		if (type == '#')
+			continue;
+
+		if (type == 'v')
+		{
+			glm::vec3 v;
+			line_stream >> v.x >> v.y >> v.z;
+			result.positions.push_back(v);
+			continue;
+		}
+
+		if (type == 'f')
+		{
+			std::uint32_t i0, i1, i2;
+			line_stream >> i0 >> i1 >> i2;
+			result.indices.push_back(i0 - 1);
+			result.indices.push_back(i1 - 1);
+			result.indices.push_back(i2 - 1);
+			continue;
+		}
+
+		throw std::runtime_error("Unknown OBJ row type: " + std::string(1, type));
+	}
+
+	return result;
+}
+
+void write_synthetic_obj(engine::obj_mesh const & source, int copies, std::filesystem::path const & path)
+{
+	std::ofstream output(path, std::ios::binary);
+	output << std::fixed << std::setprecision(6);
+
+	int grid = 1;
+	while (grid * grid < copies)
+		++grid;
+
+	for (int copy = 0; copy < copies; ++copy)
+	{
+		glm::vec3 offset(0.2f * (copy % grid), 0.f, 0.2f * (copy / grid));
+		for (auto const & p : source.positions)
+			output << "v " << p.x + offset.x << ' ' << p.y + offset.y << ' ' << p.z + offset.z << '\n';
+	}
+
+	for (int copy = 0; copy < copies; ++copy)
+	{
+		std::size_t base = copy * source.positions.size() + 1;
+		for (std::size_t i = 0; i < source.indices.size(); i += 3)
+			output << "f " << source.indices[i] + base << ' ' << source.indices[i + 1] + base << ' ' << source.indices[i + 2] + base << '\n';
+	}
+
+	if (!output)
+		throw std::runtime_error("Failed to write " + path.string());
+}
+
+// Best of a few runs, the first one also warms up the file cache
+double time_ms(std::function<engine::obj_mesh()> const & load, engine::obj_mesh & result, int runs)
+{
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		result = load();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (run == 0 || ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+void compare(std::string const & name, std::filesystem::path const & path, int runs)
+{
+	engine::obj_mesh baseline, fast;
+	double baseline_ms = time_ms([&]{ return load_obj_istream(path); }, baseline, runs);
+	double fast_ms = time_ms([&]{ return engine::load_obj(path); }, fast, runs);
+
+	if (baseline.positions != fast.positions || baseline.indices != fast.indices)
+		throw std::runtime_error("Loaders disagree on " + path.string());
+
+	double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+	std::cout << std::left << std::setw(12) << name << std::right
+		<< std::setw(12) << fast.positions.size()
+		<< std::setw(12) << fast.indices.size() / 3
+		<< std::setw(10) << std::fixed << std::setprecision(1) << megabytes
+		<< std::setw(14) << std::setprecision(2) << baseline_ms
+		<< std::setw(14) << fast_ms
+		<< std::setw(10) << std::setprecision(1) << baseline_ms / fast_ms << "x"
+		<< std::setw(12) << megabytes / (fast_ms / 1000.0) << std::endl;
+}
+
+void scaling(std::filesystem::path const & path, unsigned max_threads, int runs)
+{
+	auto reference = engine::load_obj(path);
+	double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+	std::cout << std::left << std::setw(12) << "threads" << std::right
+		<< std::setw(14) << "ms" << std::setw(12) << "speedup" << std::setw(14) << "efficiency" << std::setw(12) << "MiB/s" << std::endl;
+
+	std::vector<unsigned> thread_counts;
+	for (unsigned threads = 1; threads < max_threads; threads *= 2)
+		thread_counts.push_back(threads);
+	thread_counts.push_back(max_threads);
+
+	double single_ms = 0.0;
+	for (unsigned threads : thread_counts)
+	{
+		engine::thread_pool pool(threads);
+
+		engine::obj_mesh mesh;
+		double ms = time_ms([&]{ return engine::load_obj(path, pool); }, mesh, runs);
+		if (mesh.positions != reference.positions || mesh.indices != reference.indices)
+			throw std::runtime_error("Parallel parse on " + std::to_string(threads) + " threads disagrees on " + path.string());
+
+		if (threads == 1)
+			single_ms = ms;
+
+		std::cout << std::left << std::setw(12) << threads << std::right
+			<< std::setw(14) << std::fixed << std::setprecision(2) << ms
+			<< std::setw(11) << std::setprecision(2) << single_ms / ms << "x"
+			<< std::setw(13) << std::setprecision(0) << 100.0 * single_ms / ms / threads << "%"
+			<< std::setw(12) << std::setprecision(1) << megabytes / (ms / 1000.0) << std::endl;
+	}
+}
+
+void import(std::filesystem::path const & path, int runs)
+{
+	engine::obj_model model;
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		model = engine::import_obj(path);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (run == 0 || ms < best)
+			best = ms;
+	}
+
+	std::size_t corners = 0;
+	for (auto const & submesh : model.submeshes)
+		corners += submesh.index_count;
+
+	std::cout << path.filename().string() << ": " << model.vertices.size() << " vertices welded from "
+		<< corners << " face corners, " << model.indices.size() / 3 << " triangles, "
+		<< model.materials.size() << " materials, " << model.submeshes.size() << " submeshes from " << model.face_groups << " face groups"
+		<< (model.has_normals ? ", normals" : "") << (model.has_texcoords ? ", texture coordinates" : "")
+		<< ", " << std::fixed << std::setprecision(2) << best << " ms" << std::endl;
+
+	for (auto const & submesh : model.submeshes)
+	{
+		auto const & material = model.materials[submesh.material];
+		std::cout << "    " << std::left << std::setw(24) << material.name << std::right
+			<< std::setw(8) << submesh.index_count / 3 << " triangles  Kd "
+			<< std::setprecision(3) << material.diffuse.r << ' ' << material.diffuse.g << ' ' << material.diffuse.b
+			<< "  d " << material.opacity << std::endl;
+	}
+}
+
+int main(int argc, char ** argv) try
+{
+	auto positive_argument = [&](int index, unsigned & value)
+	{
+		std::string_view arg = argv[index];
+		auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+		if (error != std::errc{} || end != arg.data() + arg.size() || value == 0)
+			throw std::runtime_error("Usage: obj-loading [COPIES [THREADS]]");
+	};
+
+	unsigned copies = 600;
+	if (argc > 1)
+		positive_argument(1, copies);
+
+	unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (argc > 2)
+		positive_argument(2, max_threads);
+
+	std::filesystem::path bunny = PRACTICE_SOURCE_DIRECTORY "/../practice9/bunny.obj";
+
+	auto directory = std::filesystem::temp_directory_path() / "graphics-course-practice";
+	std::filesystem::create_directories(directory);
+	auto synthetic = directory / ("bunny_x" + std::to_string(copies) + ".obj");
+	write_synthetic_obj(engine::load_obj(bunny), copies, synthetic);
+
+	std::cout << std::left << std::setw(12) << "file" << std::right
+		<< std::setw(12) << "vertices" << std::setw(12) << "triangles" << std::setw(10) << "MiB"
+		<< std::setw(14) << "istream ms" << std::setw(14) << "from_chars ms" << std::setw(11) << "speedup"
+		<< std::setw(12) << "MiB/s" << std::endl;
+
+	compare("bunny", bunny, 10);
+	compare("bunny x" + std::to_string(copies), synthetic, 3);
+
+	std::cout << std::endl;
+	scaling(synthetic, max_threads, 3);
+
+	std::filesystem::remove(synthetic);
+
+	std::cout << std::endl;
+	import(PRACTICE_SOURCE_DIRECTORY "/../practice12/house.obj", 10);
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
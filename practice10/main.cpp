@@ -1,49 +1,31 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-
-#include <SDL2/SDL.h>
-
-#endif
-
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/mapped_file.hpp>
+#include <engine/mesh_optimize.hpp>
+#include <engine/vertex_format.hpp>
+#include <engine/simplify.hpp>
+
+#include <string>
 #include <iostream>
-#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
 #include <vector>
-#include <map>
 #include <cmath>
-#include <fstream>
-#include <sstream>
-
-#define GLM_FORCE_SWIZZLE
-#define GLM_ENABLE_EXPERIMENTAL
+#include <span>
+#include <filesystem>
+#include <stdexcept>
 
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/scalar_constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-using namespace std::string_literals;
-
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
         R"(#version 330 core
 
@@ -61,9 +43,11 @@ layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in ivec2 in_bone_id;
 layout (location = 3) in vec2 in_bone_weight;
+layout (location = 4) in float in_ao;
 
 out vec3 normal;
 out vec3 position;
+out float ao;
 
 vec4 quat_mult(vec4 q1, vec4 q2)
 {
@@ -93,6 +77,7 @@ void main()
 	gl_Position = projection * view * model * vec4(bone_pos[0] * in_bone_weight[0] + bone_pos[1] * in_bone_weight[1], 1.0);
 	position = (model * vec4(in_position, 1.0)).xyz;
 	normal = normalize((model * vec4(bone_norm[0] * in_bone_weight[0] + bone_norm[1] * in_bone_weight[1], 0.0)).xyz);
+	ao = in_ao;
 }
 )";
 
@@ -108,6 +93,7 @@ uniform vec3 light_color;
 
 in vec3 normal;
 in vec3 position;
+in float ao;
 
 layout (location = 0) out vec4 out_color;
 
@@ -118,54 +104,28 @@ void main()
 
 	vec3 albedo = vec3(1.0, 1.0, 1.0);
 
-	vec3 light = ambient + light_color * (max(0.0, dot(normal, light_direction)) + pow(max(0.0, dot(camera_direction, reflected)), 64.0));
+	vec3 light = ambient * ao + light_color * (max(0.0, dot(normal, light_direction)) + pow(max(0.0, dot(camera_direction, reflected)), 64.0));
 	vec3 color = albedo * light;
 	out_color = vec4(color, 1.0);
 }
 )";
 
-GLuint create_shader(GLenum type, const char *source) {
-    GLuint result = glCreateShader(type);
-    glShaderSource(result, 1, &source, nullptr);
-    glCompileShader(result);
-    GLint status;
-    glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Shader compilation failed: " + info_log);
-    }
-    return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader) {
-    GLuint result = glCreateProgram();
-    glAttachShader(result, vertex_shader);
-    glAttachShader(result, fragment_shader);
-    glLinkProgram(result);
-
-    GLint status;
-    glGetProgramiv(result, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Program linkage failed: " + info_log);
-    }
-
-    return result;
-}
-
-struct vertex {
+// The vertex of human.bin
+struct skinned_vertex {
     glm::vec3 position;
     glm::vec3 normal;
     std::uint8_t bone_ids[2];
     std::uint8_t bone_weights[2];
 };
 
+// The vertex of human_ao.bin, written by the ao-baker, which is drawn
+// instead of human.bin if present; without it there is no occlusion
+struct vertex {
+    skinned_vertex skinned;
+    std::uint8_t ao = 255;
+    std::uint8_t padding[3] = {};
+};
+
 struct bone {
     std::int32_t parent_id;
     glm::vec3 offset;
@@ -187,106 +147,164 @@ float easing_func(float t){
     return 3 * t * t - 2 * t * t * t;
 }
 
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-    SDL_Window *window = SDL_CreateWindow("Graphics course practice 10",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
-
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
-
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+int main(int argc, char **argv) try {
+    engine::application app(argc, argv, {
+            .title = "Graphics course practice 10",
+            .report_interval = 5.f,
+    });
 
     glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-    auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-    auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-    auto program = create_program(vertex_shader, fragment_shader);
+    engine::program program({
+            {GL_VERTEX_SHADER, vertex_shader_source},
+            {GL_FRAGMENT_SHADER, fragment_shader_source},
+    }, app.programs());
 
-    GLuint model_location = glGetUniformLocation(program, "model");
-    GLuint view_location = glGetUniformLocation(program, "view");
-    GLuint projection_location = glGetUniformLocation(program, "projection");
+    auto model_uniform = program.find("model");
+    auto view_uniform = program.find("view");
+    auto projection_uniform = program.find("projection");
 
-    auto bone_rotation_location = [&](size_t ind) {
-        auto var = "bone_rotation["s + std::to_string(ind) + "]";
-        return glGetUniformLocation(program, var.c_str());
-    };
-    auto bone_translation_location = [&](size_t ind) {
-        auto var = "bone_translation["s + std::to_string(ind) + "]";
-        return glGetUniformLocation(program, var.c_str());
-    };
-    auto bone_scale_location = [&](size_t ind) {
-        auto var = "bone_scale["s + std::to_string(ind) + "]";
-        return glGetUniformLocation(program, var.c_str());
-    };
+    auto bone_rotation_uniform = program.find("bone_rotation");
+    auto bone_translation_uniform = program.find("bone_translation");
+    auto bone_scale_uniform = program.find("bone_scale");
 
-    GLuint camera_position_location = glGetUniformLocation(program, "camera_position");
+    auto camera_position_uniform = program.find("camera_position");
 
-    GLuint ambient_location = glGetUniformLocation(program, "ambient");
-    GLuint light_direction_location = glGetUniformLocation(program, "light_direction");
-    GLuint light_color_location = glGetUniformLocation(program, "light_color");
+    auto ambient_uniform = program.find("ambient");
+    auto light_direction_uniform = program.find("light_direction");
+    auto light_color_uniform = program.find("light_color");
 
-    std::vector<vertex> vertices;
-    std::vector<std::uint32_t> indices;
-    std::vector<bone> bones;
-    std::vector<std::vector<bone_pose>> poses(6);
+    // The bone and pose arrays point into their mappings, which therefore
+    // live as long as the frame loop
+    engine::mapped_reader bones_file(PRACTICE_SOURCE_DIRECTORY "/bones.bin");
+    auto bones = bones_file.read_array<bone>(bones_file.read<std::uint32_t>());
+    bones_file.expect_end();
 
-    {
-        std::ifstream file(PRACTICE_SOURCE_DIRECTORY "/human.bin", std::ios::binary);
+    for (std::size_t i = 0; i < bones.size(); ++i) {
+        if (bones[i].parent_id < -1 || bones[i].parent_id >= static_cast<std::int32_t>(i))
+            throw std::runtime_error("bones.bin: bone " + std::to_string(i) + " has invalid parent " + std::to_string(bones[i].parent_id));
+    }
 
-        std::uint32_t vertex_count;
-        std::uint32_t index_count;
-        file.read((char *) (&vertex_count), sizeof(vertex_count));
-        file.read((char *) (&index_count), sizeof(index_count));
-        vertices.resize(vertex_count);
-        indices.resize(index_count);
-        file.read((char *) vertices.data(), vertices.size() * sizeof(vertices[0]));
-        file.read((char *) indices.data(), indices.size() * sizeof(indices[0]));
+    std::vector<engine::mapped_reader> pose_files;
+    std::vector<std::span<bone_pose const>> poses;
+    for (std::size_t i = 0; i < 6; ++i) {
+        auto &file = pose_files.emplace_back(PRACTICE_SOURCE_DIRECTORY "/pose_" + std::to_string(i) + ".bin");
+        poses.push_back(file.read_array<bone_pose>(bones.size()));
+        file.expect_end();
     }
 
-    {
-        std::ifstream file(PRACTICE_SOURCE_DIRECTORY "/bones.bin", std::ios::binary);
+    // Read, simplified into levels of detail and reordered for the vertex
+    // cache on an asset worker; the buffers are filled in slices (or on
+    // the upload context) and only drawn once they are complete. The
+    // asset steps share the mesh instead of referring to locals of main(),
+    // so a job still in flight when the asset manager is destroyed keeps
+    // its buffers alive until then.
+    struct human_mesh {
+        engine::buffer vbo;
+        engine::buffer ebo;
+        std::vector<vertex> vertices;
+        // Of all levels of detail, one after another
+        std::vector<std::uint32_t> indices;
+        std::vector<engine::mesh_lod> lods;
+        std::string lod_report;
+        // The indices as uploaded, 16-bit when the vertex count allows
+        GLenum index_type;
+        std::vector<std::byte> index_bytes;
+        std::string vertex_cache_report;
+    };
 
-        std::uint32_t bone_count;
-        file.read((char *) (&bone_count), sizeof(bone_count));
-        bones.resize(bone_count);
-        file.read((char *) (bones.data()), bones.size() * sizeof(bones[0]));
-    }
+    // Filled on the asset threads, read on the render thread only once the
+    // asset is ready
+    auto human = std::make_shared<human_mesh>();
+
+    auto human_asset = app.assets().load("human", [mesh = human, bone_count = bones.size()] {
+        std::filesystem::path const baked = PRACTICE_SOURCE_DIRECTORY "/human_ao.bin";
+        bool const has_ao = std::filesystem::exists(baked);
+        auto const path = has_ao ? baked : std::filesystem::path(PRACTICE_SOURCE_DIRECTORY "/human.bin");
+
+        engine::mapped_reader file(path);
+        auto vertex_count = file.read<std::uint32_t>();
+        auto index_count = file.read<std::uint32_t>();
+        std::vector<vertex> vertices;
+        if (has_ao) {
+            auto baked_vertices = file.read_array<vertex>(vertex_count);
+            vertices.assign(baked_vertices.begin(), baked_vertices.end());
+        } else {
+            for (auto const &v : file.read_array<skinned_vertex>(vertex_count))
+                vertices.push_back({v});
+        }
+        auto indices = file.read_array<std::uint32_t>(index_count);
+        file.expect_end();
+
+        // Simplified with the normals and the weight of every bone as
+        // attributes: a vertex is only collapsed onto one that is skinned
+        // about the same way, so the levels deform like the full mesh
+        std::vector<glm::vec3> positions(vertex_count);
+        std::size_t const attribute_count = 3 + bone_count;
+        std::vector<float> attributes(vertex_count * attribute_count, 0.f);
+        for (std::size_t i = 0; i < vertex_count; ++i) {
+            auto const &v = vertices[i].skinned;
+            positions[i] = v.position;
+            float *vertex_attributes = attributes.data() + i * attribute_count;
+            vertex_attributes[0] = v.normal.x;
+            vertex_attributes[1] = v.normal.y;
+            vertex_attributes[2] = v.normal.z;
+            for (int k = 0; k < 2; ++k) {
+                if (v.bone_ids[k] >= bone_count)
+                    throw std::runtime_error(path.filename().string() + ": vertex " + std::to_string(i) + " has invalid bone " + std::to_string(v.bone_ids[k]));
+                vertex_attributes[3 + v.bone_ids[k]] += v.bone_weights[k] / 255.f;
+            }
+        }
 
-    for (std::size_t i = 0; i < 6; ++i) {
-        std::ifstream file(PRACTICE_SOURCE_DIRECTORY "/pose_" + std::to_string(i) + ".bin", std::ios::binary);
+        std::vector<float> attribute_weights(attribute_count, 0.1f);
+        std::fill_n(attribute_weights.begin(), 3, 0.05f);
+
+        float const lod_ratios[] = {0.5f, 0.25f, 0.1f, 0.03f};
+        auto chain = engine::build_lod_chain(indices, positions, lod_ratios, attributes, attribute_weights);
+
+        // Every vertex cache miss is a run of the skinning shader
+        mesh->vertices = std::move(vertices);
+        mesh->indices = std::move(chain.indices);
+        mesh->lods = std::move(chain.lods);
+        mesh->lod_report = engine::lod_report(mesh->lods);
+        engine::optimize_vertex_fetch(mesh->vertices, mesh->indices);
+        mesh->vertex_cache_report = engine::vertex_cache_report(indices, std::span(mesh->indices).first(index_count), vertex_count);
+        mesh->index_type = engine::index_type(mesh->vertices.size());
+        mesh->index_bytes = engine::pack_indices(mesh->indices, mesh->index_type);
+
+        static constexpr std::size_t slice_bytes = 256 * 1024;
+
+        // GL_COPY_WRITE_BUFFER is no vertex array state, unlike the index
+        // buffer binding, so whatever vertex array is bound stays intact
+        return [vbo_id = GLuint(mesh->vbo), ebo_id = GLuint(mesh->ebo), mesh, allocated = false, vertex_offset = std::size_t(0),
+                index_offset = std::size_t(0)]() mutable {
+            auto vertex_bytes = std::as_bytes(std::span(mesh->vertices));
+            auto index_bytes = std::span<std::byte const>(mesh->index_bytes);
+
+            if (!allocated) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_id);
+                glBufferData(GL_COPY_WRITE_BUFFER, vertex_bytes.size(), nullptr, GL_STATIC_DRAW);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_id);
+                glBufferData(GL_COPY_WRITE_BUFFER, index_bytes.size(), nullptr, GL_STATIC_DRAW);
+                allocated = true;
+                return false;
+            }
 
-        poses[i].resize(bones.size());
-        file.read((char *) (poses[i].data()), poses[i].size() * sizeof(poses[i][0]));
-    }
+            if (vertex_offset < vertex_bytes.size()) {
+                auto size = std::min(slice_bytes, vertex_bytes.size() - vertex_offset);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_id);
+                glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, size, vertex_bytes.data() + vertex_offset);
+                vertex_offset += size;
+                return false;
+            }
 
-    std::cout << "Loaded " << vertices.size() << " vertices, " << indices.size() << " indices, " << bones.size()
-              << " bones" << std::endl;
+            auto size = std::min(slice_bytes, index_bytes.size() - index_offset);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_id);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, index_offset, size, index_bytes.data() + index_offset);
+            index_offset += size;
+            return index_offset == index_bytes.size();
+        };
+    });
 
     /*
     for (auto &pose: poses) {
@@ -300,82 +318,64 @@ int main() try {
     }
      */
 
-    GLuint vao, vbo, ebo;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
+    // Vertex arrays are not shared between contexts, this one is set up
+    // on the render thread once the buffers it points to are complete
+    engine::vertex_array vao;
+    bool vao_ready = false;
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (0));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (12));
-    glEnableVertexAttribArray(2);
-    glVertexAttribIPointer(2, 2, GL_UNSIGNED_BYTE, sizeof(vertex), (void *) (24));
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (void *) (26));
-
-    static_assert(sizeof(vertex) == 28);
+    auto setup_vao = [&] {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, human->vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, human->ebo);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (0));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (12));
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(2, 2, GL_UNSIGNED_BYTE, sizeof(vertex), (void *) (24));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (void *) (26));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (void *) (28));
+
+        std::cout << "Loaded " << human->vertices.size() << " vertices, " << human->lods[0].index_count << " indices, "
+                  << bones.size() << " bones" << std::endl;
+        std::cout << human->vertex_cache_report << std::endl;
+        std::cout << human->lod_report << std::endl;
+    };
 
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
+    static_assert(sizeof(skinned_vertex) == 28);
+    static_assert(sizeof(vertex) == 32);
 
     float time = 0.f;
 
-    std::map<SDL_Keycode, bool> button_down;
-
     float view_angle = 0.f;
     float camera_distance = 3.f;
     float camera_height = 1.2f;
 
     float model_rotation = 0.f;
 
-    bool running = true;
-    while (running) {
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            break;
-                    }
-                    break;
-                case SDL_KEYDOWN:
-                    button_down[event.key.keysym.sym] = true;
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    break;
-            }
+    auto const &input = app.input();
 
-        if (!running)
-            break;
+    float previous_time = time;
 
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
-        time += dt * 10;
+    app.run(1.f / 120.f, [&](float step) {
+        previous_time = time;
+        time += step * 10;
 
-        if (button_down[SDLK_UP])
-            camera_distance -= 3.f * dt;
-        if (button_down[SDLK_DOWN])
-            camera_distance += 3.f * dt;
+        if (input.down(SDL_SCANCODE_UP))
+            camera_distance -= 3.f * step;
+        if (input.down(SDL_SCANCODE_DOWN))
+            camera_distance += 3.f * step;
 
-        if (button_down[SDLK_LEFT])
-            model_rotation -= 3.f * dt;
-        if (button_down[SDLK_RIGHT])
-            model_rotation += 3.f * dt;
+        if (input.down(SDL_SCANCODE_LEFT))
+            model_rotation -= 3.f * step;
+        if (input.down(SDL_SCANCODE_RIGHT))
+            model_rotation += 3.f * step;
+    }, [&](float alpha) {
+        // Poses are sampled between the last two simulation steps
+        float frame_time = glm::mix(previous_time, time, alpha);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_DEPTH_TEST);
@@ -392,16 +392,18 @@ int main() try {
         view = glm::translate(view, {0.f, -camera_height, -camera_distance});
         view = glm::rotate(view, view_angle, {1.f, 0.f, 0.f});
 
-        glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+        glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * app.width()) / app.height(), near, far);
 
         glm::vec3 camera_position = (glm::inverse(view) * glm::vec4(0.f, 0.f, 0.f, 1.f)).xyz();
 
         glUseProgram(program);
 
         {
-            float interp_param = easing_func(time - floor(time));
+            engine::profile_scope bone_upload(app.profiler(), "bone upload");
 
-            int cur_pose_ind = (int)floor(time) % 6;
+            float interp_param = easing_func(frame_time - floor(frame_time));
+
+            int cur_pose_ind = (int)floor(frame_time) % 6;
             int next_pose_ind = (cur_pose_ind + 1) % 6;
 
             auto &cur_pose = poses[cur_pose_ind];
@@ -429,9 +431,9 @@ int main() try {
 
                 bone_poses[i] = transformed;
 
-                glUniform4fv(bone_rotation_location(i), 1, (float *) &transformed.rotation);
-                glUniform3fv(bone_translation_location(i), 1, (float *) &transformed.translation);
-                glUniform1f(bone_scale_location(i), transformed.scale);
+                program.set(bone_rotation_uniform, i, glm::make_vec4(&transformed.rotation[0]));
+                program.set(bone_translation_uniform, i, transformed.translation);
+                program.set(bone_scale_uniform, i, transformed.scale);
             }
 
             /*
@@ -440,32 +442,39 @@ int main() try {
 
                 auto trans = glm::mix(cur_pose[i].translation, next_pose[i].translation, interp_param);
                 auto scale = glm::mix(cur_pose[i].scale, next_pose[i].scale, interp_param);
-                glUniform4fv(bone_rotation_location(i), 1, (float *) &rot);
-                glUniform3fv(bone_translation_location(i), 1, (float *) &trans);
-                glUniform1f(bone_scale_location(i), scale);
+                program.set(bone_rotation_uniform, i, glm::make_vec4(&rot[0]));
+                program.set(bone_translation_uniform, i, trans);
+                program.set(bone_scale_uniform, i, scale);
             }
              */
 
         }
 
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
-        glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
-        glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
+        program.set(model_uniform, model);
+        program.set(view_uniform, view);
+        program.set(projection_uniform, projection);
 
-        glUniform3fv(camera_position_location, 1, (float *) (&camera_position));
+        program.set(camera_position_uniform, camera_position);
 
-        glUniform3f(ambient_location, 0.2f, 0.2f, 0.4f);
-        glUniform3f(light_direction_location, 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f));
-        glUniform3f(light_color_location, 0.8f, 0.3f, 0.f);
+        program.set(ambient_uniform, glm::vec3(0.2f, 0.2f, 0.4f));
+        program.set(light_direction_uniform, glm::vec3(1.f / std::sqrt(3.f)));
+        program.set(light_color_uniform, glm::vec3(0.8f, 0.3f, 0.f));
 
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+        if (!human_asset.ready())
+            return;
 
-        SDL_GL_SwapWindow(window);
-    }
+        if (!vao_ready) {
+            setup_vao();
+            vao_ready = true;
+        }
 
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(window);
+        glBindVertexArray(vao);
+        // The coarsest level that stays within a pixel of the full mesh
+        float pixels_per_unit = engine::perspective_pixels_per_unit(glm::pi<float>() / 2.f, app.height(), camera_distance);
+        auto const &lod = human->lods[engine::select_lod(human->lods, pixels_per_unit)];
+        auto index_offset = lod.first_index * engine::index_size(human->index_type);
+        glDrawElements(GL_TRIANGLES, lod.index_count, human->index_type, reinterpret_cast<void const *>(index_offset));
+    });
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;
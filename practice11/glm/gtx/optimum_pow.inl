@@ -1,22 +0,0 @@
-/// @ref gtx_optimum_pow
-
-namespace glm
-{
-	template<typename genType>
-	GLM_FUNC_QUALIFIER genType pow2(genType const& x)
-	{
-		return x * x;
-	}
-
-	template<typename genType>
-	GLM_FUNC_QUALIFIER genType pow3(genType const& x)
-	{
-		return x * x * x;
-	}
-
-	template<typename genType>
-	GLM_FUNC_QUALIFIER genType pow4(genType const& x)
-	{
-		return (x * x) * (x * x);
-	}
-}//namespace glm
@@ -1,25 +1,14 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
 #include <fstream>
 #include <sstream>
 #include <random>
 
-#define GLM_FORCE_SWIZZLE
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -28,21 +17,6 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
 R"(#version 330 core
 
@@ -85,92 +59,22 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-template <typename ... Shaders>
-GLuint create_program(Shaders ... shaders)
-{
-	GLuint result = glCreateProgram();
-	(glAttachShader(result, shaders), ...);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
 struct particle
 {
 	glm::vec3 position;
 };
 
-int main() try
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 10",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	engine::application app(argc, argv, {.title = "Graphics course practice 11"});
 
 	glClearColor(0.f, 0.f, 0.f, 0.f);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto geometry_shader = create_shader(GL_GEOMETRY_SHADER, geometry_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, geometry_shader, fragment_shader);
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_GEOMETRY_SHADER, geometry_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
 	GLuint model_location = glGetUniformLocation(program, "model");
 	GLuint view_location = glGetUniformLocation(program, "view");
@@ -186,11 +90,10 @@ int main() try
 		p.position.z = std::uniform_real_distribution<float>{-1.f, 1.f}(rng);
 	}
 
-	GLuint vao, vbo;
-	glGenVertexArrays(1, &vao);
+	engine::vertex_array vao;
 	glBindVertexArray(vao);
 
-	glGenBuffers(1, &vbo);
+	engine::buffer vbo;
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, particles.size() * sizeof(particle), particles.data(), GL_STATIC_DRAW);
 
@@ -199,12 +102,8 @@ int main() try
 
 	glPointSize(5.f);
 
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
-
 	float time = 0.f;
 
-	std::map<SDL_Keycode, bool> button_down;
-
 	float view_angle = 0.f;
 	float camera_distance = 3.f;
 	float camera_height = 1.2f;
@@ -213,51 +112,35 @@ int main() try
 
 	bool paused = false;
 
-	bool running = true;
-	while (running)
+	app.on_event([&](SDL_Event const & event)
 	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
+		switch (event.type)
 		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
 		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
 			if (event.key.keysym.sym == SDLK_SPACE)
 				paused = !paused;
 			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
 		}
+	});
 
-		if (!running)
-			break;
-
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
-		time += dt;
-
-		if (button_down[SDLK_UP])
-			camera_distance -= 3.f * dt;
-		if (button_down[SDLK_DOWN])
-			camera_distance += 3.f * dt;
-
-		if (button_down[SDLK_LEFT])
-			camera_rotation -= 3.f * dt;
-		if (button_down[SDLK_RIGHT])
-			camera_rotation += 3.f * dt;
+	auto const & input = app.input();
 
+	app.run(1.f / 120.f, [&](float step)
+	{
+		time += step;
+
+		if (input.down(SDL_SCANCODE_UP))
+			camera_distance -= 3.f * step;
+		if (input.down(SDL_SCANCODE_DOWN))
+			camera_distance += 3.f * step;
+
+		if (input.down(SDL_SCANCODE_LEFT))
+			camera_rotation -= 3.f * step;
+		if (input.down(SDL_SCANCODE_RIGHT))
+			camera_rotation += 3.f * step;
+	},
+	[&](float)
+	{
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_DEPTH_TEST);
 		glEnable(GL_CULL_FACE);
@@ -272,7 +155,7 @@ int main() try
 		view = glm::rotate(view, view_angle, {1.f, 0.f, 0.f});
 		view = glm::rotate(view, camera_rotation, {0.f, 1.f, 0.f});
 
-		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * app.width()) / app.height(), near, far);
 
 		glm::vec3 camera_position = (glm::inverse(view) * glm::vec4(0.f, 0.f, 0.f, 1.f)).xyz();
 
@@ -284,12 +167,7 @@ int main() try
 
 		glBindVertexArray(vao);
 		glDrawArrays(GL_POINTS, 0, particles.size());
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	});
 }
 catch (std::exception const & e)
 {
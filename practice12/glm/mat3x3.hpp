@@ -1,8 +0,0 @@
-/// @ref core
-/// @file glm/mat3x3.hpp
-
-#pragma once
-#include "./ext/matrix_double3x3.hpp"
-#include "./ext/matrix_double3x3_precision.hpp"
-#include "./ext/matrix_float3x3.hpp"
-#include "./ext/matrix_float3x3_precision.hpp"
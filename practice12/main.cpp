@@ -1,44 +1,23 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/materials.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
 #include <fstream>
-#include <chrono>
 #include <vector>
-#include <map>
+#include <algorithm>
+#include <cstddef>
 
-#define GLM_FORCE_SWIZZLE
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/matrix.hpp>
+#include <glm/geometric.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
 R"(#version 330 core
 
@@ -105,42 +84,75 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
+// house.obj with the material of every vertex looked up in the packed
+// table, so that all its objects are drawn with one program and a single
+// uniform buffer binding
+const char house_vertex_shader_source[] =
+R"(#version 330 core
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec3 in_normal;
+layout (location = 3) in uint in_material;
+
+out vec3 position;
+out vec3 normal;
+flat out uint material_index;
+
+void main()
 {
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
+	position = (model * vec4(in_position, 1.0)).xyz;
+	normal = mat3(model) * in_normal;
+	material_index = in_material;
+	gl_Position = projection * view * vec4(position, 1.0);
 }
+)";
 
-template<typename ... Shaders>
-GLuint create_program(Shaders ... shaders) {
-	GLuint result = glCreateProgram();
-	(glAttachShader(result, shaders), ...);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE) {
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
+const char house_fragment_shader_source[] =
+R"(#version 330 core
+
+struct material
+{
+	vec4 diffuse;
+	vec4 specular;
+	vec4 emission;
+	ivec4 maps;
+};
+
+layout (std140) uniform material_block
+{
+	material materials[256];
+};
+
+uniform vec3 camera_position;
+uniform vec3 light_dir;
+
+in vec3 position;
+in vec3 normal;
+flat in uint material_index;
+
+layout (location = 0) out vec4 out_color;
 
-	return result;
+void main()
+{
+	material m = materials[material_index];
+
+	// house.obj has no normals, the faces are shaded flat
+	vec3 n = (dot(normal, normal) > 0.0) ? normalize(normal) : normalize(cross(dFdx(position), dFdy(position)));
+	vec3 to_camera = normalize(camera_position - position);
+	if (dot(n, to_camera) < 0.0)
+		n = -n;
+
+	float diffuse = max(0.0, dot(n, light_dir));
+	float specular = (m.specular.w > 0.0) ? pow(max(0.0, dot(n, normalize(light_dir + to_camera))), m.specular.w) : 0.0;
+
+	vec3 color = m.diffuse.rgb * (0.2 + 0.8 * diffuse) + m.specular.rgb * specular * float(diffuse > 0.0) + m.emission.rgb;
+	out_color = vec4(color, m.diffuse.a);
 }
+)";
 
 struct vertex
 {
@@ -181,71 +193,98 @@ static std::uint32_t cube_indices[]
 	5, 3, 7,
 };
 
-int main() try
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 12",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	engine::application app(argc, argv, {
+		.title = "Graphics course practice 12",
+		.multisamples = 4,
+	});
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
 	GLuint view_location = glGetUniformLocation(program, "view");
 	GLuint projection_location = glGetUniformLocation(program, "projection");
 	GLuint camera_position_location = glGetUniformLocation(program, "camera_position");
 	GLuint light_dir_location = glGetUniformLocation(program, "light_dir");
 
-	GLuint vao, vbo, ebo;
-	glGenVertexArrays(1, &vao);
+	engine::vertex_array vao;
 	glBindVertexArray(vao);
 
-	glGenBuffers(1, &vbo);
+	engine::buffer vbo;
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
-	glGenBuffers(1, &ebo);
+	engine::buffer ebo;
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
+	engine::program house_program({
+		{GL_VERTEX_SHADER, house_vertex_shader_source},
+		{GL_FRAGMENT_SHADER, house_fragment_shader_source},
+	}, app.programs());
+
+	GLuint house_model_location = glGetUniformLocation(house_program, "model");
+	GLuint house_view_location = glGetUniformLocation(house_program, "view");
+	GLuint house_projection_location = glGetUniformLocation(house_program, "projection");
+	GLuint house_camera_position_location = glGetUniformLocation(house_program, "camera_position");
+	GLuint house_light_dir_location = glGetUniformLocation(house_program, "light_dir");
+
+	GLuint const material_binding = 0;
+	glUniformBlockBinding(house_program, glGetUniformBlockIndex(house_program, "material_block"), material_binding);
+
+	auto house = engine::import_obj(PRACTICE_SOURCE_DIRECTORY "/house.obj");
+	auto house_materials = engine::pack_materials(house.materials);
+	auto house_batches = engine::batch_by_material(house);
+	std::cout << "house.obj: " << engine::material_report(house, house_batches) << std::endl;
+
+	engine::buffer material_buffer;
+	glBindBuffer(GL_UNIFORM_BUFFER, material_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, house_materials.buffer_size(), nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, house_materials.materials.size() * sizeof(engine::packed_material), house_materials.materials.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	engine::vertex_array house_vao;
+	glBindVertexArray(house_vao);
+
+	engine::buffer house_vbo;
+	glBindBuffer(GL_ARRAY_BUFFER, house_vbo);
+	glBufferData(GL_ARRAY_BUFFER, house_batches.vertices.size() * sizeof(engine::material_vertex), house_batches.vertices.data(), GL_STATIC_DRAW);
+
+	engine::buffer house_ebo;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, house_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, house_batches.indices.size() * sizeof(std::uint32_t), house_batches.indices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(engine::material_vertex), (void *) offsetof(engine::material_vertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(engine::material_vertex), (void *) offsetof(engine::material_vertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(engine::material_vertex), (void *) offsetof(engine::material_vertex, texcoord));
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(engine::material_vertex), (void *) offsetof(engine::material_vertex, material));
+
+	// Centers of the translucent draws, to order them back to front
+	std::vector<glm::vec3> house_draw_centers;
+	for (auto const & draw : house_batches.draws)
+	{
+		glm::vec3 sum(0.f);
+		for (std::uint32_t i = 0; i < draw.index_count; ++i)
+			sum += house_batches.vertices[house_batches.indices[draw.first_index + i]].position;
+		house_draw_centers.push_back(sum / float(std::max<std::uint32_t>(draw.index_count, 1)));
+	}
+
+	// Beside the box, standing on its bottom
+	glm::mat4 house_model = glm::translate(glm::mat4(1.f), {2.5f, -1.f, -1.f});
+
+	std::vector<std::size_t> blended_draws;
 
 	float time = 0.f;
 
@@ -253,42 +292,14 @@ int main() try
 
 	float camera_rotation = 0.f;
 
-	std::map<SDL_Keycode, bool> button_down;
-
-	bool running = true;
 	bool paused = false;
-	while (running)
-	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			if (event.key.keysym.sym == SDLK_SPACE)
-				paused = !paused;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
-		}
 
-		if (!running)
-			break;
+	auto const & input = app.input();
 
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
+	app.run([&](float dt)
+	{
+		if (input.pressed(SDL_SCANCODE_SPACE))
+			paused = !paused;
 
 		if (!paused)
 			time += dt;
@@ -296,26 +307,26 @@ int main() try
 		float camera_move_forward = 0.f;
 		float camera_move_sideways = 0.f;
 
-		if (button_down[SDLK_w])
+		if (input.down(SDL_SCANCODE_W))
 			camera_move_forward -= 3.f * dt;
-		if (button_down[SDLK_s])
+		if (input.down(SDL_SCANCODE_S))
 			camera_move_forward += 3.f * dt;
-		if (button_down[SDLK_a])
+		if (input.down(SDL_SCANCODE_A))
 			camera_move_sideways -= 3.f * dt;
-		if (button_down[SDLK_d])
+		if (input.down(SDL_SCANCODE_D))
 			camera_move_sideways += 3.f * dt;
 
 		camera_position += camera_move_forward * glm::vec3(-std::sin(camera_rotation), 0.f, std::cos(camera_rotation));
 		camera_position += camera_move_sideways * glm::vec3(std::cos(camera_rotation), 0.f, std::sin(camera_rotation));
 
-		if (button_down[SDLK_LEFT])
+		if (input.down(SDL_SCANCODE_LEFT))
 			camera_rotation -= 3.f * dt;
-		if (button_down[SDLK_RIGHT])
+		if (input.down(SDL_SCANCODE_RIGHT))
 			camera_rotation += 3.f * dt;
 
-		if (button_down[SDLK_DOWN])
+		if (input.down(SDL_SCANCODE_DOWN))
 			camera_position.y -= 3.f * dt;
-		if (button_down[SDLK_UP])
+		if (input.down(SDL_SCANCODE_UP))
 			camera_position.y += 3.f * dt;
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -333,10 +344,49 @@ int main() try
 		view = glm::rotate(view, camera_rotation, {0.f, 1.f, 0.f});
 		view = glm::translate(view, -camera_position);
 
-		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * app.width()) / app.height(), near, far);
 
 		glm::vec3 light_dir = glm::normalize(glm::vec3(std::cos(time), 1.f, std::sin(time)));
 
+		glUseProgram(house_program);
+		glUniformMatrix4fv(house_model_location, 1, GL_FALSE, reinterpret_cast<float *>(&house_model));
+		glUniformMatrix4fv(house_view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
+		glUniformMatrix4fv(house_projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
+		glUniform3fv(house_camera_position_location, 1, reinterpret_cast<float *>(&camera_position));
+		glUniform3fv(house_light_dir_location, 1, reinterpret_cast<float *>(&light_dir));
+		glBindBufferBase(GL_UNIFORM_BUFFER, material_binding, material_buffer);
+
+		glBindVertexArray(house_vao);
+		glDisable(GL_CULL_FACE);
+
+		// All opaque materials in one draw, then the translucent ones back
+		// to front without writing depth
+		blended_draws.clear();
+		for (std::size_t i = 0; i < house_batches.draws.size(); ++i)
+		{
+			auto const & draw = house_batches.draws[i];
+			if (draw.blended)
+				blended_draws.push_back(i);
+			else
+				glDrawElements(GL_TRIANGLES, draw.index_count, GL_UNSIGNED_INT, (void *) (draw.first_index * sizeof(std::uint32_t)));
+		}
+
+		glm::vec3 house_camera = glm::inverse(house_model) * glm::vec4(camera_position, 1.f);
+		std::sort(blended_draws.begin(), blended_draws.end(), [&](std::size_t a, std::size_t b)
+		{
+			return glm::distance(house_draw_centers[a], house_camera) > glm::distance(house_draw_centers[b], house_camera);
+		});
+
+		glDepthMask(GL_FALSE);
+		for (auto i : blended_draws)
+		{
+			auto const & draw = house_batches.draws[i];
+			glDrawElements(GL_TRIANGLES, draw.index_count, GL_UNSIGNED_INT, (void *) (draw.first_index * sizeof(std::uint32_t)));
+		}
+		glDepthMask(GL_TRUE);
+
+		glEnable(GL_CULL_FACE);
+
 		glUseProgram(program);
 		glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
 		glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
@@ -345,12 +395,7 @@ int main() try
 
 		glBindVertexArray(vao);
 		glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	});
 }
 catch (std::exception const & e)
 {
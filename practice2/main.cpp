@@ -1,31 +1,8 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
-
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
 
 const char vertex_shader_source[] =
 R"(#version 330 core
@@ -59,126 +36,27 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
-int main() try
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 2",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	engine::application app(argc, argv, {.title = "Graphics course practice 2"});
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-	GLuint vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-
-	GLuint program = create_program(vertex_shader, fragment_shader);
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
-	GLuint vao;
-	glGenVertexArrays(1, &vao);
+	engine::vertex_array vao;
 
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
-
-	bool running = true;
-	while (running)
+	app.run([&](float dt)
 	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		}
-
-		if (!running)
-			break;
-
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
-
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		glUseProgram(program);
 		glBindVertexArray(vao);
 		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	});
 }
 catch (std::exception const & e)
 {
@@ -1,3 +0,0 @@
-#include "../geometric.hpp"
-#include "../trigonometric.hpp"
-#include "../matrix.hpp"
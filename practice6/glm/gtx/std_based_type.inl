@@ -1,6 +0,0 @@
-/// @ref gtx_std_based_type
-
-namespace glm
-{
-
-}
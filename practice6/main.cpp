@@ -1,50 +1,33 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/mapped_file.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
-#include <vector>
-#include <map>
 #include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
-#define GLM_FORCE_SWIZZLE
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/ext/vector_uint3_sized.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/scalar_constants.hpp>
 
-#include "textures.hpp"
-
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
 R"(#version 330 core
 
+layout (std140) uniform frame_data
+{
+	mat4 view;
+	mat4 projection;
+	vec4 light_position[3];
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_normal;
@@ -78,7 +61,13 @@ uniform sampler2D roughness_map;
 
 uniform vec3 ambient;
 
-uniform vec3 light_position[3];
+layout (std140) uniform frame_data
+{
+	mat4 view;
+	mat4 projection;
+	vec4 light_position[3];
+};
+
 uniform vec3 light_color[3];
 uniform vec3 light_attenuation[3];
 
@@ -111,7 +100,7 @@ void main()
 
     vec3 result_color = new_ambient;
     for(int i = 0; i < 3; ++i){
-        vec3 light_vector = light_position[i] - position;
+        vec3 light_vector = light_position[i].xyz - position;
         vec3 light_direction = normalize(light_vector);
         float cosine = dot(normal, light_direction);
         float light_factor = max(0.0, cosine);
@@ -130,44 +119,16 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
+// Mirrors the std140 frame_data block of both shaders; the light
+// positions are vec4 since std140 pads every array element to 16 bytes
+struct frame_data
 {
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 light_position[3];
+};
 
-	return result;
-}
+GLuint const frame_data_binding = 0;
 
 struct vertex
 {
@@ -189,102 +150,122 @@ static std::uint32_t plane_indices[]
 	0, 1, 2, 2, 1, 3,
 };
 
-int main() try
+// The brick textures are raw 1024x1024 RGB dumps
+GLsizei const brick_texture_size = 1024;
+
+// Rows of the texture uploaded per slice when the upload runs on the
+// render thread
+GLsizei const brick_slice_rows = 128;
+
+// A brick texture drawn as a single placeholder texel until the real one
+// is loaded from textures/raw/NAME.rgb. The file is read on an asset
+// worker; the upload and mipmap generation fill a separate texture, which
+// is only bound once it is complete. That texture is shared with the
+// upload step, which may outlive the brick_texture.
+struct brick_texture
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 5",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	engine::texture placeholder;
+	std::shared_ptr<engine::texture> texture = std::make_shared<engine::texture>();
+	engine::asset asset;
 
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
+	brick_texture(engine::application & app, std::string const & name, glm::u8vec3 placeholder_color)
+	{
+		glBindTexture(GL_TEXTURE_2D, placeholder);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, &placeholder_color);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+		std::string path = PRACTICE_SOURCE_DIRECTORY "/textures/raw/" + name + ".rgb";
+		asset = app.assets().load(name, [texture = texture, path]
+		{
+			auto file = std::make_shared<engine::mapped_file>(path, true);
+			std::size_t expected_size = brick_texture_size * brick_texture_size * 3;
+			if (file->size() != expected_size)
+				throw std::runtime_error(path + ": expected " + std::to_string(expected_size) + " bytes, got " + std::to_string(file->size()));
 
-	GLuint model_location = glGetUniformLocation(program, "model");
-	GLuint view_location = glGetUniformLocation(program, "view");
-	GLuint projection_location = glGetUniformLocation(program, "projection");
-	GLuint albedo_location = glGetUniformLocation(program, "albedo_texture");
-    GLuint ambient_location = glGetUniformLocation(program, "ambient");
+			// Allocation, one slice per band of rows, then the mipmaps
+			return [texture, file, row = -1]() mutable
+			{
+				glBindTexture(GL_TEXTURE_2D, *texture);
+				if (row < 0)
+				{
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, brick_texture_size, brick_texture_size, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+					row = 0;
+					return false;
+				}
+				if (row < brick_texture_size)
+				{
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, brick_texture_size, brick_slice_rows, GL_RGB, GL_UNSIGNED_BYTE,
+						file->data() + std::size_t(row) * brick_texture_size * 3);
+					row += brick_slice_rows;
+					return false;
+				}
+				glGenerateMipmap(GL_TEXTURE_2D);
+				return true;
+			};
+		});
+	}
 
-    GLuint light_position_location_0 = glGetUniformLocation(program, "light_position[0]");
-    GLuint light_attenuation_location_0 = glGetUniformLocation(program, "light_attenuation[0]");
-    GLuint light_color_location_0 = glGetUniformLocation(program, "light_color[0]");
+	GLuint current() const
+	{
+		return asset.ready() ? GLuint(*texture) : GLuint(placeholder);
+	}
+};
 
-    GLuint light_position_location_1 = glGetUniformLocation(program, "light_position[1]");
-    GLuint light_attenuation_location_1 = glGetUniformLocation(program, "light_attenuation[1]");
-    GLuint light_color_location_1 = glGetUniformLocation(program, "light_color[1]");
+int main(int argc, char ** argv) try
+{
+	engine::application app(argc, argv, {
+		.title = "Graphics course practice 6",
+		.multisamples = 4,
+		.report_interval = 5.f,
+		.uniform_buffer_size = sizeof(frame_data),
+	});
 
-    GLuint light_position_location_2 = glGetUniformLocation(program, "light_position[2]");
-    GLuint light_attenuation_location_2 = glGetUniformLocation(program, "light_attenuation[2]");
-    GLuint light_color_location_2 = glGetUniformLocation(program, "light_color[2]");
+	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-    GLuint normal_map_location = glGetUniformLocation(program, "normal_map");
-    GLuint ao_map_location = glGetUniformLocation(program, "ao_map");
-    GLuint roughness_map_location = glGetUniformLocation(program, "roughness_map");
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
-	glUseProgram(program);
+	program.bind_block("frame_data", frame_data_binding, sizeof(frame_data));
 
-	glUniform1i(albedo_location, 0);
-    glUniform1i(normal_map_location, 1);
-    glUniform1i(ao_map_location, 2);
-    glUniform1i(roughness_map_location, 3);
+	auto model_uniform = program.find("model");
 
-    glUniform3f(ambient_location, 0.8f, 0.8f, 0.8f);
+	glUseProgram(program);
 
-    glUniform3f(light_position_location_0, 0.f, 0.f, 0.f);
-    glUniform3f(light_attenuation_location_0, 1.f, 0.f, 0.1f);
-    glUniform3f(light_color_location_0, 10.f, 10.f, 10.0f);
+	program.set(program.find("albedo_texture"), 0);
+	program.set(program.find("normal_map"), 1);
+	program.set(program.find("ao_map"), 2);
+	program.set(program.find("roughness_map"), 3);
 
-    glUniform3f(light_position_location_1, 0.f, 0.f, 0.f);
-    glUniform3f(light_attenuation_location_1, 1.f, 0.f, 0.1f);
-    glUniform3f(light_color_location_1, 10.f, 0.f, 0.f);
+	program.set(program.find("ambient"), glm::vec3(0.8f, 0.8f, 0.8f));
 
-    glUniform3f(light_position_location_2, 0.f, 5.f, -10.f);
-    glUniform3f(light_attenuation_location_2, 1.f, 0.f, 0.1f);
-    glUniform3f(light_color_location_2, 0.f, 0.f, 10.0f);
+	glm::vec3 const light_attenuation(1.f, 0.f, 0.1f);
+	glm::vec3 const light_colors[] =
+	{
+		{10.f, 10.f, 10.f},
+		{10.f, 0.f, 0.f},
+		{0.f, 0.f, 10.f},
+	};
+
+	for (std::size_t i = 0; i < std::size(light_colors); ++i)
+	{
+		program.set(program.find("light_attenuation"), i, light_attenuation);
+		program.set(program.find("light_color"), i, light_colors[i]);
+	}
 
-	GLuint plane_vao, plane_vbo, plane_ebo;
-	glGenVertexArrays(1, &plane_vao);
+	engine::vertex_array plane_vao;
 	glBindVertexArray(plane_vao);
 
-	glGenBuffers(1, &plane_vbo);
+	engine::buffer plane_vbo;
 	glBindBuffer(GL_ARRAY_BUFFER, plane_vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
-	glGenBuffers(1, &plane_ebo);
+	engine::buffer plane_ebo;
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, plane_ebo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(plane_indices), plane_indices, GL_STATIC_DRAW);
 
@@ -295,85 +276,27 @@ int main() try
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)(24));
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	GLuint brick_albedo;
-	glGenTextures(1, &brick_albedo);
-	glBindTexture(GL_TEXTURE_2D, brick_albedo);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, brick_albedo_width, brick_albedo_height, 0, GL_RGB, GL_UNSIGNED_BYTE, brick_albedo_data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-    GLuint brick_normal;
-    glGenTextures(1, &brick_normal);
-    glBindTexture(GL_TEXTURE_2D, brick_normal);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, brick_normal_width, brick_normal_height, 0, GL_RGB, GL_UNSIGNED_BYTE, brick_normal_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    GLuint brick_ao;
-    glGenTextures(1, &brick_ao);
-    glBindTexture(GL_TEXTURE_2D, brick_ao);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, brick_ao_width, brick_ao_height, 0, GL_RGB, GL_UNSIGNED_BYTE, brick_ao_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    GLuint brick_roughness;
-    glGenTextures(1, &brick_roughness);
-    glBindTexture(GL_TEXTURE_2D, brick_roughness);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, brick_roughness_width, brick_roughness_height, 0, GL_RGB, GL_UNSIGNED_BYTE, brick_roughness_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
+	// Loaded in the background, the planes are drawn with flat placeholder
+	// colors until the textures arrive
+	brick_texture brick_albedo(app, "brick_albedo", {128, 128, 128});
+	brick_texture brick_normal(app, "brick_normal", {128, 128, 255});
+	brick_texture brick_ao(app, "brick_ao", {255, 255, 255});
+	brick_texture brick_roughness(app, "brick_roughness", {128, 128, 128});
 
 	float time = 0.f;
 
-	std::map<SDL_Keycode, bool> button_down;
-
 	float view_angle = glm::pi<float>() / 6.f;
 	float camera_distance = 15.f;
 
-	bool running = true;
-	while (running)
-	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
-		}
-
-		if (!running)
-			break;
+	auto const & input = app.input();
 
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
+	app.run([&](float dt)
+	{
 		time += dt;
 
-		if (button_down[SDLK_UP])
+		if (input.down(SDL_SCANCODE_UP))
 			camera_distance -= 5.f * dt;
-		if (button_down[SDLK_DOWN])
+		if (input.down(SDL_SCANCODE_DOWN))
 			camera_distance += 5.f * dt;
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -387,65 +310,58 @@ int main() try
 		view = glm::translate(view, {0.f, 0.f, -camera_distance});
 		view = glm::rotate(view, view_angle, {1.f, 0.f, 0.f});
 
-		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * app.width()) / app.height(), near, far);
 
-		glUseProgram(program);
-		glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
-		glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
-
-        float x0 = 10 * sin(time - M_PI * 2 / 3);
-        float z0 = 10 * cos(time - M_PI * 2 / 3);
-        glUniform3f(light_position_location_0, x0, 5.f, z0);
+		frame_data frame{view, projection};
+		for (int i = 0; i < 3; ++i)
+		{
+			float angle = time + (i - 1) * M_PI * 2 / 3;
+			frame.light_position[i] = glm::vec4(10 * sin(angle), 5.f, 10 * cos(angle), 1.f);
+		}
 
-        float x1 = 10 * sin(time);
-        float z1 = 10 * cos(time);
-        glUniform3f(light_position_location_1, x1, 5.f, z1);
+		auto & uniform_buffer = app.uniform_buffer();
+		auto frame_block = uniform_buffer.push(frame);
+		uniform_buffer.flush();
+		engine::uniform_ring::bind(frame_data_binding, frame_block);
 
-        float x2 = 10 * sin(time + M_PI * 2 / 3);
-        float z2 = 10 * cos(time + M_PI * 2 / 3);
-        glUniform3f(light_position_location_2, x2, 5.f, z2);
+		glUseProgram(program);
 
 
         glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, brick_albedo);
+		glBindTexture(GL_TEXTURE_2D, brick_albedo.current());
 
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, brick_normal);
+        glBindTexture(GL_TEXTURE_2D, brick_normal.current());
 
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, brick_ao);
+        glBindTexture(GL_TEXTURE_2D, brick_ao.current());
 
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, brick_roughness);
+        glBindTexture(GL_TEXTURE_2D, brick_roughness.current());
 
 		glm::mat4 model(1.f);
 		model = glm::rotate(model, -glm::pi<float>() / 2.f, {1.f, 0.f, 0.f});
-		glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
+		program.set(model_uniform, model);
         glDrawElements(GL_TRIANGLES, std::size(plane_indices), GL_UNSIGNED_INT, nullptr);
 
         model = glm::mat4 (1.f);
         model = glm::translate(model, {0.f, 10.f, -10.f});
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
+        program.set(model_uniform, model);
         glDrawElements(GL_TRIANGLES, std::size(plane_indices), GL_UNSIGNED_INT, nullptr);
 
         model = glm::mat4 (1.f);
         model = glm::rotate(model, -glm::pi<float>() / 2.f, {0.f, 1.f, 0.f});
         model = glm::translate(model, {0.f, 10.f, -10.f});
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
+        program.set(model_uniform, model);
         glDrawElements(GL_TRIANGLES, std::size(plane_indices), GL_UNSIGNED_INT, nullptr);
 
         model = glm::mat4 (1.f);
         model = glm::rotate(model, -glm::pi<float>() / 2.f, {0.f, 1.f, 0.f});
         model = glm::translate(model, {0.f, 10.f, 10.f});
         model = glm::rotate(model, glm::pi<float>(), {0.f, 1.f, 0.f});
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
+        program.set(model_uniform, model);
         glDrawElements(GL_TRIANGLES, std::size(plane_indices), GL_UNSIGNED_INT, nullptr);
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	});
 }
 catch (std::exception const & e)
 {
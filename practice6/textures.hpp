@@ -1,15 +0,0 @@
-extern unsigned char brick_albedo_data[];
-extern unsigned int brick_albedo_width;
-extern unsigned int brick_albedo_height;
-
-extern unsigned char brick_normal_data[];
-extern unsigned int brick_normal_width;
-extern unsigned int brick_normal_height;
-
-extern unsigned char brick_roughness_data[];
-extern unsigned int brick_roughness_width;
-extern unsigned int brick_roughness_height;
-
-extern unsigned char brick_ao_data[];
-extern unsigned int brick_ao_width;
-extern unsigned int brick_ao_height;
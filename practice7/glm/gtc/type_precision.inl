@@ -1,6 +0,0 @@
-/// @ref gtc_precision
-
-namespace glm
-{
-
-}
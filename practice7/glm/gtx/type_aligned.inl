@@ -1,6 +0,0 @@
-/// @ref gtc_type_aligned
-
-namespace glm
-{
-
-}
@@ -1,9 +0,0 @@
-/// @ref core
-/// @file glm/mat3x2.hpp
-
-#pragma once
-#include "./ext/matrix_double3x2.hpp"
-#include "./ext/matrix_double3x2_precision.hpp"
-#include "./ext/matrix_float3x2.hpp"
-#include "./ext/matrix_float3x2_precision.hpp"
-
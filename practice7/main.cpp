@@ -1,26 +1,16 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/mapped_file.hpp>
+#include <engine/mesh_optimize.hpp>
+#include <engine/vertex_format.hpp>
+#include <engine/simplify.hpp>
+#include <engine/meshlet.hpp>
 
-#include <SDL2/SDL.h>
-
-#endif
-
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
+#include <cstdint>
 #include <vector>
-#include <map>
 #include <cmath>
-#include <fstream>
-#include <sstream>
-
-#define GLM_FORCE_SWIZZLE
-#define GLM_ENABLE_EXPERIMENTAL
 
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
@@ -29,18 +19,6 @@
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str) {
-    return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message) {
-    throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error) {
-    throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char dragon_vertex_shader_source[] =
         R"(#version 330 core
 
@@ -159,87 +137,21 @@ void main()
 }
 )";
 
-GLuint create_shader(GLenum type, const char *source) {
-    GLuint result = glCreateShader(type);
-    glShaderSource(result, 1, &source, nullptr);
-    glCompileShader(result);
-    GLint status;
-    glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Shader compilation failed: " + info_log);
-    }
-    return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader) {
-    GLuint result = glCreateProgram();
-    glAttachShader(result, vertex_shader);
-    glAttachShader(result, fragment_shader);
-    glLinkProgram(result);
-
-    GLint status;
-    glGetProgramiv(result, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE) {
-        GLint info_log_length;
-        glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-        std::string info_log(info_log_length, '\0');
-        glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-        throw std::runtime_error("Program linkage failed: " + info_log);
-    }
-
-    return result;
-}
-
 struct dragon_vertex {
     glm::vec3 position;
     glm::i8vec3 normal;
     std::uint8_t ao;
 };
 
-int main() try {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-        sdl2_fail("SDL_Init: ");
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-    SDL_Window *window = SDL_CreateWindow("Graphics course practice 7",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          800, 600,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-    if (!window)
-        sdl2_fail("SDL_CreateWindow: ");
-
-    int width, height;
-    SDL_GetWindowSize(window, &width, &height);
-
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-    if (!gl_context)
-        sdl2_fail("SDL_GL_CreateContext: ");
-
-    if (auto result = glewInit(); result != GLEW_NO_ERROR)
-        glew_fail("glewInit: ", result);
-
-    if (!GLEW_VERSION_3_3)
-        throw std::runtime_error("OpenGL 3.3 is not supported");
+int main(int argc, char **argv) try {
+    engine::application app(argc, argv, {.title = "Graphics course practice 7"});
 
     glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-    auto dragon_vertex_shader = create_shader(GL_VERTEX_SHADER, dragon_vertex_shader_source);
-    auto dragon_fragment_shader = create_shader(GL_FRAGMENT_SHADER, dragon_fragment_shader_source);
-    auto dragon_program = create_program(dragon_vertex_shader, dragon_fragment_shader);
+    engine::program dragon_program({
+            {GL_VERTEX_SHADER, dragon_vertex_shader_source},
+            {GL_FRAGMENT_SHADER, dragon_fragment_shader_source},
+    }, app.programs());
 
     GLuint model_location = glGetUniformLocation(dragon_program, "model");
     GLuint view_location = glGetUniformLocation(dragon_program, "view");
@@ -251,37 +163,73 @@ int main() try {
     GLuint light_direction_location = glGetUniformLocation(dragon_program, "light_direction");
     GLuint light_color_location = glGetUniformLocation(dragon_program, "light_color");
 
-    std::vector<dragon_vertex> dragon_vertices;
-    std::vector<std::uint32_t> indices;
+    engine::vertex_array dragon_vao;
+    glBindVertexArray(dragon_vao);
 
-    {
-        std::ifstream dragon_file(PRACTICE_SOURCE_DIRECTORY "/dragon.raw");
+    engine::buffer dragon_vbo;
+    engine::buffer dragon_ebo;
+    GLenum index_type;
+    std::vector<engine::mesh_lod> lods;
+    // One culler per level of detail
+    std::vector<engine::meshlet_culler> meshlet_cullers;
 
-        std::uint32_t vertex_count;
-        std::uint32_t index_count;
-        dragon_file.read((char *) (&vertex_count), sizeof(vertex_count));
-        dragon_file.read((char *) (&index_count), sizeof(index_count));
+    {
+        // Simplified into levels of detail and reordered for the vertex
+        // cache out of the mapping, which is released afterwards
+        engine::mapped_reader dragon_file(PRACTICE_SOURCE_DIRECTORY "/dragon.raw");
+
+        auto vertex_count = dragon_file.read<std::uint32_t>();
+        auto index_count = dragon_file.read<std::uint32_t>();
+        auto mapped_vertices = dragon_file.read_array<dragon_vertex>(vertex_count);
+        auto mapped_indices = dragon_file.read_array<std::uint32_t>(index_count);
+        dragon_file.expect_end();
+
+        // The normals and the baked occlusion steer the simplification
+        std::vector<glm::vec3> positions(vertex_count);
+        std::vector<float> attributes(4 * vertex_count);
+        for (std::size_t i = 0; i < vertex_count; ++i) {
+            positions[i] = mapped_vertices[i].position;
+            attributes[4 * i + 0] = mapped_vertices[i].normal.x / 127.f;
+            attributes[4 * i + 1] = mapped_vertices[i].normal.y / 127.f;
+            attributes[4 * i + 2] = mapped_vertices[i].normal.z / 127.f;
+            attributes[4 * i + 3] = mapped_vertices[i].ao / 255.f;
+        }
 
-        dragon_vertices.resize(vertex_count);
-        indices.resize(index_count);
-        dragon_file.read((char *) dragon_vertices.data(), dragon_vertices.size() * sizeof(dragon_vertices[0]));
-        dragon_file.read((char *) indices.data(), indices.size() * sizeof(indices[0]));
-    }
+        float const lod_ratios[] = {0.5f, 0.25f, 0.1f, 0.03f};
+        float const attribute_weights[] = {0.05f, 0.05f, 0.05f, 0.05f};
+        auto chain = engine::build_lod_chain(mapped_indices, positions, lod_ratios, attributes, attribute_weights);
+        lods = std::move(chain.lods);
+
+        std::vector<dragon_vertex> vertices(mapped_vertices.begin(), mapped_vertices.end());
+        std::vector<std::uint32_t> indices = std::move(chain.indices);
+        engine::optimize_vertex_fetch(vertices, indices);
+
+        std::cout << "Loaded " << vertices.size() << " vertices, " << index_count << " indices" << std::endl;
+        std::cout << engine::vertex_cache_report(mapped_indices, std::span(indices).first(index_count), vertex_count) << std::endl;
+        std::cout << engine::lod_report(lods) << std::endl;
+
+        // Meshlets of every level, from the reordered vertices
+        std::vector<glm::vec3> reordered_positions(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+            reordered_positions[i] = vertices[i].position;
+        std::size_t meshlet_count = 0;
+        for (auto const &lod : lods) {
+            auto range = std::span<std::uint32_t const>(indices).subspan(lod.first_index, lod.index_count);
+            meshlet_cullers.emplace_back(engine::build_meshlets(range, reordered_positions, lod.first_index));
+            meshlet_count += meshlet_cullers.back().meshlets().size();
+        }
+        std::cout << "Built " << meshlet_count << " meshlets for " << lods.size() << " levels of detail" << std::endl;
 
-    std::cout << "Loaded " << dragon_vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
+        glBindBuffer(GL_ARRAY_BUFFER, dragon_vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(dragon_vertex), vertices.data(), GL_STATIC_DRAW);
 
-    GLuint dragon_vao, dragon_vbo, dragon_ebo;
-    glGenVertexArrays(1, &dragon_vao);
-    glBindVertexArray(dragon_vao);
+        // 16-bit if the dragon has few enough vertices
+        index_type = engine::index_type(vertices.size());
+        auto index_bytes = engine::pack_indices(indices, index_type);
 
-    glGenBuffers(1, &dragon_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, dragon_vbo);
-    glBufferData(GL_ARRAY_BUFFER, dragon_vertices.size() * sizeof(dragon_vertices[0]), dragon_vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glGenBuffers(1, &dragon_ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dragon_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dragon_ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes.size(), index_bytes.data(), GL_STATIC_DRAW);
+    }
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(dragon_vertex), (void *) (0));
@@ -290,20 +238,23 @@ int main() try {
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(dragon_vertex), (void *) (15));
 
-    GLuint color_texture;
-    glGenTextures(1, &color_texture);
+    engine::texture color_texture;
     glBindTexture(GL_TEXTURE_2D, color_texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width / 2, height / 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
-    GLuint renderbuffer;
-    glGenRenderbuffers(1, &renderbuffer);
-    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width / 2, height / 2);
+    engine::renderbuffer renderbuffer;
 
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
+    // Every view is rendered at a quarter of the window area
+    auto resize_offscreen = [&](int width, int height) {
+        app.state().bind_texture(0, GL_TEXTURE_2D, color_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width / 2, height / 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width / 2, height / 2);
+    };
+    resize_offscreen(app.width(), app.height());
+
+    engine::framebuffer framebuffer;
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
     glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color_texture, 0);
     glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
@@ -311,9 +262,10 @@ int main() try {
         throw std::runtime_error("Framebuffer incomplete");
     }
 
-    auto rectangle_vertex_shader = create_shader(GL_VERTEX_SHADER, rectangle_vertex_shader_source);
-    auto rectangle_fragment_shader = create_shader(GL_FRAGMENT_SHADER, rectangle_fragment_shader_source);
-    auto rectangle_program = create_program(rectangle_vertex_shader, rectangle_fragment_shader);
+    engine::program rectangle_program({
+            {GL_VERTEX_SHADER, rectangle_vertex_shader_source},
+            {GL_FRAGMENT_SHADER, rectangle_fragment_shader_source},
+    }, app.programs());
 
     GLuint center_location = glGetUniformLocation(rectangle_program, "center");
     GLuint size_location = glGetUniformLocation(rectangle_program, "size");
@@ -321,85 +273,62 @@ int main() try {
     GLuint mode_location = glGetUniformLocation(rectangle_program, "mode");
     GLuint texture_size_location = glGetUniformLocation(rectangle_program, "texture_size");
     GLuint time_location = glGetUniformLocation(rectangle_program, "time");
+    glUseProgram(rectangle_program);
     glUniform1i(render_result_location, 0);
 
-    GLuint rectangle_vao;
-    glGenVertexArrays(1, &rectangle_vao);
-
-
-    auto last_frame_start = std::chrono::high_resolution_clock::now();
+    engine::vertex_array rectangle_vao;
 
     float time = 0.f;
 
-    std::map<SDL_Keycode, bool> button_down;
-
     float view_angle = 0.f;
     float camera_distance = 0.5f;
     float model_angle = glm::pi<float>() / 2.f;
     float model_scale = 4.f;
 
-    bool running = true;
-    while (running) {
-        for (SDL_Event event; SDL_PollEvent(&event);)
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    switch (event.window.event) {
-                        case SDL_WINDOWEVENT_RESIZED:
-                            width = event.window.data1;
-                            height = event.window.data2;
-                            glViewport(0, 0, width, height);
-                            break;
-                    }
-                    glBindTexture(GL_TEXTURE_2D, color_texture);
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width / 2, height / 2, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                                 nullptr);
-                    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-                    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width / 2, height / 2);
-
-                    break;
-                case SDL_KEYDOWN:
-                    button_down[event.key.keysym.sym] = true;
-                    break;
-                case SDL_KEYUP:
-                    button_down[event.key.keysym.sym] = false;
-                    break;
-            }
+    app.on_resize(resize_offscreen);
+
+    auto &profiler = app.profiler();
+    auto &state = app.state();
+    char const *render_scopes[] = {"render 0 (perspective)", "render 1 (front)", "render 2 (side)", "render 3 (top)"};
+    char const *blit_scopes[] = {"blit 0 (plain)", "blit 1 (blur)", "blit 2 (posterize)", "blit 3 (wave)"};
 
-        if (!running)
-            break;
+    auto const &input = app.input();
+
+    engine::multi_draw meshlet_draws;
+    engine::meshlet_statistics view_meshlets[4];
+
+    app.run([&](float dt) {
+        int width = app.width();
+        int height = app.height();
 
-        auto now = std::chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-        last_frame_start = now;
         time += dt;
 
-        if (button_down[SDLK_UP])
+        if (input.down(SDL_SCANCODE_UP))
             camera_distance -= 1.f * dt;
-        if (button_down[SDLK_DOWN])
+        if (input.down(SDL_SCANCODE_DOWN))
             camera_distance += 1.f * dt;
 
-        if (button_down[SDLK_LEFT])
+        if (input.down(SDL_SCANCODE_LEFT))
             model_angle -= 2.f * dt;
-        if (button_down[SDLK_RIGHT])
+        if (input.down(SDL_SCANCODE_RIGHT))
             model_angle += 2.f * dt;
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glViewport(0, 0, width, height);
+        state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
+        state.viewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
         for (int i = 0; i < 4; i++) {
+            profiler.begin(render_scopes[i]);
+
             glClearColor((1.f * i) / 4.f, 1 - (1.f * i) / 4.f, 1.f, 0.f);
 
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
-            glViewport(0, 0, width / 2, height / 2);
+            state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+            state.viewport(0, 0, width / 2, height / 2);
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glEnable(GL_DEPTH_TEST);
-            glEnable(GL_CULL_FACE);
+            state.enable(GL_DEPTH_TEST);
+            state.enable(GL_CULL_FACE);
 
 
             float near = 0.1f;
@@ -430,7 +359,7 @@ int main() try {
 
             glm::vec3 camera_position = (glm::inverse(view) * glm::vec4(0.f, 0.f, 0.f, 1.f)).xyz();
 
-            glUseProgram(dragon_program);
+            state.use_program(dragon_program);
             glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
             glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
             glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
@@ -441,13 +370,29 @@ int main() try {
             glUniform3f(light_direction_location, 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f));
             glUniform3f(light_color_location, 0.8f, 0.3f, 0.f);
 
-            glBindVertexArray(dragon_vao);
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+            // The coarsest level that stays within a pixel of the full mesh
+            // in this view, which is half the window high. model_scale
+            // scales w as well and so leaves the dragon's size unchanged
+            float pixels_per_unit = i == 0
+                ? engine::perspective_pixels_per_unit(glm::pi<float>() / 2.f, height / 2.f, camera_distance)
+                : engine::orthographic_pixels_per_unit(2.f / aspect_ratio, height / 2.f);
+            auto lod = engine::select_lod(lods, pixels_per_unit);
+
+            // Only the meshlets inside the view and facing the camera
+            view_meshlets[i] += meshlet_cullers[lod].cull(projection, view, model, engine::index_size(index_type),
+                meshlet_draws);
+
+            state.bind_vertex_array(dragon_vao);
+            meshlet_draws.draw(index_type);
+
+            profiler.end();
+
+            profiler.begin(blit_scopes[i]);
 
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-            glViewport(0, 0, width, height);
+            state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
+            state.viewport(0, 0, width, height);
 
-            glUseProgram(rectangle_program);
+            state.use_program(rectangle_program);
             if (i == 0) {
                 glUniform2f(center_location, -0.5f, -0.5f);
             } else if (i == 1) {
@@ -462,196 +407,18 @@ int main() try {
             glUniform1i(mode_location, i);
             glUniform2f(texture_size_location, width / 2.0, height / 2.0);
             glUniform1f(time_location, time);
-            glBindVertexArray(rectangle_vao);
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, render_result_location);
+            state.bind_vertex_array(rectangle_vao);
 
+            state.bind_texture(0, GL_TEXTURE_2D, color_texture);
 
             glDrawArrays(GL_TRIANGLES, 0, 6);
-        }
-
-        SDL_GL_SwapWindow(window);
-    }
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
-
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
-
-	auto dragon_vertex_shader = create_shader(GL_VERTEX_SHADER, dragon_vertex_shader_source);
-	auto dragon_fragment_shader = create_shader(GL_FRAGMENT_SHADER, dragon_fragment_shader_source);
-	auto dragon_program = create_program(dragon_vertex_shader, dragon_fragment_shader);
-
-	GLuint model_location = glGetUniformLocation(dragon_program, "model");
-	GLuint view_location = glGetUniformLocation(dragon_program, "view");
-	GLuint projection_location = glGetUniformLocation(dragon_program, "projection");
-
-	GLuint camera_position_location = glGetUniformLocation(dragon_program, "camera_position");
-
-	GLuint ambient_location = glGetUniformLocation(dragon_program, "ambient");
-	GLuint light_direction_location = glGetUniformLocation(dragon_program, "light_direction");
-	GLuint light_color_location = glGetUniformLocation(dragon_program, "light_color");
-
-	std::vector<dragon_vertex> dragon_vertices;
-	std::vector<std::uint32_t> indices;
-
-	{
-		std::ifstream dragon_file(PRACTICE_SOURCE_DIRECTORY "/dragon.raw", std::ios::binary);
-
-		std::uint32_t vertex_count;
-		std::uint32_t index_count;
-		dragon_file.read((char*)(&vertex_count), sizeof(vertex_count));
-		dragon_file.read((char*)(&index_count), sizeof(index_count));
-
-		dragon_vertices.resize(vertex_count);
-		indices.resize(index_count);
-		dragon_file.read((char*)dragon_vertices.data(), dragon_vertices.size() * sizeof(dragon_vertices[0]));
-		dragon_file.read((char*)indices.data(), indices.size() * sizeof(indices[0]));
-	}
-
-	std::cout << "Loaded " << dragon_vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
-
-	GLuint dragon_vao, dragon_vbo, dragon_ebo;
-	glGenVertexArrays(1, &dragon_vao);
-	glBindVertexArray(dragon_vao);
-
-	glGenBuffers(1, &dragon_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, dragon_vbo);
-	glBufferData(GL_ARRAY_BUFFER, dragon_vertices.size() * sizeof(dragon_vertices[0]), dragon_vertices.data(), GL_STATIC_DRAW);
-
-	glGenBuffers(1, &dragon_ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dragon_ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(dragon_vertex), (void*)(0));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_BYTE, GL_TRUE, sizeof(dragon_vertex), (void*)(12));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(dragon_vertex), (void*)(15));
 
-	auto rectangle_vertex_shader = create_shader(GL_VERTEX_SHADER, rectangle_vertex_shader_source);
-	auto rectangle_fragment_shader = create_shader(GL_FRAGMENT_SHADER, rectangle_fragment_shader_source);
-	auto rectangle_program = create_program(rectangle_vertex_shader, rectangle_fragment_shader);
-
-	GLuint center_location = glGetUniformLocation(rectangle_program, "center");
-	GLuint size_location = glGetUniformLocation(rectangle_program, "size");
-
-	GLuint rectangle_vao;
-	glGenVertexArrays(1, &rectangle_vao);
-
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
-
-	float time = 0.f;
-
-	std::map<SDL_Keycode, bool> button_down;
-
-	float view_angle = 0.f;
-	float camera_distance = 0.5f;
-	float model_angle = glm::pi<float>() / 2.f;
-	float model_scale = 1.f;
+            profiler.end();
+        }
+    });
 
-	bool running = true;
-	while (running)
-	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
-		}
-
-		if (!running)
-			break;
-
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
-		time += dt;
-
-		if (button_down[SDLK_UP])
-			camera_distance -= 1.f * dt;
-		if (button_down[SDLK_DOWN])
-			camera_distance += 1.f * dt;
-
-		if (button_down[SDLK_LEFT])
-			model_angle -= 2.f * dt;
-		if (button_down[SDLK_RIGHT])
-			model_angle += 2.f * dt;
-
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-
-		float near = 0.1f;
-		float far = 100.f;
-
-		glm::mat4 model(1.f);
-		model = glm::rotate(model, model_angle, {0.f, 1.f, 0.f});
-		model = glm::scale(model, glm::vec3(model_scale));
-
-		glm::mat4 view(1.f);
-		view = glm::translate(view, {0.f, 0.f, -camera_distance});
-		view = glm::rotate(view, view_angle, {1.f, 0.f, 0.f});
-
-		glm::mat4 projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
-
-		glm::vec3 camera_position = (glm::inverse(view) * glm::vec4(0.f, 0.f, 0.f, 1.f)).xyz();
-
-		glUseProgram(dragon_program);
-		glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
-		glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
-		glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
-
-		glUniform3fv(camera_position_location, 1, (float*)(&camera_position));
-
-		glUniform3f(ambient_location, 0.2f, 0.2f, 0.4f);
-		glUniform3f(light_direction_location, 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f), 1.f / std::sqrt(3.f));
-		glUniform3f(light_color_location, 0.8f, 0.3f, 0.f);
-
-		glBindVertexArray(dragon_vao);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
-
-		glUseProgram(rectangle_program);
-		glUniform2f(center_location, -0.5f, -0.5f);
-		glUniform2f(size_location, 0.5f, 0.5f);
-		glBindVertexArray(rectangle_vao);
-//		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		SDL_GL_SwapWindow(window);
-	}
-
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+    for (int i = 0; i < 4; i++)
+        std::cout << render_scopes[i] << ": " << engine::meshlet_report(view_meshlets[i]) << std::endl;
 }
 catch (std::exception const &e) {
     std::cerr << e.what() << std::endl;
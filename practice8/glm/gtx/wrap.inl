@@ -1,6 +0,0 @@
-/// @ref gtx_wrap
-
-namespace glm
-{
-
-}//namespace glm
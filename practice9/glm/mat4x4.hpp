@@ -1,9 +0,0 @@
-/// @ref core
-/// @file glm/mat4x4.hpp
-
-#pragma once
-#include "./ext/matrix_double4x4.hpp"
-#include "./ext/matrix_double4x4_precision.hpp"
-#include "./ext/matrix_float4x4.hpp"
-#include "./ext/matrix_float4x4_precision.hpp"
-
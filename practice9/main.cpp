@@ -1,79 +1,84 @@
-#ifdef WIN32
-#include <SDL.h>
-#undef main
-#else
-#include <SDL2/SDL.h>
-#endif
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/obj.hpp>
+#include <engine/mesh_file.hpp>
+#include <engine/mesh_optimize.hpp>
+#include <engine/vertex_format.hpp>
+#include <engine/simplify.hpp>
+#include <engine/normals.hpp>
+#include <engine/bvh.hpp>
 
-#include <GL/glew.h>
-
-#include <string_view>
-#include <stdexcept>
 #include <iostream>
-#include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
-#include <fstream>
-#include <sstream>
+#include <cstddef>
+#include <cstring>
+#include <span>
 
-#define GLM_FORCE_SWIZZLE
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
 const char vertex_shader_source[] =
 R"(#version 330 core
 
+layout (std140) uniform frame_data
+{
+	mat4 view;
+	mat4 projection;
+	mat4 transform;
+	vec4 light_direction;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec3 in_normal;
+layout (location = 1) in vec2 in_normal;
 
 out vec3 position;
 out vec3 normal;
 
+vec3 decode_octahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
 void main()
 {
 	gl_Position = projection * view * model * vec4(in_position, 1.0);
 	position = (model * vec4(in_position, 1.0)).xyz;
-	normal = normalize((model * vec4(in_normal, 0.0)).xyz);
+	normal = normalize((model * vec4(decode_octahedral(in_normal), 0.0)).xyz);
 }
 )";
 
 const char fragment_shader_source[] =
 R"(#version 330 core
 
-uniform vec3 ambient;
+layout (std140) uniform frame_data
+{
+	mat4 view;
+	mat4 projection;
+	mat4 transform;
+	vec4 light_direction;
+};
 
-uniform vec3 light_direction;
+uniform vec3 ambient;
 uniform vec3 light_color;
 
-uniform mat4 transform;
-
 uniform sampler2D shadow_map;
 
+// Marks the point picked with the mouse, if the radius is positive
+uniform vec3 pick_position;
+uniform float pick_radius;
+
 in vec3 position;
 in vec3 normal;
 
@@ -91,9 +96,11 @@ void main()
 		shadow_factor = (texture(shadow_map, shadow_pos.xy).r < shadow_pos.z) ? 0.0 : 1.0;
 
 	vec3 albedo = vec3(1.0, 1.0, 1.0);
+	if (distance(position, pick_position) < pick_radius)
+		albedo = vec3(1.0, 0.3, 0.2);
 
 	vec3 light = ambient;
-	light += light_color * max(0.0, dot(normal, light_direction)) * shadow_factor;
+	light += light_color * max(0.0, dot(normal, light_direction.xyz)) * shadow_factor;
 	vec3 color = albedo * light;
 
 	out_color = vec4(color, 1.0);
@@ -140,8 +147,15 @@ void main()
 const char shadow_vertex_shader_source[] =
 R"(#version 330 core
 
+layout (std140) uniform frame_data
+{
+	mat4 view;
+	mat4 projection;
+	mat4 transform;
+	vec4 light_direction;
+};
+
 uniform mat4 model;
-uniform mat4 transform;
 
 layout (location = 0) in vec3 in_position;
 
@@ -158,44 +172,16 @@ void main()
 {}
 )";
 
-GLuint create_shader(GLenum type, const char * source)
+// Mirrors the std140 frame_data block shared by all programs
+struct frame_data
 {
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 transform;
+	glm::vec4 light_direction;
+};
 
-	return result;
-}
+GLuint const frame_data_binding = 0;
 
 struct vertex
 {
@@ -203,47 +189,15 @@ struct vertex
 	glm::vec3 normal;
 };
 
-std::pair<std::vector<vertex>, std::vector<std::uint32_t>> load_obj(std::istream & input)
+// What is uploaded: positions quantized in the bounds of the mesh and
+// octahedral normals, 12 bytes instead of 24
+struct packed_vertex
 {
-	std::vector<vertex> vertices;
-	std::vector<std::uint32_t> indices;
-
-	for (std::string line; std::getline(input, line);)
-	{
-		std::istringstream line_stream(line);
-
-		char type;
-		line_stream >> type;
-
-		if (type == '#')
-			continue;
-
-		if (type == 'v')
-		{
-			vertex v;
-			line_stream >> v.position.x >> v.position.y >> v.position.z;
-			vertices.push_back(v);
-			continue;
-		}
-
-		if (type == 'f')
-		{
-			std::uint32_t i0, i1, i2;
-			line_stream >> i0 >> i1 >> i2;
-			--i0;
-			--i1;
-			--i2;
-			indices.push_back(i0);
-			indices.push_back(i1);
-			indices.push_back(i2);
-			continue;
-		}
-
-		throw std::runtime_error("Unknown OBJ row type: " + std::string(1, type));
-	}
+	glm::u16vec4 position;
+	glm::i16vec2 normal;
+};
 
-	return {vertices, indices};
-}
+static_assert(sizeof(packed_vertex) == 12);
 
 std::pair<glm::vec3, glm::vec3> bbox(std::vector<vertex> const & vertices)
 {
@@ -292,130 +246,181 @@ void add_ground_plane(std::vector<vertex> & vertices, std::vector<std::uint32_t>
 	indices.push_back(base_index + 3);
 }
 
-void fill_normals(std::vector<vertex> & vertices, std::vector<std::uint32_t> const & indices)
+std::vector<packed_vertex> pack_vertices(std::vector<vertex> const & vertices, engine::position_quantization const & quantization,
+	engine::vertex_format_statistics & statistics)
 {
-	for (auto & v : vertices)
-		v.normal = glm::vec3(0.f);
-
-	for (std::size_t i = 0; i < indices.size(); i += 3)
+	std::vector<packed_vertex> result(vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); ++i)
 	{
-		auto & v0 = vertices[indices[i + 0]];
-		auto & v1 = vertices[indices[i + 1]];
-		auto & v2 = vertices[indices[i + 2]];
-
-		glm::vec3 n = glm::cross(v1.position - v0.position, v2.position - v0.position);
-		v0.normal += n;
-		v1.normal += n;
-		v2.normal += n;
-	}
+		result[i].position = quantization.encode(vertices[i].position);
+		result[i].normal = engine::encode_octahedral<std::int16_t>(vertices[i].normal);
 
-	for (auto & v : vertices)
-		v.normal = glm::normalize(v.normal);
+		statistics.add_position(vertices[i].position, quantization.decode(result[i].position));
+		statistics.add_normal(vertices[i].normal, engine::decode_octahedral(result[i].normal));
+	}
+	return result;
 }
 
-int main() try
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 9",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
+	engine::application app(argc, argv, {
+		.title = "Graphics course practice 9",
+		.uniform_buffer_size = sizeof(frame_data),
+	});
 
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
+	engine::program program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
 
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
-
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+	program.bind_block("frame_data", frame_data_binding, sizeof(frame_data));
 
 	GLuint model_location = glGetUniformLocation(program, "model");
-	GLuint view_location = glGetUniformLocation(program, "view");
-	GLuint projection_location = glGetUniformLocation(program, "projection");
-	GLuint transform_location = glGetUniformLocation(program, "transform");
 
 	GLuint ambient_location = glGetUniformLocation(program, "ambient");
-	GLuint light_direction_location = glGetUniformLocation(program, "light_direction");
 	GLuint light_color_location = glGetUniformLocation(program, "light_color");
+	GLuint pick_position_location = glGetUniformLocation(program, "pick_position");
+	GLuint pick_radius_location = glGetUniformLocation(program, "pick_radius");
 
 	GLuint shadow_map_location = glGetUniformLocation(program, "shadow_map");
 
 	glUseProgram(program);
 	glUniform1i(shadow_map_location, 0);
 
-	auto debug_vertex_shader = create_shader(GL_VERTEX_SHADER, debug_vertex_shader_source);
-	auto debug_fragment_shader = create_shader(GL_FRAGMENT_SHADER, debug_fragment_shader_source);
-	auto debug_program = create_program(debug_vertex_shader, debug_fragment_shader);
+	engine::program debug_program({
+		{GL_VERTEX_SHADER, debug_vertex_shader_source},
+		{GL_FRAGMENT_SHADER, debug_fragment_shader_source},
+	}, app.programs());
 
 	GLuint debug_shadow_map_location = glGetUniformLocation(debug_program, "shadow_map");
 
 	glUseProgram(debug_program);
 	glUniform1i(debug_shadow_map_location, 0);
 
-	auto shadow_vertex_shader = create_shader(GL_VERTEX_SHADER, shadow_vertex_shader_source);
-	auto shadow_fragment_shader = create_shader(GL_FRAGMENT_SHADER, shadow_fragment_shader_source);
-	auto shadow_program = create_program(shadow_vertex_shader, shadow_fragment_shader);
+	engine::program shadow_program({
+		{GL_VERTEX_SHADER, shadow_vertex_shader_source},
+		{GL_FRAGMENT_SHADER, shadow_fragment_shader_source},
+	}, app.programs());
+
+	shadow_program.bind_block("frame_data", frame_data_binding, sizeof(frame_data));
 
 	GLuint shadow_model_location = glGetUniformLocation(shadow_program, "model");
-	GLuint shadow_transform_location = glGetUniformLocation(shadow_program, "transform");
 
-	std::vector<vertex> vertices;
-	std::vector<std::uint32_t> indices;
+	// Built from bunny.obj on the first run, mapped from the cache afterwards
+	auto mesh = engine::load_cached_mesh(PRACTICE_BINARY_DIRECTORY "/bunny.mesh", PRACTICE_SOURCE_DIRECTORY "/bunny.obj",
+		"practice9 bunny + ground plane v5", []
 	{
-		std::ifstream bunny_file(PRACTICE_SOURCE_DIRECTORY "/bunny.obj");
-		std::tie(vertices, indices) = load_obj(bunny_file);
+		auto bunny = engine::load_obj(PRACTICE_SOURCE_DIRECTORY "/bunny.obj");
+
+		std::vector<vertex> vertices(bunny.positions.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			vertices[i].position = bunny.positions[i];
+		std::vector<std::uint32_t> indices = std::move(bunny.indices);
+
+		add_ground_plane(vertices, indices);
+
+		std::vector<glm::vec3> positions(vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			positions[i] = vertices[i].position;
+		auto vertex_normals = engine::compute_normals(indices, positions);
+
+		// Simplified with the normals as attributes, so that creases are
+		// kept longer than flat areas
+		std::vector<float> normals(3 * vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+		{
+			vertices[i].normal = vertex_normals[i];
+			normals[3 * i + 0] = vertices[i].normal.x;
+			normals[3 * i + 1] = vertices[i].normal.y;
+			normals[3 * i + 2] = vertices[i].normal.z;
+		}
+
+		float const lod_ratios[] = {0.5f, 0.25f, 0.1f, 0.03f};
+		float const normal_weights[] = {0.05f, 0.05f, 0.05f};
+		auto chain = engine::build_lod_chain(indices, positions, lod_ratios, normals, normal_weights);
+		std::cout << engine::lod_report(chain.lods) << std::endl;
+
+		// Every level is in vertex cache order; the vertices are fetched
+		// in the order of the full mesh, which uses all of them
+		auto original_vertex_count = vertices.size();
+		engine::optimize_vertex_fetch(vertices, chain.indices);
+		std::cout << engine::vertex_cache_report(indices, std::span(chain.indices).first(indices.size()), original_vertex_count) << std::endl;
+
+		auto [ min, max ] = bbox(vertices);
+		engine::position_quantization quantization(min, max);
+
+		engine::vertex_format_statistics statistics;
+		statistics.vertices = vertices.size();
+		statistics.indices = chain.indices.size();
+		statistics.vertex_size_before = sizeof(vertex);
+		statistics.vertex_size_after = sizeof(packed_vertex);
+		statistics.index_size_after = engine::index_size(engine::index_type(vertices.size()));
+
+		auto packed = pack_vertices(vertices, quantization, statistics);
+		std::cout << engine::vertex_format_report(statistics) << std::endl;
+
+		engine::mesh_data data(packed, std::move(chain.indices), {
+			{0, GL_UNSIGNED_SHORT, 3, GL_TRUE, offsetof(packed_vertex, position)},
+			{1, GL_SHORT, 2, GL_TRUE, offsetof(packed_vertex, normal)},
+		});
+		data.bounds_min = min;
+		data.bounds_max = max;
+		data.lods = std::move(chain.lods);
+		// The shadow pass reads the positions alone
+		data.split_positions = true;
+		return data;
+	});
+
+	// The positions are dequantized by the model matrix
+	engine::position_quantization quantization(mesh.header().bounds_min, mesh.header().bounds_max);
+	GLenum index_type = mesh.header().index_type;
+	std::size_t index_size = engine::index_size(index_type);
+	auto lods = mesh.lods();
+
+	// The BVH of the full mesh for picking, in the original units, which
+	// the model matrix leaves unchanged
+	engine::bvh picking_bvh;
+	{
+		auto position_bytes = mesh.positions();
+		std::vector<glm::vec3> positions(mesh.header().vertex_count);
+		for (std::size_t i = 0; i < positions.size(); ++i)
+		{
+			glm::u16vec4 position(0);
+			std::memcpy(&position, position_bytes.data() + i * mesh.position_stride(), 3 * sizeof(std::uint16_t));
+			positions[i] = quantization.decode(position);
+		}
+
+		auto indices = mesh.indices();
+		picking_bvh = engine::bvh(std::span<std::uint32_t const>(indices).subspan(lods[0].first_index, lods[0].index_count), positions);
+		std::cout << engine::bvh_report(picking_bvh) << std::endl;
 	}
-	add_ground_plane(vertices, indices);
-	fill_normals(vertices, indices);
 
-	GLuint vao, vbo, ebo;
-	glGenVertexArrays(1, &vao);
+	engine::vertex_array vao;
 	glBindVertexArray(vao);
 
-	glGenBuffers(1, &vbo);
+	engine::buffer vbo;
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices().size(), mesh.vertices().data(), GL_STATIC_DRAW);
 
-	glGenBuffers(1, &ebo);
+	engine::buffer ebo;
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.index_bytes().size(), mesh.index_bytes().data(), GL_STATIC_DRAW);
+
+	mesh.setup_attributes();
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)(0));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)(12));
+	// Depth only: the same buffers, but nothing fetched besides the
+	// position stream
+	engine::vertex_array shadow_vao;
+	glBindVertexArray(shadow_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	mesh.setup_position_attribute();
 
-	GLuint debug_vao;
-	glGenVertexArrays(1, &debug_vao);
+	engine::vertex_array debug_vao;
 
 	GLsizei shadow_map_resolution = 1024;
 
-	GLuint shadow_map;
-	glGenTextures(1, &shadow_map);
+	engine::texture shadow_map;
 	glBindTexture(GL_TEXTURE_2D, shadow_map);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -423,87 +428,67 @@ int main() try
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, shadow_map_resolution, shadow_map_resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
-	GLuint shadow_fbo;
-	glGenFramebuffers(1, &shadow_fbo);
+	engine::framebuffer shadow_fbo;
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadow_fbo);
 	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map, 0);
 	if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		throw std::runtime_error("Incomplete framebuffer!");
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-
-	auto last_frame_start = std::chrono::high_resolution_clock::now();
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
 
 	float time = 0.f;
 	bool paused = false;
 
-	std::map<SDL_Keycode, bool> button_down;
-
 	float view_elevation = glm::radians(45.f);
 	float view_azimuth = 0.f;
 	float camera_distance = 0.5f;
 	float camera_target = 0.05f;
-	bool running = true;
-	while (running)
-	{
-		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
-		{
-		case SDL_QUIT:
-			running = false;
-			break;
-		case SDL_WINDOWEVENT: switch (event.window.event)
-			{
-			case SDL_WINDOWEVENT_RESIZED:
-				width = event.window.data1;
-				height = event.window.data2;
-				glViewport(0, 0, width, height);
-				break;
-			}
-			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
 
-			if (event.key.keysym.sym == SDLK_SPACE)
-				paused = !paused;
+	glm::vec3 pick_position(0.f);
+	float pick_radius = 0.f;
 
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
-			break;
-		}
-
-		if (!running)
-			break;
+	enum camera_action
+	{
+		zoom_in,
+		zoom_out,
+		rotate_left,
+		rotate_right,
+	};
+
+	auto & input = app.input();
+	input.bind(zoom_in, SDL_SCANCODE_UP);
+	input.bind(zoom_in, SDL_SCANCODE_W);
+	input.bind(zoom_out, SDL_SCANCODE_DOWN);
+	input.bind(zoom_out, SDL_SCANCODE_S);
+	input.bind(rotate_left, SDL_SCANCODE_LEFT);
+	input.bind(rotate_left, SDL_SCANCODE_A);
+	input.bind(rotate_right, SDL_SCANCODE_RIGHT);
+	input.bind(rotate_right, SDL_SCANCODE_D);
+
+	auto & profiler = app.profiler();
+	auto & state = app.state();
+
+	app.run([&](float dt)
+	{
+		if (input.pressed(SDL_SCANCODE_SPACE))
+			paused = !paused;
 
-		auto now = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
-		last_frame_start = now;
 		if (!paused)
 			time += dt;
 
-		if (button_down[SDLK_UP])
+		if (input.action_down(zoom_in))
 			camera_distance -= 1.f * dt;
-		if (button_down[SDLK_DOWN])
+		if (input.action_down(zoom_out))
 			camera_distance += 1.f * dt;
 
-		if (button_down[SDLK_LEFT])
+		if (input.action_down(rotate_left))
 			view_azimuth -= 2.f * dt;
-		if (button_down[SDLK_RIGHT])
+		if (input.action_down(rotate_right))
 			view_azimuth += 2.f * dt;
 
-		glm::mat4 model(1.f);
+		glm::mat4 model = quantization.dequantize();
 
 		glm::vec3 light_direction = glm::normalize(glm::vec3(std::cos(time * 0.5f), 1.f, std::sin(time * 0.5f)));
 
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadow_fbo);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, shadow_map_resolution, shadow_map_resolution);
-
-		glEnable(GL_DEPTH_TEST);
-		glDepthFunc(GL_LEQUAL);
-
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_BACK);
-
 		glm::vec3 light_z = -light_direction;
 		glm::vec3 light_x = glm::normalize(glm::cross(light_z, {0.f, 1.f, 0.f}));
 		glm::vec3 light_y = glm::cross(light_x, light_z);
@@ -517,28 +502,6 @@ int main() try
 			transform[i][2] = shadow_scale * light_z[i];
 		}
 
-		glUseProgram(shadow_program);
-		glUniformMatrix4fv(shadow_model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
-		glUniformMatrix4fv(shadow_transform_location, 1, GL_FALSE, reinterpret_cast<float *>(&transform));
-
-		glBindVertexArray(vao);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
-
-		glBindTexture(GL_TEXTURE_2D, shadow_map);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-		glViewport(0, 0, width, height);
-
-		glClearColor(0.8f, 0.8f, 0.9f, 0.f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glEnable(GL_DEPTH_TEST);
-		glDepthFunc(GL_LEQUAL);
-
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_BACK);
-
 		float near = 0.01f;
 		float far = 10.f;
 
@@ -549,33 +512,101 @@ int main() try
 		view = glm::translate(view, {0.f, -camera_target, 0.f});
 
 		glm::mat4 projection = glm::mat4(1.f);
-		projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * width) / height, near, far);
+		projection = glm::perspective(glm::pi<float>() / 2.f, (1.f * app.width()) / app.height(), near, far);
+
+		// Clicking marks the point under the cursor and tells whether the
+		// light reaches it; clicking the sky removes the mark
+		if (input.mouse_pressed(SDL_BUTTON_LEFT))
+		{
+			auto r = engine::screen_ray(projection, view, input.mouse_x(), input.mouse_y(), app.width(), app.height());
+			if (auto hit = picking_bvh.closest_hit(r))
+			{
+				pick_position = r.origin + r.direction * hit.t;
+				pick_radius = 0.005f;
+
+				// Started off the surface, so that the ray does not hit the
+				// picked triangle itself
+				engine::ray shadow_ray{pick_position, light_direction, 1e-4f};
+				std::cout << "Picked triangle " << hit.triangle << " at " << glm::to_string(pick_position)
+					<< (picking_bvh.any_hit(shadow_ray) ? ", in shadow" : ", lit") << std::endl;
+			}
+			else
+				pick_radius = 0.f;
+		}
+
+		// The coarsest level that stays within a pixel of the full mesh in
+		// the view. The shadow map is rendered with the same level: the
+		// shadow compare has no bias, so a caster surface that differs from
+		// the receiver by the simplification error would shadow itself
+		float pixels_per_unit = engine::perspective_pixels_per_unit(glm::pi<float>() / 2.f, app.height(), camera_distance);
+		auto const & lod = lods[engine::select_lod(lods, pixels_per_unit)];
+
+		auto & uniform_buffer = app.uniform_buffer();
+		auto frame_block = uniform_buffer.push(frame_data{view, projection, transform, glm::vec4(light_direction, 0.f)});
+		uniform_buffer.flush();
+		engine::uniform_ring::bind(frame_data_binding, frame_block);
+
+		profiler.begin("shadow pass");
+
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, shadow_fbo);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		state.viewport(0, 0, shadow_map_resolution, shadow_map_resolution);
+
+		state.enable(GL_DEPTH_TEST);
+		state.depth_func(GL_LEQUAL);
+
+		state.enable(GL_CULL_FACE);
+		state.cull_face(GL_BACK);
+
+		state.use_program(shadow_program);
+		glUniformMatrix4fv(shadow_model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
+
+		state.bind_vertex_array(shadow_vao);
+		glDrawElements(GL_TRIANGLES, lod.index_count, index_type, reinterpret_cast<void const *>(lod.first_index * index_size));
+
+		state.bind_texture(0, GL_TEXTURE_2D, shadow_map);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		profiler.end();
+
+		profiler.begin("main pass");
+
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
+		state.viewport(0, 0, app.width(), app.height());
+
+		glClearColor(0.8f, 0.8f, 0.9f, 0.f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		state.enable(GL_DEPTH_TEST);
+		state.depth_func(GL_LEQUAL);
+
+		state.enable(GL_CULL_FACE);
+		state.cull_face(GL_BACK);
 
-		glBindTexture(GL_TEXTURE_2D, shadow_map);
+		state.bind_texture(0, GL_TEXTURE_2D, shadow_map);
 
-		glUseProgram(program);
+		state.use_program(program);
 		glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float *>(&model));
-		glUniformMatrix4fv(view_location, 1, GL_FALSE, reinterpret_cast<float *>(&view));
-		glUniformMatrix4fv(projection_location, 1, GL_FALSE, reinterpret_cast<float *>(&projection));
-		glUniformMatrix4fv(transform_location, 1, GL_FALSE, reinterpret_cast<float *>(&transform));
 
 		glUniform3f(ambient_location, 0.2f, 0.2f, 0.2f);
-		glUniform3fv(light_direction_location, 1, reinterpret_cast<float *>(&light_direction));
 		glUniform3f(light_color_location, 0.8f, 0.8f, 0.8f);
+		glUniform3fv(pick_position_location, 1, reinterpret_cast<float *>(&pick_position));
+		glUniform1f(pick_radius_location, pick_radius);
 
-		glBindVertexArray(vao);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+		state.bind_vertex_array(vao);
+		glDrawElements(GL_TRIANGLES, lod.index_count, index_type, reinterpret_cast<void const *>(lod.first_index * index_size));
 
-		glUseProgram(debug_program);
-		glBindTexture(GL_TEXTURE_2D, shadow_map);
-		glBindVertexArray(debug_vao);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		profiler.end();
 
-		SDL_GL_SwapWindow(window);
-	}
+		profiler.begin("debug quad");
+
+		state.use_program(debug_program);
+		state.bind_texture(0, GL_TEXTURE_2D, shadow_map);
+		state.bind_vertex_array(debug_vao);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+		profiler.end();
+	});
 }
 catch (std::exception const & e)
 {
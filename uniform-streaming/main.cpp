@@ -0,0 +1,264 @@
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+// Compares three ways of getting per-object uniform data to the GPU:
+//     glUniform        - glUniformMatrix4fv + glUniform4fv before every draw
+//     glBufferSubData  - one small uniform buffer rewritten before every draw
+//     mapped ring      - all objects written into engine::uniform_ring once
+//                        per frame, then bound by range before every draw
+// Every strategy renders 1, 100 and 10000 objects for a fixed number of
+// frames; run with --headless for numbers that do not depend on vsync.
+
+const char vertex_shader_source[] =
+R"(#version 330 core
+
+#ifdef OBJECT_BLOCK
+layout (std140) uniform object_data
+{
+	mat4 model;
+	vec4 color;
+};
+#else
+uniform mat4 model;
+uniform vec4 color;
+#endif
+
+vec2 vertices[3] = vec2[3](
+	vec2(-1.0, -1.0),
+	vec2( 1.0, -1.0),
+	vec2( 0.0,  1.0)
+);
+
+out vec4 object_color;
+
+void main()
+{
+	gl_Position = model * vec4(vertices[gl_VertexID], 0.0, 1.0);
+	object_color = color;
+}
+)";
+
+const char fragment_shader_source[] =
+R"(#version 330 core
+
+in vec4 object_color;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = object_color;
+}
+)";
+
+// Mirrors the std140 object_data block
+struct object_data
+{
+	glm::mat4 model;
+	glm::vec4 color;
+};
+
+enum class strategy
+{
+	uniform,
+	buffer_sub_data,
+	mapped_ring,
+};
+
+char const * strategy_name(strategy s)
+{
+	switch (s)
+	{
+	case strategy::uniform:         return "glUniform";
+	case strategy::buffer_sub_data: return "glBufferSubData";
+	case strategy::mapped_ring:     return "mapped ring";
+	}
+	return "";
+}
+
+struct benchmark_run
+{
+	strategy method;
+	int objects;
+
+	double submit_ms = 0.0;
+	double frame_ms = 0.0;
+	int frames = 0;
+};
+
+GLuint const object_data_binding = 0;
+
+int const max_objects = 10000;
+int const warmup_frames = 10;
+int const measured_frames = 100;
+
+// Three strategies times three object counts
+int const run_count = 9;
+
+int main(int argc, char ** argv) try
+{
+	engine::application app(argc, argv, {
+		.title = "Graphics course uniform streaming benchmark",
+		.vsync = false,
+		.frames = run_count * (warmup_frames + measured_frames),
+		// Generous enough for any GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT in use
+		.uniform_buffer_size = max_objects * 256,
+	});
+
+	engine::program uniform_program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs());
+
+	GLint model_location = uniform_program.uniform_location("model");
+	GLint color_location = uniform_program.uniform_location("color");
+
+	engine::program block_program({
+		{GL_VERTEX_SHADER, vertex_shader_source},
+		{GL_FRAGMENT_SHADER, fragment_shader_source},
+	}, app.programs(), "#define OBJECT_BLOCK\n");
+
+	block_program.bind_block("object_data", object_data_binding, sizeof(object_data));
+
+	engine::buffer object_buffer;
+	glBindBuffer(GL_UNIFORM_BUFFER, object_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(object_data), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	engine::vertex_array vao;
+
+	std::vector<benchmark_run> runs;
+	for (auto method : {strategy::uniform, strategy::buffer_sub_data, strategy::mapped_ring})
+		for (int objects : {1, 100, max_objects})
+			runs.push_back({method, objects});
+
+	std::vector<object_data> objects(max_objects);
+	std::vector<engine::uniform_ring::range> ranges(max_objects);
+
+	auto & state = app.state();
+	auto & uniform_buffer = app.uniform_buffer();
+
+	std::size_t current_run = 0;
+	int run_frame = 0;
+	float time = 0.f;
+
+	auto last_frame_start = std::chrono::high_resolution_clock::now();
+
+	app.run([&](float dt)
+	{
+		auto frame_start = std::chrono::high_resolution_clock::now();
+		double frame_ms = std::chrono::duration<double, std::milli>(frame_start - last_frame_start).count();
+		last_frame_start = frame_start;
+
+		time += dt;
+
+		auto & run = runs[current_run];
+
+		// Objects on a grid covering the screen, all of them changing every frame
+		int grid = std::ceil(std::sqrt(float(run.objects)));
+		float cell = 2.f / grid;
+		for (int i = 0; i < run.objects; ++i)
+		{
+			glm::mat4 model(1.f);
+			model = glm::translate(model, {-1.f + cell * (i % grid + 0.5f), -1.f + cell * (i / grid + 0.5f), 0.f});
+			model = glm::rotate(model, time + i, {0.f, 0.f, 1.f});
+			model = glm::scale(model, glm::vec3(cell * 0.4f));
+			objects[i].model = model;
+			objects[i].color = {0.5f + 0.5f * std::sin(time + i), 0.5f, 0.5f + 0.5f * std::cos(time + i), 1.f};
+		}
+
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
+		state.viewport(0, 0, app.width(), app.height());
+		glClearColor(0.f, 0.f, 0.f, 0.f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		state.bind_vertex_array(vao);
+
+		auto submit_start = std::chrono::high_resolution_clock::now();
+
+		switch (run.method)
+		{
+		case strategy::uniform:
+			state.use_program(uniform_program);
+			for (int i = 0; i < run.objects; ++i)
+			{
+				glUniformMatrix4fv(model_location, 1, GL_FALSE, reinterpret_cast<float const *>(&objects[i].model));
+				glUniform4fv(color_location, 1, reinterpret_cast<float const *>(&objects[i].color));
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+			break;
+		case strategy::buffer_sub_data:
+			state.use_program(block_program);
+			glBindBufferBase(GL_UNIFORM_BUFFER, object_data_binding, object_buffer);
+			for (int i = 0; i < run.objects; ++i)
+			{
+				glBindBuffer(GL_UNIFORM_BUFFER, object_buffer);
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(object_data), &objects[i]);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+			break;
+		case strategy::mapped_ring:
+			{
+				state.use_program(block_program);
+				for (int i = 0; i < run.objects; ++i)
+					ranges[i] = uniform_buffer.push(objects[i]);
+				uniform_buffer.flush();
+				for (int i = 0; i < run.objects; ++i)
+				{
+					engine::uniform_ring::bind(object_data_binding, ranges[i]);
+					glDrawArrays(GL_TRIANGLES, 0, 3);
+				}
+			}
+			break;
+		}
+
+		double submit_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - submit_start).count();
+
+		// The time of a frame is only known at the start of the next one
+		if (run_frame > warmup_frames)
+		{
+			run.frame_ms += frame_ms;
+			++run.frames;
+		}
+		if (run_frame >= warmup_frames)
+			run.submit_ms += submit_ms;
+
+		if (++run_frame == warmup_frames + measured_frames)
+		{
+			run_frame = 0;
+			if (++current_run == runs.size())
+				app.quit();
+		}
+	});
+
+	std::cout << "Uniform buffer: " << (uniform_buffer.persistent() ? "persistent mapping" : "glBufferSubData staging")
+		<< ", " << uniform_buffer.stats().stalls << " stalls" << std::endl;
+
+	std::cout << std::left << std::setw(18) << "strategy" << std::right << std::setw(10) << "objects"
+		<< std::setw(14) << "submit ms" << std::setw(14) << "frame ms" << std::setw(16) << "ns per object" << std::endl;
+
+	for (auto const & run : runs)
+	{
+		double submit_ms = run.submit_ms / measured_frames;
+		std::cout << std::left << std::setw(18) << strategy_name(run.method) << std::right << std::setw(10) << run.objects
+			<< std::setw(14) << std::fixed << std::setprecision(4) << submit_ms
+			<< std::setw(14) << (run.frames > 0 ? run.frame_ms / run.frames : 0.0)
+			<< std::setw(16) << std::setprecision(1) << submit_ms * 1e6 / run.objects << std::endl;
+	}
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,369 @@
+#include <engine/application.hpp>
+#include <engine/program.hpp>
+#include <engine/gl.hpp>
+#include <engine/obj.hpp>
+#include <engine/mesh_file.hpp>
+#include <engine/mesh_optimize.hpp>
+#include <engine/normals.hpp>
+#include <engine/vertex_format.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/vector_uint4_sized.hpp>
+#include <glm/ext/vector_int2_sized.hpp>
+
+// Compares vertex layouts for a depth-only pass, the shadow pass of
+// practice9, over meshes made of many copies of bunny.obj:
+//     interleaved float  - position and normal as floats, 24 bytes
+//     split float        - a 12-byte position stream, normals apart
+//     interleaved packed - practice9's quantized position and octahedral
+//                          normal, 12 bytes
+//     split packed       - an 8-byte position stream, normals apart
+// Every layout is stored the way engine::mesh_file lays it out and drawn
+// through a vertex array that only reads the position, as the shadow
+// pass does. The GPU time of the pass is measured with GL_TIME_ELAPSED
+// queries; run with --headless for numbers that do not depend on vsync.
+
+const char shadow_vertex_shader_source[] =
+R"(#version 330 core
+
+uniform mat4 transform;
+
+layout (location = 0) in vec3 in_position;
+
+void main()
+{
+	gl_Position = transform * vec4(in_position, 1.0);
+}
+)";
+
+const char shadow_fragment_shader_source[] =
+R"(#version 330 core
+
+void main()
+{}
+)";
+
+struct vertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+};
+
+struct packed_vertex
+{
+	glm::u16vec4 position;
+	glm::i16vec2 normal;
+};
+
+static_assert(sizeof(packed_vertex) == 12);
+
+struct layout_case
+{
+	char const * name;
+	bool packed;
+	bool split;
+};
+
+layout_case const layouts[]
+{
+	{"interleaved float", false, false},
+	{"split float", false, true},
+	{"interleaved packed", true, false},
+	{"split packed", true, true},
+};
+
+unsigned const copy_counts[] = {64, 400};
+
+struct benchmark_run
+{
+	layout_case layout;
+	unsigned copies;
+
+	std::uint64_t vertices = 0;
+	std::uint64_t triangles = 0;
+	std::uint32_t position_stride = 0;
+	double gpu_ms = 0.0;
+	int frames = 0;
+};
+
+// The bunny in vertex cache order, with its normals
+struct source_mesh
+{
+	std::vector<vertex> vertices;
+	std::vector<std::uint32_t> indices;
+};
+
+source_mesh load_bunny()
+{
+	auto bunny = engine::load_obj(PRACTICE_SOURCE_DIRECTORY "/../practice9/bunny.obj");
+	auto normals = engine::compute_normals(bunny.indices, bunny.positions);
+
+	source_mesh result;
+	result.vertices.resize(bunny.positions.size());
+	for (std::size_t i = 0; i < result.vertices.size(); ++i)
+		result.vertices[i] = {bunny.positions[i], normals[i]};
+	result.indices = std::move(bunny.indices);
+
+	engine::optimize_vertex_cache(result.indices, result.vertices.size());
+	engine::optimize_vertex_fetch(result.vertices, result.indices);
+	return result;
+}
+
+source_mesh make_copies(source_mesh const & source, unsigned copies)
+{
+	unsigned grid = 1;
+	while (grid * grid < copies)
+		++grid;
+
+	source_mesh result;
+	result.vertices.reserve(source.vertices.size() * copies);
+	result.indices.reserve(source.indices.size() * copies);
+	for (unsigned copy = 0; copy < copies; ++copy)
+	{
+		glm::vec3 offset(0.2f * (copy % grid), 0.f, 0.2f * (copy / grid));
+		auto base = static_cast<std::uint32_t>(result.vertices.size());
+		for (auto v : source.vertices)
+		{
+			v.position += offset;
+			result.vertices.push_back(v);
+		}
+		for (auto index : source.indices)
+			result.indices.push_back(index + base);
+	}
+	return result;
+}
+
+// The mesh in one of the layouts, uploaded, with a vertex array for the
+// position alone
+struct gpu_mesh
+{
+	engine::buffer vbo;
+	engine::buffer ebo;
+	engine::vertex_array vao;
+	GLenum index_type;
+	GLsizei index_count;
+	std::uint32_t position_stride;
+	// Dequantizes packed positions
+	glm::mat4 model;
+};
+
+std::unique_ptr<gpu_mesh> upload(source_mesh const & mesh, layout_case const & layout)
+{
+	glm::vec3 min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity());
+	for (auto const & v : mesh.vertices)
+	{
+		min = glm::min(min, v.position);
+		max = glm::max(max, v.position);
+	}
+	engine::position_quantization quantization(min, max);
+
+	engine::mesh_data data;
+	if (layout.packed)
+	{
+		std::vector<packed_vertex> packed(mesh.vertices.size());
+		for (std::size_t i = 0; i < packed.size(); ++i)
+		{
+			packed[i].position = quantization.encode(mesh.vertices[i].position);
+			packed[i].normal = engine::encode_octahedral<std::int16_t>(mesh.vertices[i].normal);
+		}
+		data = engine::mesh_data(packed, mesh.indices, {
+			{0, GL_UNSIGNED_SHORT, 3, GL_TRUE, offsetof(packed_vertex, position)},
+			{1, GL_SHORT, 2, GL_TRUE, offsetof(packed_vertex, normal)},
+		});
+		data.bounds_min = min;
+		data.bounds_max = max;
+	}
+	else
+	{
+		data = engine::mesh_data(mesh.vertices, mesh.indices, {
+			{0, GL_FLOAT, 3, GL_FALSE, offsetof(vertex, position)},
+			{1, GL_FLOAT, 3, GL_FALSE, offsetof(vertex, normal)},
+		});
+	}
+	data.split_positions = layout.split;
+
+	engine::mesh_file file(data);
+
+	auto result = std::make_unique<gpu_mesh>();
+	result->index_type = file.header().index_type;
+	result->index_count = static_cast<GLsizei>(file.header().index_count);
+	result->position_stride = file.position_stride();
+	result->model = layout.packed ? quantization.dequantize() : glm::mat4(1.f);
+
+	glBindVertexArray(result->vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, result->vbo);
+	glBufferData(GL_ARRAY_BUFFER, file.vertices().size(), file.vertices().data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result->ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, file.index_bytes().size(), file.index_bytes().data(), GL_STATIC_DRAW);
+
+	file.setup_position_attribute();
+
+	glBindVertexArray(0);
+	return result;
+}
+
+GLsizei const shadow_map_resolution = 1024;
+
+int const warmup_frames = 10;
+int const measured_frames = 50;
+
+int main(int argc, char ** argv) try
+{
+	std::vector<benchmark_run> runs;
+	for (auto copies : copy_counts)
+		for (auto const & layout : layouts)
+			runs.push_back({layout, copies});
+
+	engine::application app(argc, argv, {
+		.title = "Graphics course vertex stream benchmark",
+		.vsync = false,
+		.frames = static_cast<int>(runs.size()) * (warmup_frames + measured_frames),
+	});
+
+	engine::program shadow_program({
+		{GL_VERTEX_SHADER, shadow_vertex_shader_source},
+		{GL_FRAGMENT_SHADER, shadow_fragment_shader_source},
+	}, app.programs());
+
+	GLint transform_location = shadow_program.uniform_location("transform");
+
+	engine::texture shadow_map;
+	glBindTexture(GL_TEXTURE_2D, shadow_map);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, shadow_map_resolution, shadow_map_resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+	engine::framebuffer shadow_fbo;
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadow_fbo);
+	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map, 0);
+	if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("Incomplete shadow framebuffer");
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	auto bunny = load_bunny();
+
+	source_mesh mesh;
+	std::unique_ptr<gpu_mesh> current;
+	glm::mat4 light_transform(1.f);
+
+	auto & state = app.state();
+
+	std::size_t current_run = 0;
+	int run_frame = 0;
+
+	app.run([&](float)
+	{
+		auto & run = runs[current_run];
+
+		if (run_frame == 0)
+		{
+			if (current_run == 0 || runs[current_run - 1].copies != run.copies)
+			{
+				mesh = make_copies(bunny, run.copies);
+
+				// An orthographic light looking down at the grid at an angle
+				glm::vec3 min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity());
+				for (auto const & v : mesh.vertices)
+				{
+					min = glm::min(min, v.position);
+					max = glm::max(max, v.position);
+				}
+				auto center = (min + max) * 0.5f;
+				float radius = glm::length(max - min) * 0.5f;
+				auto view = glm::lookAt(center + glm::vec3(0.3f, 1.f, 0.5f) * radius, center, {0.f, 0.f, 1.f});
+				light_transform = glm::ortho(-radius, radius, -radius, radius, 0.f, 4.f * radius) * view;
+			}
+
+			// Deletes the bound vertex array, whose name the next one may
+			// reuse, and binds vertex arrays behind the state cache's back
+			current.reset();
+			current = upload(mesh, run.layout);
+			state.invalidate();
+			run.vertices = mesh.vertices.size();
+			run.triangles = mesh.indices.size() / 3;
+			run.position_stride = current->position_stride;
+		}
+
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, shadow_fbo);
+		state.viewport(0, 0, shadow_map_resolution, shadow_map_resolution);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		state.enable(GL_DEPTH_TEST);
+		state.depth_func(GL_LEQUAL);
+		state.enable(GL_CULL_FACE);
+		state.cull_face(GL_BACK);
+
+		glm::mat4 transform = light_transform * current->model;
+
+		state.use_program(shadow_program);
+		glUniformMatrix4fv(transform_location, 1, GL_FALSE, reinterpret_cast<float const *>(&transform));
+		state.bind_vertex_array(current->vao);
+
+		// Read back right away: the stall costs the CPU time, but the
+		// query measures the pass alone either way
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		glDrawElements(GL_TRIANGLES, current->index_count, current->index_type, nullptr);
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+
+		if (run_frame >= warmup_frames)
+		{
+			run.gpu_ms += elapsed_ns / 1e6;
+			++run.frames;
+		}
+
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, app.framebuffer());
+		state.viewport(0, 0, app.width(), app.height());
+		glClearColor(0.f, 0.f, 0.f, 0.f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		if (++run_frame == warmup_frames + measured_frames)
+		{
+			run_frame = 0;
+			if (++current_run == runs.size())
+				app.quit();
+		}
+	});
+
+	current.reset();
+	glDeleteQueries(1, &query);
+
+	std::cout << std::left << std::setw(20) << "layout" << std::right << std::setw(12) << "vertices"
+		<< std::setw(12) << "triangles" << std::setw(17) << "position stride" << std::setw(12) << "GPU ms"
+		<< std::setw(14) << "Mvertices/s" << std::endl;
+
+	for (auto const & run : runs)
+	{
+		double gpu_ms = run.frames > 0 ? run.gpu_ms / run.frames : 0.0;
+		std::cout << std::left << std::setw(20) << run.layout.name << std::right << std::setw(12) << run.vertices
+			<< std::setw(12) << run.triangles << std::setw(17) << run.position_stride
+			<< std::setw(12) << std::fixed << std::setprecision(3) << gpu_ms
+			<< std::setw(14) << std::setprecision(1) << (gpu_ms > 0.0 ? run.vertices / gpu_ms / 1000.0 : 0.0) << std::endl;
+	}
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}